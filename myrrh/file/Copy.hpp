@@ -36,6 +36,9 @@ typedef boost::shared_ptr<PositionScanner> PositionScannerPtr;
  * Thus the logic of determining what to copy is isolated from the logic of
  * actual copying.
  *
+ * The data is copied in chunks of fixed size, so the memory use does not
+ * depend on the size of the range.
+ *
  * @note If you need to copy the entire file, it is much easier to use
  *       boost::filesystem::copy_file.
  */
@@ -65,9 +68,30 @@ public:
      *         scanner is after the scan point from end scanner
      * @throws myrrh::file::PositionScanner::NotOpen, the given input stream
      *         is not open.
+     * @throws myrrh::file::Copy::Incomplete, if the range could not be read
+     *         or written entirely
      */
     void operator( )(std::ifstream &input, std::ofstream &output) const;
 
+    /**
+     * Copies the range defined by start and end scanners from input file to
+     * output file. Any old content of the output file is destroyed. On Linux
+     * the data is copied by the kernel with copy_file_range or sendfile, so
+     * it is never read into the memory of the process.
+     * @param input File from which input is read from
+     * @param output The copying is done into this file
+     * @throws myrrh::file::Copy::StreamNotOpen, if the output file cannot be
+     *         opened.
+     * @throws myrrh::file::Copy::OutOfBounds, if the scan point from start
+     *         scanner is after the scan point from end scanner
+     * @throws myrrh::file::PositionScanner::NotOpen, if the input file cannot
+     *         be opened.
+     * @throws myrrh::file::Copy::Incomplete, if the range could not be read
+     *         or written entirely, for instance because the disk is full
+     */
+    void operator( )(const boost::filesystem::path &input,
+                     const boost::filesystem::path &output) const;
+
     /**
      * Exception class which is thrown, if given output file stream is not open
      */
@@ -90,8 +114,28 @@ public:
         OutOfBounds(const std::string &what);
     };
 
+    /**
+     * Exception class which is thrown, if reading the input or writing the
+     * output fails before the whole range has been copied
+     */
+    class Incomplete : public std::runtime_error
+    {
+    public:
+
+        Incomplete(const std::string &what);
+    };
+
 private:
 
+    /**
+     * Scans the range to be copied from the given stream
+     * @param input The stream to scan
+     * @param start The start of the range
+     * @return The size of the range
+     */
+    std::streamsize ScanRange(std::ifstream &input,
+                              std::streampos &start) const;
+
     PositionScannerPtr startScanner_;
     PositionScannerPtr endScanner_;
 };
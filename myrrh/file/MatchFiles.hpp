@@ -13,7 +13,7 @@
 #ifndef MYRRH_FILE_MATCHFILES_HPP_INCLUDED
 #define MYRRH_FILE_MATCHFILES_HPP_INCLUDED
 
-#include "myrrh/util/CopyIf.hpp"
+#include "myrrh/file/ScanFolder.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/regex.hpp"
 #include <vector>
@@ -23,15 +23,14 @@ namespace myrrh
 namespace file
 {
 
-typedef std::vector<boost::filesystem::path> PathStore;
-
 /**
  * Goes through the files in the given directory and returns the paths to the
  * files that are matched with Matcher predicate. The Matcher must contain
  * an operator( ), which takes a boost::filesystem::path parameter and returns
  * a boolean value. An example is ExpressionMatcher, which can be used in
  * conjunction to this function to find all the files whose file names match
- * a specific regular expression.
+ * a specific regular expression. The folder is read with ScanFolder, which
+ * calls the matcher while the entries are read.
  * @param folder Path to the directory that is used to search the files from.
  * @param matcher A predicate that is used to choose the files
  * @return A storage of the paths of the files chosen from the directory.
@@ -79,11 +78,20 @@ template <typename Matcher>
 inline PathStore MatchFiles(const boost::filesystem::path &folder,
                             Matcher matcher)
 {
-    PathStore result;
+    const EntryStore ENTRIES(ScanFolder(folder,
+        [&](const std::string &name)
+        {
+            return matcher(folder / name);
+        }));
 
-    using namespace boost::filesystem;
-    util::CopyIf(directory_iterator(folder), directory_iterator( ),
-                 std::back_inserter(result), matcher);
+    PathStore result;
+    result.reserve(ENTRIES.size( ));
+    for (EntryStore::const_iterator i = ENTRIES.begin( );
+         ENTRIES.end( ) != i;
+         ++i)
+    {
+        result.push_back(i->path);
+    }
 
     return result;
 }
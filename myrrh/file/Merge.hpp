@@ -0,0 +1,89 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains declaration of class myrrh::file::Merge.
+ */
+
+#ifndef MYRRH_FILE_MERGE_HPP_INCLUDED
+#define MYRRH_FILE_MERGE_HPP_INCLUDED
+
+#include "myrrh/file/MatchFiles.hpp"
+
+#include <functional>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+
+namespace myrrh
+{
+
+namespace file
+{
+
+/**
+ * Merges several line based files, whose content is already ordered, into one
+ * ordered output. The typical use is to combine log files that were written
+ * in parallel (e.g. by myrrh::log::policy::ShardedPolicy) back into one file.
+ *
+ * The order is defined by a key at the beginning of the lines. The key is
+ * located with a function that returns the length of the key for the given
+ * line. Keys are compared as strings, so they must be of fixed width, if they
+ * are numbers. A line for which the function returns 0 does not start a new
+ * record, but continues the preceding one, so multi-line records are kept
+ * together. Records with equal keys are written in the order of the input
+ * files.
+ *
+ * The input files are memory mapped and read sequentially, and the records
+ * are written to the output straight from the mapped memory. Each line is
+ * still copied once into a reused string, because the key function takes a
+ * std::string, and the key of the current record of each file is kept. So
+ * the memory used is mostly the page cache of the operating system. The files
+ * are closed as soon as they are mapped, so hundreds of files can be merged
+ * at once without running out of file handles.
+ */
+class Merge
+{
+public:
+
+    /// Returns the length of the sort key in the given line, 0 if none
+    typedef std::function<std::size_t (const std::string &)> KeyLength;
+
+    /**
+     * Constructor. Does not throw exceptions, except possibly std::bad_alloc.
+     * @param inputs Paths to the files to be merged
+     * @param keyLength Locates the sort key of a line
+     */
+    Merge(const PathStore &inputs, KeyLength keyLength);
+
+    /**
+     * Writes the merged content of the input files into the given stream.
+     * @param output The stream into which the result is written
+     * @throws myrrh::file::Merge::CannotOpen, if any of the input files
+     *         cannot be opened
+     */
+    void operator( )(std::ostream &output) const;
+
+    /**
+     * Exception class which is thrown, if an input file cannot be opened
+     */
+    class CannotOpen : public std::runtime_error
+    {
+    public:
+
+        CannotOpen(const std::string &what);
+    };
+
+private:
+
+    PathStore inputs_;
+    KeyLength keyLength_;
+};
+
+}
+
+}
+
+#endif
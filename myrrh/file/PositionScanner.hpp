@@ -177,6 +177,34 @@ private:
     const std::streamoff BYTES_FROM_END_;
 };
 
+/**
+ * Scans the file stream from end to a specified position and backtracks to
+ * the start of the line containing the position. Unlike with ScanFromEnd, at
+ * least the given amount of bytes is left after the scanned position, unless
+ * the file is shorter.
+ */
+class ScanBackFromEnd : public PositionScanner
+{
+public:
+
+    /**
+     * Constructor
+     * @param bytesFromEnd The point to which the scanning is done.
+     */
+    ScanBackFromEnd(std::streamsize bytesFromEnd);
+
+private:
+
+    virtual std::streampos DoScan(std::ifstream &stream) const;
+
+    /// Disabled copy constructor
+    ScanBackFromEnd(const ScanBackFromEnd &);
+    /// Disabled assignment operator
+    ScanBackFromEnd &operator=(const ScanBackFromEnd &);
+
+    const std::streamoff BYTES_FROM_END_;
+};
+
 }
 }
 
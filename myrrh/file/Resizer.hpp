@@ -65,6 +65,8 @@ public:
      *       during resizing, the original file is left untouched.
      * @throws myrrh::file::PositionScanner::NotOpen, if the file defined in
      *         the constructor does not exist.
+     * @throws myrrh::file::Copy::Incomplete, if the content could not be
+     *         copied entirely. The original file is kept then.
      */
     void operator( )( ) const;
 
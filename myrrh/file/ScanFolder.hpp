@@ -0,0 +1,84 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declarations of functions myrrh::file::ScanFolder
+ * and myrrh::file::ScanFolders.
+ */
+
+#ifndef MYRRH_FILE_SCANFOLDER_HPP_INCLUDED
+#define MYRRH_FILE_SCANFOLDER_HPP_INCLUDED
+
+#include "boost/filesystem/path.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace myrrh
+{
+
+namespace file
+{
+
+typedef std::vector<boost::filesystem::path> PathStore;
+
+/**
+ * An entry found from a folder
+ */
+struct FolderEntry
+{
+    /// The path of the entry, starting with the scanned folder
+    boost::filesystem::path path;
+    /// Tells if the entry is a directory, or a link to one
+    bool isDirectory;
+};
+
+typedef std::vector<FolderEntry> EntryStore;
+
+/**
+ * A predicate that chooses the entries by their names
+ */
+typedef std::function<bool (const std::string &name)> NameMatcher;
+
+/**
+ * Reads the entries of the given folder and returns the ones whose names are
+ * accepted by the matcher, in the order of the directory. The entries '.' and
+ * '..' are skipped.
+ *
+ * On Linux the entries are read in large batches with getdents64 and the
+ * matcher is called while the batch is read. The type of the entry is taken
+ * from the directory entry, so the file needs to be checked with stat only
+ * for symbolic links and on file systems that do not report the types.
+ * Elsewhere boost::filesystem::directory_iterator is used.
+ * @param folder The folder to scan
+ * @param matcher Chooses the entries by their names
+ * @throws boost::filesystem::filesystem_error if the folder cannot be read
+ */
+EntryStore ScanFolder(const boost::filesystem::path &folder,
+                      const NameMatcher &matcher);
+
+/**
+ * Scans several folders, e.g. the dated sibling folders of a log path. The
+ * entries are returned in the order of the folders, as if they were scanned
+ * one after another.
+ * @param folders The folders to scan
+ * @param matcher Chooses the entries by their names. If several threads are
+ *                used, the matcher is called concurrently, so it must be
+ *                thread safe.
+ * @param threads The maximum count of threads scanning the folders. With one
+ *                thread the folders are scanned by the calling thread.
+ * @throws boost::filesystem::filesystem_error if any of the folders cannot be
+ *         read
+ */
+EntryStore ScanFolders(const PathStore &folders, const NameMatcher &matcher,
+                       std::size_t threads = 1);
+
+}
+
+}
+
+#endif
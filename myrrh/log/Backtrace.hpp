@@ -0,0 +1,105 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class myrrh::log::Backtrace.
+ */
+
+#ifndef MYRRH_LOG_BACKTRACE_HPP_INCLUDED
+#define MYRRH_LOG_BACKTRACE_HPP_INCLUDED
+
+#include "myrrh/log/VerbosityLevel.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+/**
+ * Backtrace keeps the latest lines written through Log in memory, so that
+ * they can be written to the output targets once an error occurs. This way
+ * the lines that would normally be too verbose to be written are available
+ * as context for the error. Backtrace is not used directly, but through
+ * Log::AddBacktrace.
+ *
+ * The lines are stored into a ring of pre-allocated slots. Once the ring is
+ * full, the oldest line is overwritten. The slots keep their memory, so after
+ * the ring has been filled once, storing a line allocates memory only if it is
+ * longer than any previous line in the same slot.
+ *
+ * @warning Not thread-safe. Log calls the methods only while it holds its
+ *          writing lock.
+ */
+class Backtrace
+{
+public:
+
+    /// Called for each stored line in Flush
+    typedef std::function<void (const std::string &, VerbosityLevel)> Visitor;
+
+    /**
+     * Constructor. Allocates the memory for all of the slots.
+     * @param size The count of lines kept in memory. It is considered a
+     *             programming error to pass 0.
+     * @param capture The most verbose level that is kept in memory
+     * @param trigger The least severe level that causes the lines to be
+     *                flushed
+     * @throws std::bad_alloc, if there is not enough memory
+     */
+    Backtrace(std::size_t size, VerbosityLevel capture,
+              VerbosityLevel trigger);
+
+    /**
+     * Tells whether lines of the given level are kept in memory
+     */
+    bool IsCaptured(VerbosityLevel verbosity) const;
+
+    /**
+     * Tells whether lines of the given level cause the stored lines to be
+     * flushed
+     */
+    bool IsTrigger(VerbosityLevel verbosity) const;
+
+    /**
+     * Stores the line, overwriting the oldest line if the ring is full. Lines
+     * that are not captured are ignored.
+     * @throws std::bad_alloc, if the line is longer than the memory of the slot
+     *         and there is not enough memory to grow it
+     */
+    void Store(const std::string &line, VerbosityLevel verbosity);
+
+    /**
+     * Passes the stored lines to the visitor starting from the oldest one and
+     * empties the ring.
+     */
+    void Flush(Visitor visitor);
+
+private:
+
+    struct Slot
+    {
+        std::string line;
+        VerbosityLevel verbosity;
+    };
+
+    std::vector<Slot> slots_;
+    /// The slot into which the next line is stored
+    std::size_t next_;
+    /// The count of lines stored since the last flush, at most slots_.size( )
+    std::size_t count_;
+    VerbosityLevel capture_;
+    VerbosityLevel trigger_;
+};
+
+}
+
+}
+
+#endif
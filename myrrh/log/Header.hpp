@@ -4,8 +4,8 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 
 /**
- * This file contains the declaration of classes Header and TimestampHeader in
- * namespace myrrh::log.
+ * This file contains the declaration of classes Header and TimestampHeader and
+ * function TimestampKey in namespace myrrh::log.
  *
  * $Id: Header.hpp 355 2007-09-17 18:48:35Z byon $
  */
@@ -13,8 +13,10 @@
 #ifndef MYRRH_LOG_HEADER_HPP_INCLUDED
 #define MYRRH_LOG_HEADER_HPP_INCLUDED
 
+#include <functional>
 #include <iosfwd>
 #include <memory>
+#include <string>
 
 namespace myrrh
 {
@@ -74,6 +76,15 @@ public:
     virtual void Write(std::ostream &stream, char id);
 };
 
+/**
+ * Returns a function that can be passed to myrrh::file::Merge for merging log
+ * files, whose lines start with the header written by TimestampHeader. The
+ * function returns the length of the timestamp for lines that start with one
+ * and 0 for the rest. The timestamps are of fixed width, so they are ordered
+ * correctly, when compared as strings.
+ */
+std::function<std::size_t (const std::string &)> TimestampKey( );
+
 }
 
 }
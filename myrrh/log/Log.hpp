@@ -8,7 +8,11 @@
 
 // Isolate the implementation better
 #include "myrrh/log/Header.hpp"
+#include "myrrh/log/VerbosityLevel.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/shared_ptr.hpp"
 #include "boost/thread/mutex.hpp"
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -18,25 +22,8 @@ namespace myrrh
 namespace log
 {
 
-// Do not undef on header files, find some other way
-#undef ERROR
-
-/**
- * Enum VerbosityLevel defines the numeric levels of verbosity. They resemble
- * the verbosity levels of UNIX syslog facility with the exception of TRACE,
- * which is an additional level, which gets printed only in debug builds.
- */
-enum VerbosityLevel
-{
-    // Why starting from 2?
-    CRIT = 2,
-    ERROR,
-    WARN,
-    NOTIFY,
-    INFO,
-    DEBUG,
-    TRACE
-};
+class Backtrace;
+class RepeatFilter;
 
 /**
  * Class Log is a singleton class that is used for centralized output of an
@@ -213,7 +200,9 @@ public:
     static Log &Instance( );
 
     /**
-     * Adds a new Output stream for the Log's Output targets.
+     * Adds a new Output stream for the Log's Output targets. If the stream
+     * buffer of the target implements VerbosityAware, it is told the
+     * verbosity level of each line before the line is written.
      * @note The caller must test the usability of the output target stream,
      *       before it is passed into this method. The log writing is
      *       implemented with a no-throw guarantee, so that it can be done
@@ -234,6 +223,53 @@ public:
     OutputGuard AddOutputTarget(std::ostream &target,
                                 VerbosityLevel verbosity = TRACE);
 
+    /**
+     * Adds a new Output stream for the Log's Output targets, with suppression
+     * of repeated lines. Consecutive lines with identical content (the header
+     * is not compared) are written only once, followed by a line telling
+     * "last message repeated N times". The repeats are collapsed only within
+     * the given time window, counted from the first occurrence, so that the
+     * output of a long lasting failure is not hidden entirely. Otherwise as
+     * the overload above.
+     * @param target The output stream to be added
+     * @param verbosity Tightens the amount of output for this output target
+     * @param repeatWindow The time during which the repeats are collapsed
+     * @return A new OutputGuard object. When the object gets destructed, a
+     *         possible pending summary is written and the output stream is
+     *         removed from Log's output targets.
+     * @warning Not thread-safe!
+     */
+    OutputGuard AddOutputTarget(
+        std::ostream &target, VerbosityLevel verbosity,
+        const boost::posix_time::time_duration &repeatWindow);
+
+    /**
+     * Starts keeping the latest lines in memory without writing them
+     * anywhere, so that they can be written as context once an error occurs.
+     * The lines are captured up to the given level, even if the global
+     * verbosity level or the verbosity levels of the output targets are
+     * tighter. When a line at the trigger level or more severe is written,
+     * the lines in memory are first written to each output target that did
+     * not receive them already, and then the memory is emptied. The lines
+     * keep their original headers, so their time and level can be told apart
+     * from the line that caused the flushing.
+     *
+     * The memory for the lines is allocated in advance, so the cost of
+     * capturing is mostly the formatting of the lines.
+     * @note In release builds TRACE lines are not written at all, so they
+     *       cannot be captured either.
+     * @param size The count of the latest lines kept in memory. Must not be 0.
+     * @param capture The most verbose level that is kept in memory
+     * @param trigger The least severe level that causes the flushing
+     * @return A new OutputGuard object. When the object gets destructed, the
+     *         lines are no longer kept in memory. Only one backtrace can be in
+     *         use at a time, so calling this again replaces the previous one.
+     * @throws std::bad_alloc, if there is not enough memory for the lines
+     * @warning Not thread-safe!
+     */
+    OutputGuard AddBacktrace(std::size_t size, VerbosityLevel capture = TRACE,
+                             VerbosityLevel trigger = ERROR);
+
     /**
      * Removes all of the output targets from log.
      * @warning Not thread-safe!
@@ -306,6 +342,28 @@ private:
      */
     void Write(VerbosityLevel verbosity);
 
+    /**
+     * Checks if the lines of given verbosity level need to be formatted,
+     * either for writing or for capturing them into the backtrace.
+     */
+    bool IsAccepted(VerbosityLevel verbosity) const;
+
+    /**
+     * Writes the lines of the backtrace to the targets that have not
+     * received them.
+     */
+    void FlushBacktrace( );
+
+    /**
+     * Writes the line to those targets, whose verbosity level allows it.
+     */
+    void WriteToTargets(const std::string &line, VerbosityLevel verbosity);
+
+    /**
+     * Ends the current run of repeats of the target and writes the summary.
+     */
+    void EndRepeats(std::ostream &target);
+
     Log(const Log &);
     const Log &operator=(const Log &);
 
@@ -317,12 +375,20 @@ private:
     volatile VerbosityLevel verbosity_;
     /** Line that is currently being written containing the header */
     std::ostringstream line_;
+    /** The count of characters in the header of line_ */
+    std::size_t headerLength_;
     /** Mutex that guards concurrent writing access */
     // The mutex is now global to all. Wouldn't it be better, if it was
     // specific to one output target?
     boost::mutex mutex_;
     /** Knows how to write the header of each line */
     HeaderPtr header_;
+    /** Keeps the latest lines in memory, may be null */
+    boost::shared_ptr<Backtrace> backtrace_;
+    typedef std::map<std::streambuf *, boost::shared_ptr<RepeatFilter> >
+        RepeatFilters;
+    /** The repeat suppression of those targets that use it */
+    RepeatFilters repeatFilters_;
 };
 
 // Type definitions for uniform verbosity usage. The user should use these,
@@ -390,7 +456,7 @@ Log::Verbosity<Limit, Id>::operator<<(
 template <VerbosityLevel Limit, char Id>
 inline boost::mutex::scoped_lock *Log::Verbosity<Limit, Id>::GetLock( )
 {
-    if (Log::Instance( ).IsWritable(Limit))
+    if (Log::Instance( ).IsAccepted(Limit))
     {
         // Using the nothrow version of new, because we have a nothrow
         // guarantee in the Verbosity constructor, where this method is called.
@@ -0,0 +1,130 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class myrrh::log::RepeatFilter.
+ */
+
+#ifndef MYRRH_LOG_REPEATFILTER_HPP_INCLUDED
+#define MYRRH_LOG_REPEATFILTER_HPP_INCLUDED
+
+#include "myrrh/log/VerbosityLevel.hpp"
+
+#include "boost/cstdint.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+#include <string>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+/**
+ * RepeatFilter collapses consecutive lines with identical payloads into one
+ * line and a summary of the count of repeats, in the manner of syslog's "last
+ * message repeated N times". The payload is the part of the line after the
+ * header, so the lines differing only by their timestamps are considered
+ * equal. RepeatFilter is not used directly, but through
+ * Log::AddOutputTarget.
+ *
+ * The payloads are first compared by their length and a 64-bit hash, so
+ * that the differing lines are told apart cheaply. Only when those match, the
+ * payload is compared to the one of the current run, so a hash collision
+ * never drops a line. The payload is copied once per run, not once per line.
+ *
+ * The repeats are collapsed only within the given time window, counted from
+ * the first occurrence of the payload. Once the window has passed, the
+ * summary is written and the next repeat is written as a new first
+ * occurrence. This way a tight loop of failures still shows up in the output
+ * regularly.
+ *
+ * The summary is given the header and the verbosity level of the latest
+ * repeat, so it is written to the same targets as the repeats were.
+ *
+ * @warning Not thread-safe. Log calls the methods only while it holds its
+ *          writing lock.
+ */
+class RepeatFilter
+{
+public:
+
+    typedef boost::posix_time::ptime Time;
+
+    /**
+     * The summary line of a run of repeats
+     */
+    struct Summary
+    {
+        Summary( );
+
+        /// Empty, if there were no repeats
+        std::string line;
+        /// The level of the latest repeat
+        VerbosityLevel verbosity;
+    };
+
+    /**
+     * Constructor
+     * @param window The time during which the repeats are collapsed
+     */
+    explicit RepeatFilter(const boost::posix_time::time_duration &window);
+
+    /**
+     * Calculates the hash of the payload of the given line, without copying
+     * it.
+     * @param line The line containing the header
+     * @param headerLength The count of characters in the header
+     */
+    static boost::uint64_t Hash(const std::string &line,
+                                std::size_t headerLength);
+
+    /**
+     * Checks whether the line repeats the previous one.
+     * @param line The line containing the header
+     * @param headerLength The count of characters in the header
+     * @param hash The hash of the payload, as returned by Hash
+     * @param verbosity The verbosity level of the line
+     * @param now The current time
+     * @param summary If the line ends a run of repeats, the summary is
+     *                stored here. Otherwise its line is emptied.
+     * @return true if the line is a repeat and must not be written
+     * @throws std::bad_alloc, if there is not enough memory for the summary
+     */
+    bool IsRepeat(const std::string &line, std::size_t headerLength,
+                  boost::uint64_t hash, VerbosityLevel verbosity,
+                  const Time &now, Summary &summary);
+
+    /**
+     * Ends the current run of repeats.
+     * @param summary If there were repeats, the summary is stored here.
+     *                Otherwise its line is emptied.
+     * @throws std::bad_alloc, if there is not enough memory for the summary
+     */
+    void EndRun(Summary &summary);
+
+private:
+
+    boost::posix_time::time_duration window_;
+    bool hasPrevious_;
+    boost::uint64_t hash_;
+    /// The payload of the current run
+    std::string payload_;
+    /// The time of the first occurrence of the payload
+    Time start_;
+    /// The count of repeats that were not written
+    std::size_t repeats_;
+    /// The header of the latest repeat, used for the summary line
+    std::string header_;
+    /// The level of the latest repeat, used for the summary line
+    VerbosityLevel verbosity_;
+};
+
+}
+
+}
+
+#endif
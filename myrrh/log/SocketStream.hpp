@@ -0,0 +1,188 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of classes myrrh::log::SocketBuffer and
+ * myrrh::log::SocketStream.
+ *
+ * @note Only available on Linux.
+ */
+
+#ifndef MYRRH_LOG_SOCKETSTREAM_HPP_INCLUDED
+#define MYRRH_LOG_SOCKETSTREAM_HPP_INCLUDED
+
+#include "myrrh/util/BufferedStream.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include <ostream>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+/**
+ * SocketBuffer sends the written lines to a local log collector through a Unix
+ * domain socket. It is not designed to be usable by itself, but through
+ * SocketStream.
+ *
+ * Each line is framed by terminating it with a line feed, if it is not
+ * already. The lines are collected into batches, which are sent by a
+ * background thread. A batch is sent when it has grown to the batch size or
+ * when the flush interval has passed. With datagram sockets each batch is
+ * sent as one datagram, so the batch size must not exceed the maximum
+ * datagram size of the collector.
+ *
+ * The writing thread never waits for the socket, it only appends the line to
+ * the current batch. If the collector cannot keep up, at most
+ * MAX_QUEUED_BATCHES batches are kept in memory and the lines that do not fit
+ * are dropped. If the connection is lost, the background thread reconnects
+ * to the socket path once per flush interval and sends the queued batches
+ * once the collector is available again. The lines that were already sent
+ * on a lost stream connection are not sent again, and a line that was only
+ * partly sent is dropped, so each new connection starts at a line boundary.
+ * The count of dropped lines can be queried with Dropped( ).
+ */
+class SocketBuffer : public util::BufferedStream
+{
+public:
+
+    /**
+     * The type of the socket
+     */
+    enum Type
+    {
+        STREAM,  ///< SOCK_STREAM, the lines are a continuous stream
+        DATAGRAM ///< SOCK_DGRAM, each batch is one datagram
+    };
+
+    /// The default maximum size of one batch in bytes
+    static const std::size_t DEFAULT_BATCH_SIZE = 4096;
+    /// The default time after which an incomplete batch is sent
+    static const unsigned int DEFAULT_FLUSH_MILLISECONDS = 100;
+    /// The count of full batches that are kept in memory at most
+    static const std::size_t MAX_QUEUED_BATCHES = 64;
+
+    /**
+     * Constructor. The connecting is done by the background thread, so the
+     * collector does not need to be running yet.
+     * @param path The path of the socket of the collector
+     * @param type The type of the socket
+     * @param batchSize The maximum size of one batch in bytes
+     * @param flushMilliseconds The time after which an incomplete batch is
+     *                          sent, and the interval of reconnecting
+     * @throws boost::thread_resource_error, if the background thread cannot
+     *         be started
+     */
+    explicit SocketBuffer(const std::string &path, Type type = STREAM,
+                          std::size_t batchSize = DEFAULT_BATCH_SIZE,
+                          unsigned int flushMilliseconds =
+                              DEFAULT_FLUSH_MILLISECONDS);
+
+    /**
+     * Constructor, which takes the ownership of an already connected socket,
+     * e.g. one end of a socketpair. Because the path is not known, the
+     * lines are dropped once the connection is lost.
+     * @param descriptor The connected socket, closed at destruction
+     * @param type The type of the socket
+     * @param batchSize The maximum size of one batch in bytes
+     * @param flushMilliseconds The time after which an incomplete batch is
+     *                          sent
+     * @throws boost::thread_resource_error, if the background thread cannot
+     *         be started
+     */
+    SocketBuffer(int descriptor, Type type,
+                 std::size_t batchSize = DEFAULT_BATCH_SIZE,
+                 unsigned int flushMilliseconds = DEFAULT_FLUSH_MILLISECONDS);
+
+    /**
+     * Destructor. Sends the remaining lines, if the collector accepts them
+     * within one flush interval, and stops the background thread.
+     */
+    virtual ~SocketBuffer( );
+
+    /**
+     * Returns the count of lines that have been dropped, because the queue
+     * was full or the connection could not be restored.
+     */
+    std::size_t Dropped( ) const;
+
+private:
+
+    /**
+     * Adds the buffer to the current batch. Never waits for the socket.
+     * @return Always 0, the dropped lines are counted instead, so that they
+     *         do not accumulate into the buffer.
+     */
+    virtual int SyncImpl( );
+
+    /// Prevent copying
+    SocketBuffer(const SocketBuffer &);
+    /// Prevent assignment
+    SocketBuffer &operator=(const SocketBuffer &);
+
+    class Implementation;
+
+    boost::shared_ptr<Implementation> implementation_;
+};
+
+/**
+ * SocketStream is an std::ostream that writes to a local log collector
+ * through SocketBuffer. It can be used as an output target of Log, or in
+ * place of myrrh::log::policy::Stream, when the logs are collected
+ * centrally instead of written into files.
+ *
+ * Example of usage:
+ * @code
+ *   using namespace myrrh::log;
+ *   SocketStream stream("/var/run/collector.sock", SocketBuffer::DATAGRAM);
+ *   Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+ *   Info( ) << "output with some integers " << 11 << 22  << " in between";
+ * @endcode
+ */
+class SocketStream : public std::ostream
+{
+public:
+
+    /**
+     * Constructor. @see SocketBuffer
+     */
+    explicit SocketStream(const std::string &path,
+                          SocketBuffer::Type type = SocketBuffer::STREAM,
+                          std::size_t batchSize =
+                              SocketBuffer::DEFAULT_BATCH_SIZE,
+                          unsigned int flushMilliseconds =
+                              SocketBuffer::DEFAULT_FLUSH_MILLISECONDS);
+
+    /**
+     * Constructor, which takes the ownership of an already connected socket.
+     * @see SocketBuffer
+     */
+    SocketStream(int descriptor, SocketBuffer::Type type,
+                 std::size_t batchSize = SocketBuffer::DEFAULT_BATCH_SIZE,
+                 unsigned int flushMilliseconds =
+                     SocketBuffer::DEFAULT_FLUSH_MILLISECONDS);
+
+    /**
+     * Returns the count of dropped lines. @see SocketBuffer::Dropped
+     */
+    std::size_t Dropped( ) const;
+
+private:
+
+    SocketBuffer buffer_;
+
+    /// Prevent copying
+    SocketStream(const SocketStream &);
+    /// Prevent assignment
+    SocketStream &operator=(const SocketStream &);
+};
+
+}
+
+}
+
+#endif
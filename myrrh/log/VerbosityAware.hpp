@@ -0,0 +1,54 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class myrrh::log::VerbosityAware.
+ */
+
+#ifndef MYRRH_LOG_VERBOSITYAWARE_HPP_INCLUDED
+#define MYRRH_LOG_VERBOSITYAWARE_HPP_INCLUDED
+
+#include "myrrh/log/VerbosityLevel.hpp"
+
+namespace myrrh
+{
+
+namespace log
+{
+
+/**
+ * VerbosityAware is an interface for the stream buffers of output targets
+ * that need to know the verbosity level of the lines written into them. When
+ * the stream buffer of an output target implements the interface, Log tells
+ * it the level of each line before writing the line. The lines that have no
+ * level of their own, like the summaries of repeated lines, are written
+ * without telling the level.
+ *
+ * See myrrh::log::policy::Buffer, which passes the level on to the policy.
+ */
+class VerbosityAware
+{
+public:
+
+    /**
+     * Destructor
+     */
+    virtual ~VerbosityAware( )
+    {
+    }
+
+    /**
+     * Tells the verbosity level of the line that is written next. The level
+     * applies only until the line is synchronized.
+     * Must provide no-throw guarantee.
+     */
+    virtual void SetVerbosity(VerbosityLevel verbosity) = 0;
+};
+
+}
+
+}
+
+#endif
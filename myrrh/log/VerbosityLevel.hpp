@@ -0,0 +1,43 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of enum myrrh::log::VerbosityLevel.
+ */
+
+#ifndef MYRRH_LOG_VERBOSITYLEVEL_HPP_INCLUDED
+#define MYRRH_LOG_VERBOSITYLEVEL_HPP_INCLUDED
+
+namespace myrrh
+{
+
+namespace log
+{
+
+// Do not undef on header files, find some other way
+#undef ERROR
+
+/**
+ * Enum VerbosityLevel defines the numeric levels of verbosity. They resemble
+ * the verbosity levels of UNIX syslog facility with the exception of TRACE,
+ * which is an additional level, which gets printed only in debug builds.
+ */
+enum VerbosityLevel
+{
+    // Why starting from 2?
+    CRIT = 2,
+    ERROR,
+    WARN,
+    NOTIFY,
+    INFO,
+    DEBUG,
+    TRACE
+};
+
+}
+
+}
+
+#endif
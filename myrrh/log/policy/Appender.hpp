@@ -14,6 +14,8 @@
 
 #include "myrrh/log/policy/Opener.hpp"
 
+#include <string>
+
 namespace boost { namespace filesystem { class path; } }
 
 namespace myrrh
@@ -34,15 +36,45 @@ class Path;
  * Because Appender is a subclass of InitialOpener (in contrast to Opener), it
  * can be used in the context of myrrh::log::policy to do the initial opening
  * of the log file.
+ *
+ * On opening, the latest existing file is searched from the folders defined
+ * by the path. If a Manifest has been set with SetManifest, the file recorded
+ * in it is used instead, as long as the folders have not been modified.
+ *
+ * With SHARED the log files can be written by several processes at once,
+ * e.g. by the processes of a prefork server. Each line is then written with
+ * one O_APPEND write, so the lines of the processes are never mixed, and the
+ * restrictions see the size of the file including the lines of the other
+ * processes (@see Opener::SetShared). Nothing is locked for the lines. The
+ * rotation is coordinated with an advisory lock of a lock file in the parent
+ * folder of the path: the first process to which the restrictions apply
+ * starts the next file, and the others append to it. For this the same
+ * Appender object must be used as both the initial and the subsequent
+ * opener:
+ * @code
+ *   InitialOpenerPtr opener(new Appender(Appender::SHARED));
+ *   Policy policy(path, opener, opener);
+ *   policy.AddRestriction(RestrictionPtr(new SizeRestriction(MAX_SIZE)));
+ * @endcode
+ * A Manifest is not used for the shared files, as the other processes would
+ * not update it. Shared files are only supported with the raw descriptors.
  */
 class Appender : public InitialOpener
 {
 public:
 
+    /// Tells if the files are written by other processes as well
+    enum Sharing
+    {
+        EXCLUSIVE,
+        SHARED
+    };
+
     /**
      * Constructor
+     * @param sharing Tells if the files are shared by several processes
      */
-    Appender( );
+    explicit Appender(Sharing sharing = EXCLUSIVE);
 
 private:
 
@@ -53,10 +85,31 @@ private:
      */
     virtual boost::filesystem::path DoOpen(std::filebuf &file, Path& path);
 
+    /**
+     * Implements the opening as a raw descriptor. Provides no-throw
+     * guarantee.
+     * @param descriptor The opened descriptor
+     * @param path The rules for locating the file
+     * @param opened The path of the file opened
+     */
+    virtual bool DoOpenDescriptor(int &descriptor, Path &path,
+                                  boost::filesystem::path &opened);
+
+    /**
+     * Opens the latest file, or the next one if the latest has been opened
+     * by this object before, while holding the lock of the parent folder
+     */
+    void OpenShared(int &descriptor, Path &path,
+                    boost::filesystem::path &opened);
+
     /// Disabled copy constructor
     Appender(const Appender &);
     /// Disabled assignment operator
     Appender &operator=(const Appender &);
+
+    const Sharing SHARING_;
+    /// The path of the shared file opened last
+    std::string previous_;
 };
 
 }
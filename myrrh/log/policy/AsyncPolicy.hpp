@@ -0,0 +1,135 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains declaration of class myrrh::log::policy::AsyncPolicy
+ */
+
+#ifndef MYRRH_LOG_POLICY_ASYNCPOLICY_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_ASYNCPOLICY_HPP_INCLUDED
+
+#include "myrrh/log/policy/Policy.hpp"
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+/**
+ * AsyncPolicy moves the writing of another Policy object to a background
+ * thread. The written texts are put into a bounded queue, from which the
+ * thread passes them to the wrapped policy in the order they were written.
+ * Thus the restrictions, the opening of the next files and the work of the
+ * openers (like the copying done by Resizer) are done by the background
+ * thread, and the writers only wait for the queue:
+ * @code
+ *   using namespace myrrh::log::policy;
+ *   PolicyPtr policy(new AsyncPolicy(SizeRestrictedLog(path, maxSize)));
+ *   Stream stream(policy);
+ * @endcode
+ *
+ * Once the queue is full, the writers either wait for the thread to make room
+ * or drop the text, depending on the given Overflow. As the texts are written
+ * later, Write only reports whether the text was queued: it returns the size
+ * of a queued text, 0 for a dropped one and -1, if the text could not be
+ * copied. The dropped texts are counted by GetDropCount, and the texts that
+ * the wrapped policy fails to write by GetFailureCount.
+ *
+ * The restrictions added to AsyncPolicy are queued as well, so they are added
+ * to the wrapped policy between the same texts they were added between. The
+ * verbosity levels of the texts are kept as well, so a Router can be wrapped
+ * for moving the writing of all of its destinations to the background. The
+ * wrapped policy must not be written through other means.
+ */
+class AsyncPolicy : public Policy
+{
+public:
+
+    /**
+     * Tells what the writers do once the queue is full
+     */
+    enum Overflow
+    {
+        /// The writers wait for the background thread to make room
+        BLOCK,
+        /// The texts that do not fit are dropped
+        DROP
+    };
+
+    /// The default maximum of the total size of the queued texts
+    static const std::size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+    /**
+     * Constructor
+     * @param policy The policy written by the background thread
+     * @param capacity The maximum of the total size of the queued texts. A
+     *                 longer text is accepted, if the queue is empty.
+     * @param overflow Tells what the writers do once the queue is full
+     * @throws boost::thread_resource_error, if the thread cannot be started
+     */
+    explicit AsyncPolicy(PolicyPtr policy,
+                         std::size_t capacity = DEFAULT_CAPACITY,
+                         Overflow overflow = BLOCK);
+
+    /**
+     * Destructor. The queued texts are written before the thread is stopped.
+     */
+    virtual ~AsyncPolicy( );
+
+    /**
+     * Waits until the texts queued before are written.
+     * Provides no-throw guarantee.
+     */
+    void Flush( );
+
+    /**
+     * Returns the count of the texts dropped, because the queue was full.
+     * Provides no-throw guarantee.
+     */
+    std::size_t GetDropCount( ) const;
+
+    /**
+     * Returns the count of the texts that the wrapped policy failed to write.
+     * Provides no-throw guarantee.
+     */
+    std::size_t GetFailureCount( ) const;
+
+private:
+
+    /**
+     * Queues the restriction to be added to the wrapped policy
+     */
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+
+    /**
+     * Queues the text to be written by the background thread.
+     * @return The size of the text, if it was queued, 0 if it was dropped,
+     *         otherwise -1
+     */
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    /**
+     * Queues the text to be written with its verbosity level
+     * @return Like DoWrite
+     */
+    virtual std::streamsize DoWriteWithLevel(const std::string &toWrite,
+                                             VerbosityLevel verbosity);
+
+    class Queue;
+
+    boost::shared_ptr<Queue> queue_;
+};
+
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class
+ * myrrh::log::policy::Compressor.
+ */
+
+#ifndef MYRRH_LOG_POLICY_COMPRESSOR_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_COMPRESSOR_HPP_INCLUDED
+
+#include "myrrh/log/policy/PathEntity.hpp"
+
+#include "boost/shared_ptr.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace boost { namespace filesystem { class path; } }
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+/**
+ * Compressor compresses the log files that the policy has closed. Once a
+ * policy has moved on to a new file (e.g. with Creator), the previous file is
+ * not written to anymore. The closed files are compressed by a pool of
+ * background threads into gzip format. The compressed file is first written
+ * with a temporary name and then renamed to the name of the original file
+ * followed by SUFFIX, after which the original file is removed. Thus a file
+ * with the compressed name is always complete.
+ *
+ * The compressor is attached to a policy with Policy::SetCompressor:
+ * @code
+ *   CompressorPtr compressor(new Compressor(2));
+ *   policy.SetCompressor(compressor);
+ * @endcode
+ *
+ * Appender and Retention understand the compressed names. Appender does not
+ * append to a compressed file, but starts a new one, if the latest file has
+ * been compressed.
+ *
+ * The files must not be compressed if the policy may open them again, as is
+ * the case with Appender or Resizer as subsequent opener. The policy only
+ * reports the files whose path differs from the next one.
+ */
+class Compressor
+{
+public:
+
+    /// The suffix appended to the names of the compressed files
+    static const std::string SUFFIX;
+
+    /**
+     * Constructor
+     * @param threads The count of threads compressing the files
+     * @throws boost::thread_resource_error, if the threads cannot be started
+     */
+    explicit Compressor(std::size_t threads = 1);
+
+    /**
+     * Destructor. The files reported before are compressed before the
+     * threads are stopped.
+     */
+    ~Compressor( );
+
+    /**
+     * Reports that the policy has closed the file, so it can be compressed.
+     * Provides a no-throw guarantee.
+     * @param file The closed file
+     */
+    void Closed(const boost::filesystem::path &file);
+
+    /**
+     * Compresses the given file in the calling thread
+     * @param file The file to compress
+     * @return false, if the file could not be compressed, or if a compressed
+     *         file with the same name exists. In that case the original file
+     *         is left in place.
+     */
+    static bool Compress(const boost::filesystem::path &file);
+
+    /**
+     * Tells if the name ends with SUFFIX
+     */
+    static bool IsCompressed(const std::string &name);
+
+    /**
+     * Parses the name with the entity like Path::Entity::Parse does. If the
+     * name does not match, but the name without SUFFIX does, the name is
+     * parsed as a compressed file.
+     * @param entity The entity of the file names
+     * @param name The name to parse
+     * @param key Receives the sort key, if the name matches
+     * @return false, if neither of the names matches
+     */
+    static bool Parse(const Path::Entity &entity, const std::string &name,
+                      Path::Entity::Key &key);
+
+private:
+
+    Compressor(const Compressor &);
+    Compressor &operator=(const Compressor &);
+
+    class Implementation;
+
+    boost::shared_ptr<Implementation> implementation_;
+};
+
+typedef boost::shared_ptr<Compressor> CompressorPtr;
+
+}
+
+}
+
+}
+
+#endif
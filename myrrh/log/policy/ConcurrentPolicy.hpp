@@ -0,0 +1,103 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains declaration of class
+ * myrrh::log::policy::ConcurrentPolicy
+ */
+
+#ifndef MYRRH_LOG_POLICY_CONCURRENTPOLICY_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_CONCURRENTPOLICY_HPP_INCLUDED
+
+#include "myrrh/log/policy/Policy.hpp"
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+/**
+ * ConcurrentPolicy can be written by several threads at once without any
+ * external locking. Unlike ShardedPolicy, all the threads write into the same
+ * file.
+ *
+ * Each write reserves a range of the current file by atomically advancing
+ * the offset of the next write, and then writes the text into the range with
+ * pwrite. The threads only wait for each other when the file is rotated. The
+ * rotation is checked with the limits published by the restrictions (@see
+ * Restriction::GetLimits): a reservation crossing the byte budget starts the
+ * next file, and after the deadline the restrictions are evaluated under a
+ * lock.
+ *
+ * Each file belongs to an epoch. The writers enter the current epoch before
+ * reserving and leave it after writing. A rotation opens the next file,
+ * starts a new epoch with it and waits for the writers of the previous epoch
+ * to leave before closing the previous file. Thus the writes in flight always
+ * finish in the file they reserved their range from, and no range is left
+ * unwritten in the middle of a file.
+ *
+ * The files are written with pwrite only if the opener opens them as raw
+ * descriptors (like Creator and Appender do) and all of the restrictions
+ * publish limits. Otherwise the writes are serialized with a lock, as if the
+ * Policy was shared through myrrh::log::Log.
+ *
+ * Restrictions can be added while writing. Adding a restriction that
+ * publishes no limits starts the next file right away, as the writes into
+ * the current file would not be checked against it.
+ *
+ * @note Retention, compression and opening ahead are not supported.
+ */
+class ConcurrentPolicy : public Policy
+{
+public:
+
+    /**
+     * Constructor.
+     * @param path Contains the rules, which describe how to locate and name
+     *             the log files
+     * @param initialOpener Contains an object that knows how to open the
+     *                      initial file for writing
+     * @param subsequentOpener Contains an object that knows how to open a
+     *                         file once the restrictions require it. It must
+     *                         be an InitialOpener, because the next file is
+     *                         opened while the previous one is still written.
+     */
+    ConcurrentPolicy(Path path, InitialOpenerPtr initialOpener,
+                     InitialOpenerPtr subsequentOpener);
+
+    /**
+     * Destructor
+     */
+    virtual ~ConcurrentPolicy( );
+
+private:
+
+    /**
+     * Adds the restriction and lowers the limits of the current file with it
+     */
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+
+    /**
+     * Writes the text into a range reserved from the current file. Can be
+     * called by several threads at once.
+     */
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    class Epochs;
+
+    boost::shared_ptr<Epochs> epochs_;
+};
+
+}
+
+}
+
+}
+
+#endif
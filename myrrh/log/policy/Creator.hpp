@@ -24,6 +24,9 @@ namespace policy
 {
 
 class Path;
+class Retention;
+
+typedef boost::shared_ptr<Retention> RetentionPtr;
 
 /**
  * Creator class is used in the myrrh::log::policy library to open a file
@@ -31,6 +34,21 @@ class Path;
  * Because Creator is a subclass of InitialOpener (in contrast to Opener), it
  * can be used in the context of myrrh::log::policy to do the initial opening
  * of the log file.
+ *
+ * When the log files are rotated often, the file system spends much of its
+ * time on creating and removing files and on allocating their space. Creator
+ * can avoid that with preallocation (@see Opener::SetPreallocation) and by
+ * recycling the files that Retention would remove:
+ * @code
+ *   RetentionPtr retention(new Retention(path));
+ *   retention->SetMaxCount(10);
+ *   boost::shared_ptr<Creator> creator(new Creator);
+ *   creator->SetPreallocation(MAX_SIZE);
+ *   creator->SetRecycling(retention);
+ *   Policy policy(path, creator, creator);
+ *   policy.AddRestriction(RestrictionPtr(new SizeRestriction(MAX_SIZE)));
+ *   policy.SetRetention(retention);
+ * @endcode
  */
 class Creator : public InitialOpener
 {
@@ -41,6 +59,19 @@ public:
      */
     Creator( );
 
+    /**
+     * Makes the files opened afterwards as raw descriptors reuse the files
+     * that the retention would remove. Instead of creating a new file, the
+     * oldest file is renamed to the new path and written over from its
+     * beginning, keeping its allocated space, so no file is created or
+     * removed and no space is allocated on rotation. The old content is
+     * zeroed in place where the file system supports it, and the part beyond
+     * the written size is cut off, once the file is closed.
+     * @param retention The retention of the policy, or 0 for creating new
+     *                  files again
+     */
+    void SetRecycling(RetentionPtr retention);
+
 private:
 
     /**
@@ -51,8 +82,20 @@ private:
      */
     virtual boost::filesystem::path DoOpen(std::filebuf &file, Path& path);
 
+    /**
+     * Implements the opening as a raw descriptor. Provides no-throw
+     * guarantee.
+     * @param descriptor The opened descriptor
+     * @param path The rules for locating the file
+     * @param opened The path of the file opened
+     */
+    virtual bool DoOpenDescriptor(int &descriptor, Path &path,
+                                  boost::filesystem::path &opened);
+
     Creator(const Creator&);
     Creator& operator=(const Creator&);
+
+    RetentionPtr retention_;
 };
 
 }
@@ -64,7 +64,8 @@ PolicyPtr SizeRestrictedDatedFolderLog(std::size_t maxSize);
 /**
  * As SizeRestrictedLog, except a new log file is started once maximum size is
  * reached a new file is started. The files are identified from each other by
- * time stamps.
+ * time stamps. The old files are not removed, unless a Retention is attached
+ * to the returned policy with Policy::SetRetention.
  *
  * @todo Check whether the timestamp format documentation is still valid
  * The files are named by the following format:
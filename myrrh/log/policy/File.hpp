@@ -13,6 +13,7 @@
 #ifndef MYRRH_LOG_POLICY_FILE_HPP_INCLUDED
 #define MYRRH_LOG_POLICY_FILE_HPP_INCLUDED
 
+#include "myrrh/util/CoarseClock.hpp"
 #include "boost/shared_ptr.hpp"
 #include <string>
 
@@ -53,14 +54,72 @@ public:
      */
     std::streamsize Write(const std::string &line);
 
+    /**
+     * Returns the free part of the write buffer, into which the next text can
+     * be written in place and then taken into the buffer with Commit. If less
+     * than the given size is free, the buffered text is written to the file
+     * first. The room is valid until the next call of any of the writing
+     * methods.
+     * Provides no-throw guarantee
+     * @param size The size needed. If the whole buffer is smaller, the
+     *             room is smaller as well.
+     * @param available Receives the size of the room
+     * @return The beginning of the room, or 0 if the file has no write buffer
+     *         (@see Opener::SetBufferSize)
+     */
+    char *Reserve(std::size_t size, std::size_t &available);
+
+    /**
+     * Takes the text written at the beginning of the reserved room into the
+     * buffer, as if it was written with Write.
+     * Provides no-throw guarantee
+     * @param size The size of the text, at most the size of the room
+     * @return The size written
+     */
+    std::streamsize Commit(std::size_t size);
+
+    /**
+     * Prepares the file for WriteAt. The lines buffered by Write are written
+     * out and the file stops appending, so that the offsets given to WriteAt
+     * are honoured. Write must not be called afterwards.
+     * Provides no-throw guarantee
+     * @return false, if the file has not been opened as a raw descriptor
+     */
+    bool BeginWritingAt( );
+
+    /**
+     * Writes the text at the given offset of the file. Can be called by
+     * several threads at once, as long as the written ranges do not overlap.
+     * The written size is not counted, so the caller needs to track it.
+     * Provides no-throw guarantee
+     * @param text The text to be written
+     * @param offset The offset of the first character
+     * @return false, if the writing failed
+     */
+    bool WriteAt(const std::string &text, std::streamsize offset) const;
+
     /**
      * Returns the size that has already been written to the file during the
      * previous write operations (or before opening the file, if we are
-     * appending to existing file).
+     * appending to existing file). For a shared file the size is read with
+     * fstat, so it includes the writes of the other processes.
      * @return The size written so far
      */
     std::streamsize WrittenSize( ) const;
 
+    /**
+     * Tells if the file is shared by several processes
+     * @see Opener::SetShared
+     */
+    bool IsShared( ) const;
+
+    /**
+     * Returns the time when the file was opened for this object, or when it
+     * was renamed by the opener. Used by the restrictions that depend on the
+     * age of the file.
+     */
+    util::CoarseClock::Ticks OpenTime( ) const;
+
     const boost::filesystem::path &Path( ) const;
 
     /**
@@ -81,6 +140,15 @@ private:
 
     File(Opener &opener, policy::Path& path);
 
+    /**
+     * Renames the open file, after which the lines are written under the new
+     * name (@see Opener::Name).
+     * Provides no-throw guarantee
+     * @param name The new path of the file
+     * @return false, if the renaming failed. The name is not changed then.
+     */
+    bool Rename(const boost::filesystem::path &name);
+
     File(const File &);
     File &operator=(const File &);
 
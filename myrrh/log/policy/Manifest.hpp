@@ -0,0 +1,95 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class myrrh::log::policy::Manifest.
+ */
+
+#ifndef MYRRH_LOG_POLICY_MANIFEST_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_MANIFEST_HPP_INCLUDED
+
+#include "boost/shared_ptr.hpp"
+
+namespace boost { namespace filesystem { class path; } }
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+class Path;
+
+/**
+ * Manifest remembers the log file opened last, so that Appender does not
+ * need to scan the log folders for the latest file at program start-up. The
+ * manifest is stored in a small file, together with the modification times
+ * of the folders that Appender would scan. If any of the folders has been
+ * modified after the manifest was written, the manifest is stale and the
+ * folders are scanned as usual.
+ *
+ * The manifest is given to the openers with Opener::SetManifest. It is
+ * updated each time an opener opens a file, so the same Manifest object
+ * should be given to both the initial and the subsequent opener:
+ * @code
+ *   ManifestPtr manifest(new Manifest("logs/manifest"));
+ *   InitialOpenerPtr appender(new Appender);
+ *   appender->SetManifest(manifest);
+ *   OpenerPtr creator(new Creator);
+ *   creator->SetManifest(manifest);
+ *   Policy policy(path, appender, creator);
+ * @endcode
+ *
+ * If a file is opened that is earlier, according to the path parts, than the
+ * file recorded before, the manifest is removed. The next start-up then
+ * scans the folders, which finds the latest file as before.
+ *
+ * All of the operations provide a no-throw guarantee.
+ */
+class Manifest
+{
+public:
+
+    /**
+     * Constructor
+     * @param file The file into which the manifest is stored
+     */
+    explicit Manifest(const boost::filesystem::path &file);
+
+    /**
+     * Reads the file recorded last for the given path
+     * @param path The rules for locating the log files
+     * @param latest The latest file, if the manifest is valid
+     * @return false, if the manifest does not exist, is stale, or has been
+     *         recorded for different rules
+     */
+    bool Lookup(const Path &path, boost::filesystem::path &latest) const;
+
+    /**
+     * Records the given file as the latest one
+     * @param path The rules according to which the file was opened
+     * @param opened The opened file
+     */
+    void Record(const Path &path, const boost::filesystem::path &opened);
+
+private:
+
+    class Implementation;
+
+    boost::shared_ptr<Implementation> implementation_;
+};
+
+typedef boost::shared_ptr<Manifest> ManifestPtr;
+
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains declaration of function myrrh::log::policy::MatchLogs
+ */
+
+#ifndef MYRRH_LOG_POLICY_MATCHLOGS_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_MATCHLOGS_HPP_INCLUDED
+
+#include "myrrh/file/MatchFiles.hpp"
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+class Path;
+
+/**
+ * Finds all the existing files that match the rules of the given Path object.
+ * Unlike Appender, which looks only for the latest file, every matching file
+ * in every matching folder is returned. Together with myrrh::file::Merge the
+ * files written by several processes can be combined into one timeline:
+ * @code
+ *   Path path;
+ *   path += "worker" + ProcessId(ProcessId::ANY) + ".log";
+ *
+ *   std::ofstream output("timeline.log", std::ios::binary);
+ *   myrrh::file::Merge merge(MatchLogs(path), myrrh::log::TimestampKey( ));
+ *   merge(output);
+ * @endcode
+ * Note that by default ProcessId matches only the files of the current
+ * process, so ProcessId::ANY must be used for finding the files of the others.
+ *
+ * With long retention there may be a lot of folders on each level, e.g. one
+ * for each date. The folders of the same level can be scanned in parallel by
+ * giving a thread count larger than one.
+ * @param path The rules for the file paths
+ * @param threads The maximum count of threads scanning the folders of the
+ *                same level
+ * @return The matching files, sorted by path so that the result does not
+ *         depend on the order of the directory entries.
+ * @throws boost::filesystem::filesystem_error if the folders cannot be read
+ */
+file::PathStore MatchLogs(const Path &path, std::size_t threads = 1);
+
+}
+
+}
+
+}
+
+#endif
@@ -30,9 +30,11 @@ namespace policy
 {
 
 class File;
+class Manifest;
 class Path;
 
 typedef boost::shared_ptr<File> FilePtr;
+typedef boost::shared_ptr<Manifest> ManifestPtr;
 
 /**
  * An NVI interface class that provides a way to create new File objects. The
@@ -42,6 +44,48 @@ class Opener
 {
 public:
 
+    /// Tells that the file has not been opened as a raw descriptor
+    static const int NO_DESCRIPTOR = -1;
+
+    /**
+     * Tells how far the written lines are pushed towards the disk. Only
+     * applies to the files opened as raw descriptors and not mapped (@see
+     * SetMapping). The files written through streams are always FLUSHED.
+     */
+    enum Durability
+    {
+        /// The lines are collected into the write buffer and written once it
+        /// is full, or once the interval has passed since the first of them.
+        /// Without SetBufferSize the buffer is DEFAULT_BUFFER_SIZE bytes.
+        BUFFERED,
+        /// Each line is written to the operating system, unless a write
+        /// buffer is set. This is the default.
+        FLUSHED,
+        /// fdatasync is called once the given count of bytes has been
+        /// written, or once the interval has passed since the previous call.
+        /// Without either each line is synchronized.
+        SYNCED,
+        /// The writeback of each range of the given count of bytes (or
+        /// DEFAULT_WRITEBACK_SIZE) is started with sync_file_range once the
+        /// range is written, and waited for once the next range is written.
+        /// Thus the dirty pages are written steadily instead of in bursts.
+        WRITEBACK,
+        /// The file is opened with O_DSYNC, so each write returns once the
+        /// data is on the disk. Meant for audit trails.
+        DSYNC
+    };
+
+    /// The size of the write buffer used by BUFFERED without SetBufferSize
+    static const std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    /// The range size used by WRITEBACK without a given size
+    static const std::size_t DEFAULT_WRITEBACK_SIZE = 1024 * 1024;
+
+    /**
+     * Constructor
+     */
+    Opener( );
+
     /**
      * Virtual destructors are required in interface classes
      */
@@ -57,6 +101,131 @@ public:
      */
     FilePtr Open(Path path);
 
+    /**
+     * Opens a new File object under a temporary name in the given folder.
+     * The name begins with a dot, so it does not match the rules of the
+     * paths, and the file is not recorded in the manifest. The file is given
+     * its name later with Name.
+     * Provides no-throw guarantee.
+     * @param folder The folder of the new file
+     * @returns A shared_ptr containing the new File object. Can return 0, if
+     *          there is not enough memory to create the object.
+     */
+    FilePtr OpenTemporary(const boost::filesystem::path &folder);
+
+    /**
+     * Gives a file opened with OpenTemporary its name, and records it into
+     * the manifest like Open does.
+     * Provides no-throw guarantee.
+     * @param file The file to be named
+     * @param path The rules according to which the name was generated
+     * @param name The new path of the file
+     * @return false, if the file could not be renamed
+     */
+    bool Name(File &file, const Path &path,
+              const boost::filesystem::path &name);
+
+    /**
+     * Sets the size of the write buffer of the File objects opened
+     * afterwards. The buffer is only used if the subclass opens the files as
+     * raw descriptors. With the default size 0 each line is written with one
+     * system call. Otherwise the lines are collected until the buffer would
+     * overflow, or until the File object is destroyed.
+     * @param size The size of the buffer in bytes
+     */
+    void SetBufferSize(std::size_t size);
+
+    /**
+     * Makes the File objects opened afterwards as raw descriptors allocate
+     * disk space for the given size up front, so that the file system does
+     * not need to allocate it piece by piece while the file is written. The
+     * size of the file still grows only as it is written. The space left
+     * unused is released when the File object is destroyed. Usually the size
+     * equals the maximum size given to SizeRestriction. The default 0 means
+     * no preallocation. The preallocation is only supported on Linux and
+     * ignored elsewhere, as well as for shared files.
+     * @param size The size to be allocated in bytes
+     */
+    void SetPreallocation(std::size_t size);
+
+    /**
+     * Makes the File objects opened afterwards as raw descriptors be written
+     * through a memory mapped window of the file instead of write calls. The
+     * lines are copied into the window, which moves on as it becomes full. A
+     * background thread maps the next window ahead of time and synchronizes
+     * the full ones, so the writing needs no system calls. The file is
+     * extended a window at a time, so while it is written it ends with zeros
+     * up to the end of the window. It is truncated to the written size, once
+     * the File object is destroyed. If the process crashes, the zeros are
+     * left in the file. The mapping is not used for shared files or on
+     * Windows, and the write buffer (@see SetBufferSize) is not used with it.
+     * @param size The size of the window in bytes, rounded up to whole pages.
+     *             The default 0 means no mapping.
+     */
+    void SetMapping(std::size_t size);
+
+    /**
+     * Sets the durability of the File objects opened afterwards. The sizes
+     * are checked when the lines are written. The intervals are also kept by
+     * a background thread of each File object that has one, so the lines are
+     * written or synchronized in time even if no new lines follow. A SYNCED
+     * file is synchronized once more on destruction.
+     * @param durability Tells how far the lines are pushed towards the disk
+     * @param bytes The count of bytes for SYNCED and WRITEBACK. 0 means no
+     *              limit for SYNCED and the default for WRITEBACK.
+     * @param interval The interval in milliseconds for BUFFERED and SYNCED.
+     *                 0 means no interval.
+     */
+    void SetDurability(Durability durability, std::size_t bytes = 0,
+                       unsigned int interval = 0);
+
+    /**
+     * Sets the manifest into which the files opened afterwards are recorded.
+     * @see Manifest
+     * @param manifest The manifest, or 0 to stop recording
+     */
+    void SetManifest(ManifestPtr manifest);
+
+protected:
+
+    /**
+     * Returns the manifest set with SetManifest. Can be 0.
+     */
+    const ManifestPtr &GetManifest( ) const;
+
+    /**
+     * Tells that the files opened afterwards as raw descriptors are shared
+     * by several processes. Each line is written to a shared file with
+     * exactly one system call, without any buffering, and the written size
+     * is read from the file system instead of counting it.
+     * @param shared true for sharing the files
+     */
+    void SetShared(bool shared);
+
+    /**
+     * Opens the given file for writing so that each write is appended to its
+     * end. Can be used by the implementations of DoOpenDescriptor.
+     * Provides no-throw guarantee.
+     * @param path The path of the file
+     * @param truncate If true, any old content is destroyed
+     * @return The descriptor, or NO_DESCRIPTOR if the opening failed
+     */
+    static int OpenDescriptor(const boost::filesystem::path &path,
+                              bool truncate);
+
+    /**
+     * Opens the given existing file for writing so that it is written over
+     * from its beginning, keeping its allocated space. The old content is
+     * zeroed in place where the file system supports it, so that the readers
+     * never take it for new lines, and the part beyond the written size is
+     * cut off, once the File object is destroyed. Can be used by the
+     * implementations of DoOpenDescriptor for reusing old files.
+     * Provides no-throw guarantee.
+     * @param path The path of the file
+     * @return The descriptor, or NO_DESCRIPTOR if the opening failed
+     */
+    static int OverwriteDescriptor(const boost::filesystem::path &path);
+
 private:
 
     // Friend access is needed by File class to get access to DoOpen method.
@@ -66,6 +235,29 @@ private:
     friend class File;
 
     virtual boost::filesystem::path DoOpen(std::filebuf &file, Path& path) = 0;
+
+    /**
+     * Opens the file as a raw descriptor, which avoids the stream layer and
+     * the seeking needed to track the written size. The default
+     * implementation returns false, in which case DoOpen is used instead.
+     * Provides no-throw guarantee.
+     * @param descriptor The opened descriptor, or NO_DESCRIPTOR if the file
+     *                   could not be opened
+     * @param path The rules for locating the file
+     * @param opened The path of the file
+     * @return false, if opening as a raw descriptor is not supported
+     */
+    virtual bool DoOpenDescriptor(int &descriptor, Path &path,
+                                  boost::filesystem::path &opened);
+
+    std::size_t bufferSize_;
+    std::size_t preallocation_;
+    std::size_t mapping_;
+    Durability durability_;
+    std::size_t durabilityBytes_;
+    unsigned int durabilityInterval_;
+    bool shared_;
+    ManifestPtr manifest_;
 };
 
 typedef boost::shared_ptr<Opener> OpenerPtr;
@@ -96,6 +96,26 @@ public:
      */
     boost::filesystem::path Generate( );
 
+    /**
+     * Generates the folder of a new file path, without the name of the file.
+     * The folder parts are generated like in Generate, so an Index in the
+     * folders advances, whereas an Index in the name of the file does not.
+     * @return The folder, or the parent path if the path has no folders
+     */
+    boost::filesystem::path GenerateFolder( );
+
+    /**
+     * Parses the names of the file path with the entities of the path. The
+     * last names of the file path are parsed, one for each entity, so the
+     * file path may start with the parent path in any form.
+     * @param file The file path to parse
+     * @param key Receives the combined sort keys of the entities (@see
+     *            Path::Entity::Parse). The keys of two files compare like
+     *            the files were created.
+     * @return false, if the file path does not match the entities
+     */
+    bool Parse(const boost::filesystem::path &file, std::string &key) const;
+
     /**
      * Adds new path parts to the path. Note that the method is not planned to
      * be used straight by the user. Instead the user is expected to add
@@ -8,6 +8,7 @@
 
 #include "myrrh/log/policy/Path.hpp"
 
+#include "boost/regex_fwd.hpp"
 #include "boost/shared_ptr.hpp"
 
 #include <iterator>
@@ -53,6 +54,12 @@ typedef std::vector<boost::shared_ptr<PathPart> > PartStore;
  * in a directory. This is used to determine the file for appending new
  * content at program start-up.
  *
+ * The regular expression of the entity is compiled once, when the path parts
+ * are added. A matching name can be parsed into a sort key with Parse( ).
+ * Comparing the keys gives the same order as the Comparer, so the latest of
+ * several files can be found by parsing each name once and comparing the
+ * keys, instead of matching both names again for each comparison.
+ *
  * By making std::iterator a parent class it is possible to use Entity
  * as iterator in STL algorithms.
  */
@@ -63,6 +70,9 @@ public:
     typedef std::function<bool (const boost::filesystem::path&,
                                 const boost::filesystem::path)> Comparer;
 
+    /// A key, whose string comparison tells the order of the parsed names
+    typedef std::string Key;
+
     /**
      * Returns an object that can be checked if a path matches to the rules
      * specified in the entity. @see myrrh::file::ExpressionMatcher.
@@ -78,6 +88,15 @@ public:
 
     Comparer GetComparer( ) const;
 
+    /**
+     * Parses the last identifier of the given path into a sort key. The path
+     * parts that do not define an order (e.g. Text) add nothing to the key.
+     * @param path The path to parse
+     * @param key Receives the sort key, if the path matches
+     * @return false, if the path does not match the rules of the entity
+     */
+    bool Parse(const boost::filesystem::path &path, Key &key) const;
+
     void AppendRestrictions(RestrictionStore &store) const;
 
 private:
@@ -115,6 +134,10 @@ private:
                         const boost::filesystem::path &right) const;
 
     PartStore partStore_;
+    /// The combined expression of the parts, shared by the copies
+    boost::shared_ptr<const boost::regex> expression_;
+    /// The index of the sub-expression that each of the parts matches
+    std::vector<int> groups_;
 };
 
 }
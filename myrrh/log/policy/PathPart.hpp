@@ -71,6 +71,14 @@ public:
     bool IsFirstEarlier(const std::string &left,
                         const std::string &right) const;
 
+    /**
+     * Converts a part of existing file path into a key, which can be compared
+     * as a string. Comparing the keys gives the same order as IsFirstEarlier,
+     * so the files can be ordered without matching the parts again.
+     * @param match A string that matches the expression of the path part
+     */
+    std::string SortKey(const std::string &match) const;
+
 private:
 
     /**
@@ -88,6 +96,12 @@ private:
      */
     virtual bool DoIsFirstEarlier(const std::string &left,
                                   const std::string &right) const = 0;
+
+    /**
+     * Implements the sort key conversion. By default the match itself is
+     * returned, which suits the parts that are compared as strings.
+     */
+    virtual std::string DoSortKey(const std::string &match) const;
 };
 
 typedef boost::shared_ptr<PathPart> PathPartPtr;
@@ -241,6 +255,11 @@ private:
     virtual bool DoIsFirstEarlier(const std::string &left,
                                   const std::string &right) const;
 
+    /**
+     * Returns an empty key, the parts are not ordered
+     */
+    virtual std::string DoSortKey(const std::string &match) const;
+
     // Left non-const so that class is automatically assignable
     std::string text_;
 };
@@ -427,6 +446,117 @@ private:
     std::auto_ptr<TimePrivate> private_;
 };
 
+/**
+ * This PathPart subclass can be used to create parts of path that have the
+ * current hour in them. The format used in the result is "HH". The file is
+ * rotated every hour, at the turn of the hour.
+ *
+ * Example (folder with date and file name with hour):
+ * @code
+ *   Path path;
+ *   path += Date( ) + "/" + Hour( ) + ".log";
+ * @endcode
+ */
+class Hour : public PathPart
+{
+public:
+
+    /**
+     * Hour objects have a restriction. When the hour changes, the file path
+     * should also be changed. Therefore a new IntervalRestriction object is
+     * appended to given store.
+     * @param store The store for the possible restrictions
+     */
+    void AppendRestrictions(RestrictionStore &store);
+
+    /**
+     * Allows implicit conversion to PartSum. Part of the mechanism that allows
+     * the adding of path parts in same statement.
+     * @return New PartSum object that contains this copy of this object.
+     */
+    operator PartSum( ) const;
+
+private:
+
+    /**
+     * Implements the actual path part string generation
+     */
+    virtual std::string DoGenerate( );
+
+    /**
+     * Implements the actual regular string generation
+     */
+    virtual boost::regex DoGetExpression( ) const;
+
+    /**
+     * Implements the actual path part comparison
+     */
+    virtual bool DoIsFirstEarlier(const std::string &left,
+                                  const std::string &right) const;
+};
+
+/**
+ * This PathPart subclass can be used to create parts of path that have the
+ * start of the current interval of N minutes in them. The format used in the
+ * result is "HHMM". The intervals are aligned to the local midnight, so with
+ * an interval of 15 minutes the file is rotated at every quarter of an hour.
+ * @see IntervalRestriction
+ *
+ * Example (folder with date and a new file every 10 minutes):
+ * @code
+ *   Path path;
+ *   path += Date( ) + "/" + Minutes(10) + ".log";
+ * @endcode
+ */
+class Minutes : public PathPart
+{
+public:
+
+    /**
+     * Constructor
+     * @param interval The length of the interval in minutes. Must be between
+     *                 1 and IntervalRestriction::MINUTES_IN_DAY.
+     */
+    explicit Minutes(unsigned int interval);
+
+    /**
+     * Minutes objects have a restriction. When the interval changes, the file
+     * path should also be changed. Therefore a new IntervalRestriction object
+     * is appended to given store.
+     * @param store The store for the possible restrictions
+     */
+    void AppendRestrictions(RestrictionStore &store);
+
+    /**
+     * Allows implicit conversion to PartSum. Part of the mechanism that allows
+     * the adding of path parts in same statement.
+     * @return New PartSum object that contains this copy of this object.
+     */
+    operator PartSum( ) const;
+
+private:
+
+    /**
+     * Implements the actual path part string generation
+     */
+    virtual std::string DoGenerate( );
+
+    /**
+     * Implements the actual regular string generation
+     */
+    virtual boost::regex DoGetExpression( ) const;
+
+    /**
+     * Implements the actual path part comparison
+     */
+    virtual bool DoIsFirstEarlier(const std::string &left,
+                                  const std::string &right) const;
+
+    /// The length of the interval. Left non-const so that class is
+    /// automatically assignable
+    unsigned int interval_;
+};
+
 /**
  * This PathPart subclass can be used to create parts of path that have a
  * running number in them. For instance the user might want to have a maximum
@@ -479,6 +609,12 @@ private:
     virtual bool DoIsFirstEarlier(const std::string &left,
                                   const std::string &right) const;
 
+    /**
+     * Returns the index with the count of its digits in front, so that the
+     * keys compare in numeric order
+     */
+    virtual std::string DoSortKey(const std::string &match) const;
+
     /// The counter of current index
     size_t counter_;
 };
@@ -494,15 +630,29 @@ private:
  *   Path path;
  *   path += ProcessId( ) + "/file" + Index( ) + ".log";
  * @endcode
+ *
+ * By default only the files of the current process are matched. For finding
+ * the files of all processes (e.g. for merging them with MatchLogs), the
+ * object can be constructed with ProcessId::ANY.
  */
 class ProcessId : public PathPart
 {
 public:
 
+    /**
+     * Defines which process ids the regular expression matches
+     */
+    enum Match
+    {
+        CURRENT, ///< Only the id of the current process
+        ANY      ///< The id of any process
+    };
+
     /**
      * Constructor
+     * @param match Defines which process ids are matched
      */
-    ProcessId( );
+    explicit ProcessId(Match match = CURRENT);
 
     /**
      * ProcessId objects have no restriction, so does nothing.
@@ -526,9 +676,9 @@ private:
 
     /**
      * Implements the actual regular string generation
-     * @note The current process id is returned as regular expression. The
-     *       point is to match only if the process is the same as in previous
-     *       writing. It makes no sense to return less strict options.
+     * @note By default the current process id is returned as regular
+     *       expression. The point is to match only if the process is the same
+     *       as in previous writing. With ANY all process ids are matched.
      */
     virtual boost::regex DoGetExpression( ) const;
 
@@ -538,9 +688,87 @@ private:
     virtual bool DoIsFirstEarlier(const std::string &left,
                                   const std::string &right) const;
 
+    /**
+     * Returns an empty key, the parts are not ordered
+     */
+    virtual std::string DoSortKey(const std::string &match) const;
+
     /// The current process id. Left non-const so that class is automatically
     /// assignable
     std::string pid_;
+    Match match_;
+};
+
+/**
+ * This PathPart subclass can be used to create parts of path that have the id
+ * of the current thread in them. This is useful, if each thread should write
+ * into files of its own, so that the threads do not need to share any file.
+ * The thread id is read when the object is constructed, so the object must be
+ * constructed by the thread that will be using the path. See
+ * myrrh::log::policy::ShardedPolicy for a class that takes care of this.
+ *
+ * The ids are reused by the operating system once their threads have exited,
+ * so the files should be opened with Appender. Creator would truncate the
+ * file of an earlier thread that had the same id.
+ *
+ * Example (creates a file name with thread id in base and ".log" as postfix):
+ * @code
+ *   Path path;
+ *   path += "myrrh" + ThreadId( ) + ".log";
+ *   InitialOpenerPtr opener(new Appender);
+ *   Policy policy(path, opener, opener);
+ * @endcode
+ */
+class ThreadId : public PathPart
+{
+public:
+
+    /**
+     * Constructor
+     */
+    ThreadId( );
+
+    /**
+     * ThreadId objects have no restriction, so does nothing.
+     * @param store The store for the possible restrictions
+     */
+    void AppendRestrictions(RestrictionStore &store);
+
+    /**
+     * Allows implicit conversion to PartSum. Part of the mechanism that allows
+     * the adding of path parts in same statement.
+     * @return New PartSum object that contains this copy of this object.
+     */
+    operator PartSum( ) const;
+
+private:
+
+    /**
+     * Implements the actual path part string generation
+     */
+    virtual std::string DoGenerate( );
+
+    /**
+     * Implements the actual regular string generation
+     * @note As with ProcessId, only the id of the constructing thread is
+     *       matched.
+     */
+    virtual boost::regex DoGetExpression( ) const;
+
+    /**
+     * Implements the actual path part comparison
+     */
+    virtual bool DoIsFirstEarlier(const std::string &left,
+                                  const std::string &right) const;
+
+    /**
+     * Returns an empty key, the parts are not ordered
+     */
+    virtual std::string DoSortKey(const std::string &match) const;
+
+    /// The id of the constructing thread. Left non-const so that class is
+    /// automatically assignable
+    std::string tid_;
 };
 
 /**
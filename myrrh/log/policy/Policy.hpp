@@ -12,6 +12,7 @@
 #ifndef MYRRH_LOG_POLICY_POLICY_HPP_INCLUDED
 #define MYRRH_LOG_POLICY_POLICY_HPP_INCLUDED
 
+#include "myrrh/log/VerbosityLevel.hpp"
 #include "boost/shared_ptr.hpp"
 #include <string>
 
@@ -24,15 +25,19 @@ namespace log
 namespace policy
 {
 
+class Compressor;
 class File;
 class InitialOpener;
 class Opener;
 class Path;
 class Restriction;
+class Retention;
+typedef boost::shared_ptr<Compressor> CompressorPtr;
 typedef boost::shared_ptr<File> FilePtr;
 typedef boost::shared_ptr<InitialOpener> InitialOpenerPtr;
 typedef boost::shared_ptr<Opener> OpenerPtr;
 typedef boost::shared_ptr<Restriction> RestrictionPtr;
+typedef boost::shared_ptr<Retention> RetentionPtr;
 
 /**
  * Policy class is the container of all the rules that can be combined from
@@ -91,6 +96,12 @@ public:
     Policy(Path path, InitialOpenerPtr initialOpener,
            OpenerPtr subsequentOpener);
 
+    /**
+     * Virtual destructor is needed, because the writing can be customized by
+     * subclasses.
+     */
+    virtual ~Policy( );
+
     /**
      * Adds a new restriction to the log policy. A restriction means a
      * condition that requires the target file to be "reopened". For example,
@@ -116,8 +127,120 @@ public:
      */
     std::streamsize Write(const std::string &toWrite);
 
+    /**
+     * Writes the given text of the given verbosity level. By default the
+     * level is ignored and the text is written like by Write. Subclasses,
+     * like Router, use the level for choosing where the text is written.
+     * @param toWrite The text to be written to the log
+     * @param verbosity The verbosity level of the text
+     * @returns The size written to log
+     */
+    std::streamsize WriteWithLevel(const std::string &toWrite,
+                                   VerbosityLevel verbosity);
+
+    /**
+     * Returns a room in the write buffer of the current file, into which the
+     * next text can be formatted in place instead of passing it to Write. The
+     * text is written by calling Commit with its size. The room is valid only
+     * until the next call of Write, WriteWithLevel, Reserve or Commit.
+     * @param size The size needed. The room can be smaller, if the buffer
+     *             is.
+     * @param available Receives the size of the room
+     * @return The beginning of the room, or 0 if the file has no write buffer
+     *         (@see Opener::SetBufferSize) or the writing is implemented by a
+     *         subclass. The text is then written with Write.
+     */
+    char *Reserve(std::size_t size, std::size_t &available);
+
+    /**
+     * Writes the text formatted into the room returned by Reserve. The
+     * restrictions are checked with the given size like in Write. If they
+     * apply, the text is copied into the next file. Committing the size 0
+     * only releases the room.
+     * @pre Reserve has returned a room of at least the given size
+     * @param size The size of the text at the beginning of the room
+     * @returns The size written to log
+     */
+    std::streamsize Commit(std::size_t size);
+
+    /**
+     * Makes the policy open the next file ahead of time in a background
+     * thread. Once the restrictions apply, the writing continues straight in
+     * the prepared file, instead of waiting for the folders to be created and
+     * the file to be opened. Only the folder of the next path is generated
+     * when the file is prepared, and the file is opened under a temporary
+     * name (@see Opener::OpenTemporary). The name is generated once the
+     * restrictions apply, so its time parts are current, and the prepared
+     * file is renamed to it. The restrictions of the path (like the one of
+     * Date) make the prepared file outdated, in which case it is removed and
+     * the next one is prepared in the new folder. The writing never waits
+     * for the file to be prepared. If no file is ready, the next file is
+     * opened as usual. If the folder of the prepared file differs from the
+     * generated one, or a file of the generated name exists already, the
+     * prepared file is removed and the next file is opened as usual, which
+     * skips the generated Index number. An Index in the folders advances
+     * each time a file is prepared, so it should only be used in the names.
+     * @pre The subsequent opener must be an InitialOpener, because the
+     *      prepared file must not depend on the current one. It must also
+     *      allow opening files from both threads at once.
+     * @note Not supported by the subclasses that implement the writing by
+     *       themselves.
+     */
+    void OpenAhead( );
+
+    /**
+     * Attaches a retention to the policy. The retention is told about the
+     * current file and about each file opened after it, and it removes the
+     * oldest files in the background once its limits are exceeded. See
+     * myrrh::log::policy::Retention.
+     * @param retention The retention, or null for detaching the current one
+     * @note Not supported by the subclasses that implement the writing by
+     *       themselves.
+     */
+    void SetRetention(RetentionPtr retention);
+
+    /**
+     * Attaches a compressor to the policy. Each time the policy moves on to
+     * a file with a different path, the previous file is handed to the
+     * compressor, which compresses it in the background. See
+     * myrrh::log::policy::Compressor.
+     * @param compressor The compressor, or null for detaching the current
+     *                   one
+     * @note Not supported by the subclasses that implement the writing by
+     *       themselves.
+     */
+    void SetCompressor(CompressorPtr compressor);
+
+protected:
+
+    /**
+     * Constructor for subclasses that implement the writing by themselves,
+     * for instance by distributing it to other Policy objects. Such a
+     * subclass must override both DoAddRestriction and DoWrite.
+     */
+    Policy( );
+
 private:
 
+    /**
+     * Implements adding of a restriction. By default the restriction is
+     * added to the restrictions checked before each write operation.
+     */
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+
+    /**
+     * Implements the writing. By default the text is written to the current
+     * log file, which is reopened first if the restrictions apply.
+     */
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    /**
+     * Implements the writing of a text with a verbosity level. By default
+     * the level is ignored and the text is written with DoWrite.
+     */
+    virtual std::streamsize DoWriteWithLevel(const std::string &toWrite,
+                                             VerbosityLevel verbosity);
+
     /// Disabled copying
     Policy(const Policy& policy);
     /// Disabled assignment
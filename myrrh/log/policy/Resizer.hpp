@@ -30,7 +30,14 @@ class Path;
 /**
  * This class a way of opening log files for myrrh::log::policy component. The
  * opening for Resizer means that the given file is resized to be of a specific
- * size or smaller, if the last line does not fit in in entirety.
+ * size or smaller, if the last line does not fit in in entirety. The size may
+ * be exceeded when the head is dropped in place, as told below.
+ *
+ * On Linux the head of the file is dropped in place, if the filesystem
+ * supports collapsing ranges of a file (for instance ext4 and XFS). The head
+ * can only be dropped in whole blocks, so less than a block more is kept than
+ * the given size, and the file starts with the end of the line cut by the
+ * block boundary. Otherwise the kept content is copied.
  */
 class Resizer : public Opener
 {
@@ -54,6 +61,16 @@ private:
      */
     virtual boost::filesystem::path DoOpen(std::filebuf &file, Path& path);
 
+    /**
+     * Implements the opening as a raw descriptor. Provides no-throw
+     * guarantee.
+     * @param descriptor The opened descriptor
+     * @param path The rules for locating the file
+     * @param opened The path of the file opened
+     */
+    virtual bool DoOpenDescriptor(int &descriptor, Path &path,
+                                  boost::filesystem::path &opened);
+
     /// Copy construction prevented
     Resizer(const Resizer &);
     /// Assignment prevented
@@ -12,6 +12,7 @@
 #ifndef MYRRH_LOG_POLICY_RESTRICTION_H_INCLUDED
 #define MYRRH_LOG_POLICY_RESTRICTION_H_INCLUDED
 
+#include "myrrh/util/CoarseClock.hpp"
 #include "boost/shared_ptr.hpp"
 #include <string>
 
@@ -29,6 +30,25 @@ namespace policy
 // Forward declaration
 class File;
 
+/**
+ * Limits tell how long a file can be used before its restrictions need to be
+ * checked again. They are published by the restrictions when a file has been
+ * opened, so that the check done for each line becomes a subtraction and a
+ * comparison.
+ */
+struct Limits
+{
+    /**
+     * Constructor. Initializes the limits to be unlimited.
+     */
+    Limits( );
+
+    /// The count of bytes that can still be written without checking
+    std::size_t budget;
+    /// The time before which no check is needed
+    util::CoarseClock::Ticks deadline;
+};
+
 /**
  * Restriction class is an interface for restricting the use of a log file
  * after a specific condition. Each subclass is intended for checking of one
@@ -56,6 +76,17 @@ public:
     /// real size could be calculated (line endings) in those restrictions
     /// that really require it.
     virtual bool IsRestricted(const File &file, std::size_t toWrite) const = 0;
+
+    /**
+     * Lowers the given limits to the point at which this restriction may
+     * apply, so that IsRestricted needs to be called only when the limits
+     * are crossed. The default implementation does not publish any limits,
+     * which makes IsRestricted to be called for each line.
+     * @param file The file that has just been opened or checked
+     * @param limits The limits to be lowered
+     * @returns true, if the limits were published
+     */
+    virtual bool GetLimits(const File &file, Limits &limits) const;
 };
 
 typedef boost::shared_ptr<Restriction> RestrictionPtr;
@@ -66,6 +97,10 @@ typedef boost::shared_ptr<Restriction> RestrictionPtr;
  * class can be used to tell myrrh::log::policy::Policy class to restrict the
  * log files sizes. The resulting action (resizing or starting a new file) is
  * the responsibility of other classes.
+ *
+ * The other processes write into a shared file as well (@see File::IsShared),
+ * so for those files the published budget is at most SHARED_BUDGET. The size
+ * of the file is read again after writing that much.
  */
 class SizeRestriction : public Restriction
 {
@@ -77,6 +112,9 @@ public:
      */
     explicit SizeRestriction(std::size_t maxSize);
 
+    /// The largest budget published for a shared file
+    static const std::size_t SHARED_BUDGET = 4 * 1024;
+
     /**
      * Checks if the size of the text to be written fits into file.
      * @param file The file to be checked
@@ -86,6 +124,11 @@ public:
      */
     virtual bool IsRestricted(const File &file, std::size_t toWrite) const;
 
+    /**
+     * Publishes the size left in the file as the budget
+     */
+    virtual bool GetLimits(const File &file, Limits &limits) const;
+
 private:
 
     /// Copy construction is prevented
@@ -97,6 +140,60 @@ private:
     const std::size_t MAX_SIZE_;
 };
 
+/**
+ * Defines the file restricted after every boundary of a time interval. The
+ * boundaries are aligned to the local wall clock, counted from midnight. For
+ * instance with an interval of 15 minutes the file is restricted at every
+ * quarter of an hour. If the interval does not divide a day evenly, the last
+ * interval of a day is cut short at midnight.
+ *
+ * The next boundary is computed only when the previous one has been crossed,
+ * so checking the restriction only compares the coarse clock to it.
+ * @note If the offset of the local time changes (e.g. daylight saving time
+ *       starts), the change is noticed at the next boundary.
+ */
+class IntervalRestriction : public Restriction
+{
+public:
+
+    /// The count of minutes in a day, the longest interval
+    static const unsigned int MINUTES_IN_DAY = 24 * 60;
+
+    /**
+     * Constructor
+     * @param minutes The length of the interval in minutes. Must be between 1
+     *                and MINUTES_IN_DAY.
+     */
+    explicit IntervalRestriction(unsigned int minutes);
+
+    /**
+     * Checks if a boundary has been crossed since the file was opened. The
+     * check does not change the restriction, so it gives the same answer
+     * however many times it is made, and a file opened after the boundary is
+     * not restricted by it.
+     * @param file The file to be checked
+     * @param toWrite The size of the text that will be written next to the
+     *                file. Ignored.
+     * @returns true If the boundary has been crossed, false otherwise
+     */
+    virtual bool IsRestricted(const File &file, std::size_t toWrite) const;
+
+    /**
+     * Publishes the first boundary after the opening of the file as the
+     * deadline
+     */
+    virtual bool GetLimits(const File &file, Limits &limits) const;
+
+private:
+
+    /// Copy construction is prevented
+    IntervalRestriction(const IntervalRestriction &);
+    /// Assignment is prevented
+    IntervalRestriction &operator=(const IntervalRestriction &);
+
+    const unsigned int MINUTES_;
+};
+
 class DateCreator
 {
 public:
@@ -104,6 +201,25 @@ public:
     static boost::gregorian::date NewDate( );
 };
 
+/**
+ * Publishes the deadline of DateRestriction<DateCreator>, which is the next
+ * change of the local date.
+ * @param date The date of the current file
+ * @param limits The limits to be lowered
+ */
+bool GetDateLimits(const DateCreator *, const boost::gregorian::date &date,
+                   Limits &limits);
+
+/**
+ * The dates of other creators are not known in advance, so they are checked
+ * for each line.
+ */
+template <typename Creator, typename Date>
+inline bool GetDateLimits(const Creator *, const Date &, Limits &)
+{
+    return false;
+}
+
 /**
  * Defines the file restricted after every date change.
  */
@@ -128,6 +244,12 @@ public:
      */
     virtual bool IsRestricted(const File &file, std::size_t toWrite) const;
 
+    /**
+     * Publishes the next change of date as the deadline. Only done for
+     * DateCreator, other creators are checked for each line.
+     */
+    virtual bool GetLimits(const File &file, Limits &limits) const;
+
 private:
 
     /// Copy construction is prevented
@@ -160,6 +282,13 @@ IsRestricted(const File &, std::size_t) const
     return true;
 }
 
+template <typename Creator>
+inline bool DateRestriction<Creator>::GetLimits(const File &,
+                                                Limits &limits) const
+{
+    return GetDateLimits(static_cast<const Creator *>(0), date_, limits);
+}
+
 }
 
 }
@@ -13,6 +13,8 @@
 #ifndef MYRRH_LOG_POLICY_RESTRICTIONSTORE_HPP_INCLUDED
 #define MYRRH_LOG_POLICY_RESTRICTIONSTORE_HPP_INCLUDED
 
+#include "myrrh/util/CoarseClock.hpp"
+
 #include <vector>
 
 // Forward declarations
@@ -30,17 +32,29 @@ namespace policy
 // Forward declarations
 class File;
 class Restriction;
+struct Limits;
 typedef boost::shared_ptr<Restriction> RestrictionPtr;
 
 /**
  * This class is used to store Restriction objects and to check if any of the
  * contained restrictions apply to the current conditions.
+ *
+ * For checking each written line Charge should be used instead of
+ * IsRestricted. It collects the byte budgets and deadlines published by the
+ * restrictions (@see Restriction::GetLimits) and evaluates the restrictions
+ * only after crossing them. The restrictions that do not publish limits are
+ * still checked for each line.
  */
 class RestrictionStore
 {
     typedef std::vector<RestrictionPtr> Restrictions;
 public:
 
+    /**
+     * Constructor
+     */
+    RestrictionStore( );
+
     /**
      * Adds a new restriction in to the store.
      * @param restriction The new restriction to be added
@@ -55,6 +69,31 @@ public:
      */
     bool IsRestricted(const File &file, std::size_t toWrite) const;
 
+    /**
+     * Checks the restrictions for the line to be written and charges its size
+     * from the budget. Once a restriction applies, the limits are forgotten,
+     * so that the next call checks the newly opened file in full.
+     * @param file The file that is checked for restrictions
+     * @param toWrite The size of text written next to log
+     * @returns true, if at least one restriction apply.
+     */
+    bool Charge(const File &file, std::size_t toWrite);
+
+    /**
+     * Forgets the collected limits, so that the next call to Charge checks
+     * all the restrictions.
+     */
+    void Disarm( );
+
+    /**
+     * Lowers the given limits with the limits published by each of the
+     * restrictions (@see Restriction::GetLimits).
+     * @param file The file for which the limits are collected
+     * @param limits The limits to be lowered
+     * @returns false, if any of the restrictions does not publish limits
+     */
+    bool GetLimits(const File &file, Limits &limits) const;
+
     /**
      * Returns the count of stored restrictions
      * @note Useful only for testing
@@ -63,10 +102,19 @@ public:
 
 private:
 
+    /// Collects the limits of the restrictions for the given file
+    void Arm(const File &file);
+
     /**
      * Stores the restrictions
      */
     Restrictions restrictions_;
+
+    /// The restrictions that are checked for each line while armed
+    Restrictions unlimited_;
+    bool armed_;
+    std::size_t budget_;
+    util::CoarseClock::Ticks deadline_;
 };
 
 }
@@ -0,0 +1,139 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class myrrh::log::policy::Retention.
+ */
+
+#ifndef MYRRH_LOG_POLICY_RETENTION_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_RETENTION_HPP_INCLUDED
+
+#include "boost/cstdint.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include <cstddef>
+
+namespace boost { namespace filesystem { class path; } }
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+class Path;
+
+/**
+ * Retention removes the oldest log files, once the files written according
+ * to a Path exceed the configured limits. Without it the policies that start
+ * a new file on each rotation (like the ones using Creator with Time) never
+ * remove anything.
+ *
+ * The files are ordered with the rules of the path entities (see
+ * Path::Entity::Parse), so the oldest file is the one that would be chosen
+ * last by Appender. The folders are scanned once, when the first file is
+ * reported. After that each file opened by the policy is added to the known
+ * files, so the folders do not need to be listed again on rotation. Folders
+ * that become empty, like the dated ones, are removed as well.
+ *
+ * The files are removed by a background thread. The policy only reports the
+ * opened files, so the logging thread never waits for the removal:
+ * @code
+ *   RetentionPtr retention(new Retention(path));
+ *   retention->SetMaxCount(100);
+ *   retention->SetMaxSize(1024 * 1024 * 1024);
+ *   policy.SetRetention(retention);
+ * @endcode
+ *
+ * The file opened last is never removed, even if it alone exceeds the
+ * limits. Its size is read when the next file is opened, so the total size
+ * may exceed the limit by the amount written to the current file.
+ *
+ * The files compressed by Compressor are retained like the original ones.
+ *
+ * With recycling (@see Creator::SetRecycling) the oldest uncompressed file
+ * is kept as a spare instead of removing it, until Creator renames it to the
+ * next file. Meanwhile the spare is moved to the parent path under a hidden
+ * name (the name of the file between a dot and ".spare"), which the rules
+ * of the path do not match. Thus there can be one file more on the disk than
+ * the limits allow. The spare is removed when Retention is destroyed.
+ */
+class Retention
+{
+public:
+
+    /**
+     * Constructor. No limits are set, so nothing is removed until one is.
+     * @param path The rules of the log files to be retained
+     * @throws boost::thread_resource_error, if the thread cannot be started
+     */
+    explicit Retention(const Path &path);
+
+    /**
+     * Destructor. Stops the background thread.
+     */
+    ~Retention( );
+
+    /**
+     * Sets the maximum count of the files. Zero means no limit.
+     */
+    void SetMaxCount(std::size_t count);
+
+    /**
+     * Sets the maximum total size of the files in bytes. Zero means no limit.
+     */
+    void SetMaxSize(boost::uintmax_t size);
+
+    /**
+     * Sets the maximum age of the files, counted from their last
+     * modification. The ages are also checked periodically, even if no files
+     * are opened. A non-positive age means no limit.
+     */
+    void SetMaxAge(const boost::posix_time::time_duration &age);
+
+    /**
+     * Reports that a file has been opened for writing. Called by Policy.
+     * Provides a no-throw guarantee.
+     * @param file The opened file
+     */
+    void Opened(const boost::filesystem::path &file);
+
+    /**
+     * Sets whether a removed file is kept as a spare for Recycle. Called by
+     * Creator::SetRecycling.
+     */
+    void SetRecycling(bool recycling);
+
+    /**
+     * Renames the spare file to the given path, if there is one. Called by
+     * Creator. Provides a no-throw guarantee.
+     * @param file The path of the next file
+     * @return false, if there was no spare file
+     */
+    bool Recycle(const boost::filesystem::path &file);
+
+private:
+
+    Retention(const Retention &);
+    Retention &operator=(const Retention &);
+
+    class Implementation;
+
+    boost::shared_ptr<Implementation> implementation_;
+};
+
+typedef boost::shared_ptr<Retention> RetentionPtr;
+
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains declaration of class myrrh::log::policy::Router
+ */
+
+#ifndef MYRRH_LOG_POLICY_ROUTER_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_ROUTER_HPP_INCLUDED
+
+#include "myrrh/log/policy/Policy.hpp"
+
+#include <vector>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+/**
+ * Router distributes the written texts to several Policy objects by the
+ * verbosity levels of the texts. Each destination is added with a range of
+ * levels, and each text is written to every destination whose range contains
+ * the level of the text. The text is formatted only once, and the same text
+ * is passed to each of the destinations:
+ * @code
+ *   using namespace myrrh::log;
+ *   boost::shared_ptr<policy::Router> router(new policy::Router);
+ *   router->AddRoute(errorPolicy, ERROR);
+ *   router->AddRoute(allPolicy);
+ *   router->AddRoute(tracePolicy, TRACE, TRACE);
+ *   policy::Stream stream(router);
+ *   Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+ * @endcode
+ *
+ * The levels are told by Log through Stream (@see VerbosityAware). The texts
+ * written without a level, either with Write or through a Stream whose level
+ * has not been told, are written to all of the destinations.
+ *
+ * Each destination has restrictions of its own, as each of them writes files
+ * of its own. A restriction added to Router itself is added to each of the
+ * destinations routed at the time.
+ *
+ * @warning The routes must be added before the writing begins.
+ */
+class Router : public Policy
+{
+public:
+
+    /**
+     * Constructor. There are no routes initially, so nothing is written.
+     */
+    Router( );
+
+    /**
+     * Destructor
+     */
+    virtual ~Router( );
+
+    /**
+     * Adds a destination for the texts of the given levels
+     * @param destination The policy that writes the texts
+     * @param leastSevere The most verbose level written to the destination
+     * @param mostSevere The least verbose level written to the destination
+     * @throws std::bad_alloc, if there is not enough memory for the route
+     */
+    void AddRoute(PolicyPtr destination, VerbosityLevel leastSevere = TRACE,
+                  VerbosityLevel mostSevere = CRIT);
+
+private:
+
+    /**
+     * Adds the restriction to each of the destinations
+     */
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+
+    /**
+     * Writes the text to all of the destinations.
+     * @return The size of the text, if all destinations wrote it entirely,
+     *         otherwise the smallest size written
+     */
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    /**
+     * Writes the text to the destinations of its level.
+     * @return The size of the text, if all of those destinations wrote it
+     *         entirely or there were none, otherwise the smallest size
+     *         written
+     */
+    virtual std::streamsize DoWriteWithLevel(const std::string &toWrite,
+                                             VerbosityLevel verbosity);
+
+    /**
+     * A destination and the range of levels written to it
+     */
+    struct Route
+    {
+        PolicyPtr destination;
+        VerbosityLevel leastSevere;
+        VerbosityLevel mostSevere;
+    };
+
+    typedef std::vector<Route> Routes;
+
+    Routes routes_;
+};
+
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains declaration of class myrrh::log::policy::ShardedPolicy
+ */
+
+#ifndef MYRRH_LOG_POLICY_SHARDEDPOLICY_HPP_INCLUDED
+#define MYRRH_LOG_POLICY_SHARDEDPOLICY_HPP_INCLUDED
+
+#include "myrrh/log/policy/Policy.hpp"
+
+#include <functional>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+/**
+ * ShardedPolicy distributes the writing so that each writing thread has a
+ * Policy object, and thus log files, of its own. The threads never share
+ * a file, so they do not need to wait for each other. The shards are created
+ * lazily with the given factory function, when a thread writes for the first
+ * time. The factory is called by the writing thread, so it can use ThreadId
+ * objects to give each shard an unique path:
+ * @code
+ *   PolicyPtr NewShard( )
+ *   {
+ *       Path path;
+ *       path += "myrrh" + ThreadId( ) + ".log";
+ *       InitialOpenerPtr opener(new Appender);
+ *       return PolicyPtr(new Policy(path, opener, opener));
+ *   }
+ *
+ *   PolicyPtr policy(new ShardedPolicy(NewShard));
+ * @endcode
+ *
+ * Each written text is prefixed with a sequence number that is global to all
+ * of the ShardedPolicy objects of the process. The numbers grow in the order
+ * the texts are written, so the shards can later be merged back into one
+ * chronological file with myrrh::file::Merge and SequenceKey.
+ *
+ * The shard of a thread is released, and its files closed, when the thread
+ * exits, so the threads of a pool that come and go do not leave open files
+ * behind. The threads are told apart by numbers of their own instead of
+ * their ids, so a new thread never takes over the shard of an exited thread
+ * whose id it was given. Its files are still named after the id, though, so
+ * the shards must be opened with Appender. Creator would truncate the file
+ * of the exited thread before it has been merged.
+ *
+ * Restrictions cannot be added to ShardedPolicy itself. Each shard must add
+ * restrictions of its own in the factory function, because the Restriction
+ * objects are not thread-safe.
+ *
+ * @note The Stream objects themselves are not thread-safe, so each thread
+ *       must either use a Stream object of its own or share the ShardedPolicy
+ *       through myrrh::log::Log.
+ */
+class ShardedPolicy : public Policy
+{
+public:
+
+    typedef std::function<PolicyPtr ( )> Factory;
+
+    /**
+     * Constructor
+     * @param factory Creates a new Policy object for each writing thread
+     */
+    explicit ShardedPolicy(Factory factory);
+
+    /**
+     * Destructor
+     */
+    virtual ~ShardedPolicy( );
+
+    /**
+     * The count of characters in the sequence number prefix, including the
+     * separating space.
+     */
+    static const std::size_t PREFIX_SIZE = 21;
+
+private:
+
+    /**
+     * Restrictions must be added to the shards in the factory function, so
+     * this is considered a programming error.
+     */
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+
+    /**
+     * Writes the text prefixed with the next sequence number into the shard
+     * of the calling thread.
+     */
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    class Shards;
+
+    boost::shared_ptr<Shards> shards_;
+};
+
+/**
+ * Returns a function that can be passed to myrrh::file::Merge for merging the
+ * files written by ShardedPolicy. The function returns the length of the
+ * sequence number for lines that start a new record and 0 for the rest.
+ */
+std::function<std::size_t (const std::string &)> SequenceKey( );
+
+}
+
+}
+
+}
+
+#endif
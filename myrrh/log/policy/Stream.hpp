@@ -13,6 +13,7 @@
 #ifndef MYRRH_LOG_POLICY_STREAM_HPP_INCLUDED
 #define MYRRH_LOG_POLICY_STREAM_HPP_INCLUDED
 
+#include "myrrh/log/VerbosityAware.hpp"
 #include "myrrh/util/BufferedStream.hpp"
 #include "boost/shared_ptr.hpp"
 
@@ -32,9 +33,22 @@ typedef boost::shared_ptr<Policy> PolicyPtr;
  * This class integrates the myrrh::log::policy component to std::ostream
  * interface. It is not designed to be usable by itself, but through Stream
  * class.
+ *
+ * If the policy provides a room in the write buffer of its file (@see
+ * Policy::Reserve), the room is used as the put area of the stream. The text
+ * is then formatted straight into the file buffer and committed on sync.
+ * Otherwise, or if the text does not fit into the room, the text is
+ * collected by BufferedStream and written with Policy::Write.
+ *
+ * If the verbosity level of the text has been told (@see SetVerbosity), the
+ * collected text is written with Policy::WriteWithLevel instead. Log tells
+ * the level of each line, so a Router behind the buffer can choose the
+ * destinations of the line without it being formatted again.
+ * @note While a text is being formatted, the policy must not be written
+ *       through other means.
  */
 // Move to separate header
-class Buffer : public util::BufferedStream
+class Buffer : public util::BufferedStream, public VerbosityAware
 {
 public:
 
@@ -44,14 +58,53 @@ public:
      */
     explicit Buffer(PolicyPtr policy);
 
+    /**
+     * Tells the verbosity level of the text that is written next. The level
+     * is forgotten once the text has been synchronized.
+     * Provides no-throw guarantee.
+     */
+    virtual void SetVerbosity(VerbosityLevel verbosity);
+
 private:
 
+    /**
+     * Stores the character into the put area, if a room can be reserved for
+     * it. Otherwise BufferedStream stores it.
+     */
+    virtual int_type overflow(int_type character);
+
+    /**
+     * Copies the text into the put area, if it fits into it. Otherwise
+     * BufferedStream stores it.
+     */
+    virtual std::streamsize xsputn(const char *text, std::streamsize length);
+
+    /**
+     * Commits the text of the put area to the policy, or writes the text
+     * stored by BufferedStream. The room is released even if it is empty.
+     * @return 0 If succeeded, otherwise -1.
+     */
+    virtual int sync( );
+
     /**
      * Implements the actual output.
      * @return 0 If succeeded, otherwise -1.
      */
     virtual int SyncImpl( );
 
+    /**
+     * Makes the put area a room of at least the given size, unless
+     * BufferedStream already stores text
+     * @return false, if no room was reserved
+     */
+    bool Reserve(std::size_t size);
+
+    /**
+     * Moves the text of the put area to BufferedStream, which stores the rest
+     * of the text, and releases the room
+     */
+    void Abandon( );
+
     /// Prevent copying
     Buffer(const Buffer &);
     /// Prevent assignment
@@ -59,6 +112,9 @@ private:
 
     /// Contains the policy rules for log writing
     PolicyPtr policy_;
+    /// The verbosity level of the text, if hasVerbosity_ is set
+    VerbosityLevel verbosity_;
+    bool hasVerbosity_;
 };
 
 /**
@@ -91,6 +147,14 @@ public:
      */
     explicit Stream(PolicyPtr policy);
 
+    /**
+     * Tells the verbosity level of the text that is written next, until the
+     * stream is flushed. Needed only when the stream is written directly,
+     * as Log tells the level of each line by itself.
+     * Provides no-throw guarantee.
+     */
+    void SetVerbosity(VerbosityLevel verbosity);
+
 private:
 
     /// Implements the directing of output to myrrh::log::policy
@@ -0,0 +1,57 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the declaration of class myrrh::util::CoarseClock.
+ */
+
+#ifndef MYRRH_UTIL_COARSECLOCK_HPP_INCLUDED
+#define MYRRH_UTIL_COARSECLOCK_HPP_INCLUDED
+
+#include "boost/cstdint.hpp"
+
+namespace boost { namespace posix_time { class ptime; } }
+
+namespace myrrh
+{
+
+namespace util
+{
+
+/**
+ * CoarseClock reads the universal time with the resolution of the scheduler
+ * tick (typically a few milliseconds). On Linux the time is read from the
+ * value the kernel has cached for CLOCK_REALTIME_COARSE, which is
+ * considerably cheaper than reading the precise time. It is intended for the
+ * checks made for each written line, where only deadlines need to be
+ * compared.
+ */
+class CoarseClock
+{
+public:
+
+    /// The milliseconds since the epoch
+    typedef boost::int64_t Ticks;
+
+    /// Later than any time returned by Now
+    static const Ticks NEVER;
+
+    /**
+     * Returns the current universal time
+     */
+    static Ticks Now( );
+
+    /**
+     * Converts the given universal time into ticks. The special values, like
+     * not_a_date_time, are converted into NEVER.
+     */
+    static Ticks FromTime(const boost::posix_time::ptime &universal);
+};
+
+}
+
+}
+
+#endif
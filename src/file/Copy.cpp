@@ -12,10 +12,27 @@
 #include "myrrh/file/Copy.hpp"
 #include "myrrh/file/PositionScanner.hpp"
 
+#include "boost/filesystem/path.hpp"
 #include "boost/scoped_array.hpp"
 
+#include <algorithm>
 #include <fstream>
 
+#ifndef WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define MYRRH_COPY_FILE_RANGE
+#endif
+
 namespace myrrh
 {
 namespace file
@@ -24,6 +41,9 @@ namespace file
 namespace
 {
 
+/// The size of the chunks read into memory at a time
+const std::streamsize CHUNK_SIZE = 64 * 1024;
+
 /**
  * Checks the given boolean condition. If true, nothing is done. Otherwise an
  * exception of template type Exception is thrown.
@@ -39,6 +59,53 @@ void Check(bool toCheck, const std::string &errorString);
  */
 std::streampos GetFileSize(std::ifstream &stream);
 
+/**
+ * Copies the range between streams in chunks
+ */
+void CopyStream(std::ifstream &input, std::ofstream &output,
+                std::streampos start, std::streamsize size);
+
+#ifndef WIN32
+
+/// The maximum size copied by the kernel with one call
+const std::streamsize KERNEL_CHUNK_SIZE = 1 << 30;
+
+/**
+ * Owns a descriptor and closes it on destruction
+ */
+class Descriptor
+{
+public:
+
+    explicit Descriptor(int descriptor);
+    ~Descriptor( );
+    int Get( ) const;
+
+private:
+
+    Descriptor(const Descriptor &);
+    Descriptor &operator=(const Descriptor &);
+
+    const int DESCRIPTOR_;
+};
+
+/**
+ * Copies the range to the current position of the output without reading it
+ * into the memory of the process.
+ * @return The size copied. Is less than the given size, if the kernel cannot
+ *         copy between the files.
+ */
+std::streamsize CopyInKernel(int input, int output, off_t start,
+                             std::streamsize size);
+
+/**
+ * Copies the range to the current position of the output in chunks
+ * @throws Copy::Incomplete, if reading or writing fails
+ */
+void CopyInChunks(int input, int output, off_t start, std::streamsize size);
+
+#endif
+
 }
 
 Copy::Copy(PositionScannerPtr startScanner, PositionScannerPtr endScanner) :
@@ -47,39 +114,63 @@ Copy::Copy(PositionScannerPtr startScanner, PositionScannerPtr endScanner) :
 {
 }
 
-// Too big method
 void Copy::operator( )(std::ifstream &input, std::ofstream &output) const
 {
-    // if input stream is not open scanners will throw
-    const std::streampos START(startScanner_->Scan(input));
-    const std::streampos END(endScanner_->Scan(input));
+    std::streampos start;
+    const std::streamsize SIZE = ScanRange(input, start);
 
-    Check<OutOfBounds>(END >= START, "start point after end");
+    Check<StreamNotOpen>(output.is_open( ), "output stream not open");
 
-    assert(START >= 0);
-    assert(END >= 0);
-    assert(GetFileSize(input) >= END);
+    CopyStream(input, output, start, SIZE);
+}
 
-    Check<StreamNotOpen>(output.is_open( ), "output stream not open");
+void Copy::operator( )(const boost::filesystem::path &input,
+                       const boost::filesystem::path &output) const
+{
+    std::ifstream inputStream(input.string( ).c_str( ),
+                              std::ios::in | std::ios::binary);
+    std::streampos start;
+    const std::streamsize SIZE = ScanRange(inputStream, start);
 
-    const std::streamsize SIZE = END - START;
-    assert(SIZE >= 0);
+#ifdef WIN32
+    std::ofstream outputStream(output.string( ).c_str( ),
+                               std::ios::out | std::ios::binary);
+    Check<StreamNotOpen>(outputStream.is_open( ), "output file not open");
 
-    if (!SIZE)
-    {
-        return;
-    }
+    CopyStream(inputStream, outputStream, start, SIZE);
+#else
+    const Descriptor INPUT(open(input.string( ).c_str( ),
+                                O_RDONLY | O_CLOEXEC));
+    Check<PositionScanner::NotOpen>(INPUT.Get( ) >= 0, "input file not open");
+
+    const Descriptor OUTPUT(open(output.string( ).c_str( ),
+                                 O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                 0666));
+    Check<StreamNotOpen>(OUTPUT.Get( ) >= 0, "output file not open");
 
-    // What if the file is large? Would be better to copy in smaller fragments
-    boost::scoped_array<char> buffer(new char[SIZE + 1]);
+    const off_t START = static_cast<off_t>(start);
+    const std::streamsize COPIED =
+        CopyInKernel(INPUT.Get( ), OUTPUT.Get( ), START, SIZE);
+    CopyInChunks(INPUT.Get( ), OUTPUT.Get( ), START + COPIED, SIZE - COPIED);
+#endif
+}
+
+std::streamsize Copy::ScanRange(std::ifstream &input,
+                                std::streampos &start) const
+{
+    // if input stream is not open scanners will throw
+    start = startScanner_->Scan(input);
+    const std::streampos END(endScanner_->Scan(input));
 
-    input.seekg(START);
-    input.read(buffer.get( ), SIZE);
-    buffer[SIZE] = '\0';
+    Check<OutOfBounds>(END >= start, "start point after end");
 
-    output << buffer.get( );
+    assert(start >= 0);
+    assert(END >= 0);
+    assert(GetFileSize(input) >= END);
 
-    output.flush( );
+    const std::streamsize SIZE = END - start;
+    assert(SIZE >= 0);
+    return SIZE;
 }
 
 Copy::StreamNotOpen::StreamNotOpen(const std::string &what) :
@@ -92,6 +183,11 @@ Copy::OutOfBounds::OutOfBounds(const std::string &what) :
 {
 }
 
+Copy::Incomplete::Incomplete(const std::string &what) :
+    runtime_error(what)
+{
+}
+
 namespace
 {
 
@@ -113,6 +209,146 @@ std::streampos GetFileSize(std::ifstream &stream)
     return RESULT;
 }
 
+void CopyStream(std::ifstream &input, std::ofstream &output,
+                std::streampos start, std::streamsize size)
+{
+    if (!size)
+    {
+        return;
+    }
+
+    const std::streamsize BUFFER_SIZE = std::min(size, CHUNK_SIZE);
+    boost::scoped_array<char> buffer(new char[BUFFER_SIZE]);
+
+    input.seekg(start);
+    while (size > 0)
+    {
+        input.read(buffer.get( ), std::min(size, BUFFER_SIZE));
+        const std::streamsize READ = input.gcount( );
+        Check<Copy::Incomplete>(READ > 0, "reading input stream failed");
+
+        output.write(buffer.get( ), READ);
+        size -= READ;
+    }
+
+    output.flush( );
+    Check<Copy::Incomplete>(output.good( ), "writing output stream failed");
+}
+
+#ifndef WIN32
+
+Descriptor::Descriptor(int descriptor) :
+    DESCRIPTOR_(descriptor)
+{
+}
+
+Descriptor::~Descriptor( )
+{
+    if (DESCRIPTOR_ >= 0)
+    {
+        close(DESCRIPTOR_);
+    }
+}
+
+int Descriptor::Get( ) const
+{
+    return DESCRIPTOR_;
+}
+
+std::streamsize CopyInKernel(int input, int output, off_t start,
+                             std::streamsize size)
+{
+    std::streamsize copied = 0;
+
+#ifdef __linux__
+    off_t offset = start;
+
+#ifdef MYRRH_COPY_FILE_RANGE
+    while (copied < size)
+    {
+        const std::size_t COUNT = static_cast<std::size_t>(
+            std::min(size - copied, KERNEL_CHUNK_SIZE));
+        const ssize_t RESULT =
+            copy_file_range(input, &offset, output, 0, COUNT, 0);
+        if (RESULT < 0 && EINTR == errno)
+        {
+            continue;
+        }
+
+        if (RESULT <= 0)
+        {
+            // For instance older kernels cannot copy between filesystems
+            break;
+        }
+
+        copied += RESULT;
+    }
+#endif
+
+    while (copied < size)
+    {
+        const std::size_t COUNT = static_cast<std::size_t>(
+            std::min(size - copied, KERNEL_CHUNK_SIZE));
+        const ssize_t RESULT = sendfile(output, input, &offset, COUNT);
+        if (RESULT < 0 && EINTR == errno)
+        {
+            continue;
+        }
+
+        if (RESULT <= 0)
+        {
+            break;
+        }
+
+        copied += RESULT;
+    }
+#endif
+
+    return copied;
+}
+
+void CopyInChunks(int input, int output, off_t start, std::streamsize size)
+{
+    if (size <= 0)
+    {
+        return;
+    }
+
+    const std::streamsize BUFFER_SIZE = std::min(size, CHUNK_SIZE);
+    boost::scoped_array<char> buffer(new char[BUFFER_SIZE]);
+
+    while (size > 0)
+    {
+        const ssize_t READ = pread(input, buffer.get( ),
+                                   std::min(size, BUFFER_SIZE), start);
+        if (READ < 0 && EINTR == errno)
+        {
+            continue;
+        }
+
+        Check<Copy::Incomplete>(READ > 0, "reading input file failed");
+
+        for (ssize_t written = 0; written < READ; )
+        {
+            const ssize_t RESULT =
+                write(output, buffer.get( ) + written, READ - written);
+            if (RESULT < 0 && EINTR == errno)
+            {
+                continue;
+            }
+
+            // If nothing was written, trying again would loop for ever
+            Check<Copy::Incomplete>(RESULT > 0, "writing output file failed");
+            written += RESULT;
+        }
+
+        start += READ;
+        size -= READ;
+    }
+}
+
+#endif
+
 }
 
 }
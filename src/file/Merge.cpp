@@ -0,0 +1,234 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains implementation of class myrrh::file::Merge.
+ */
+
+#include "myrrh/file/Merge.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "boost/shared_ptr.hpp"
+
+#include <cstring>
+#include <ostream>
+#include <queue>
+#include <vector>
+
+namespace myrrh
+{
+
+namespace file
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * Reads one memory mapped input file record by record. The records are
+ * written from the mapped memory. Each line is copied into line_ for the key
+ * function, and the key of the current record into key_.
+ */
+class Source
+{
+public:
+
+    Source(const boost::filesystem::path &path, std::size_t index,
+           const Merge::KeyLength &keyLength);
+
+    /// Reads the next record, returns false if there are no more records
+    bool Next( );
+
+    void Write(std::ostream &output) const;
+
+    /// Tells whether this source should be written before the other one
+    bool IsBefore(const Source &other) const;
+
+private:
+
+    /// Moves position_ past the next line and copies the line into line_,
+    /// whose capacity is reused
+    void ReadLine( );
+
+    boost::interprocess::mapped_region region_;
+    const char *position_;
+    const char *end_;
+    std::size_t index_;
+    const Merge::KeyLength &keyLength_;
+    std::string key_;
+    const char *recordBegin_;
+    const char *recordEnd_;
+    /// Reused for passing the lines to keyLength_
+    std::string line_;
+};
+
+typedef boost::shared_ptr<Source> SourcePtr;
+
+/**
+ * Orders the priority queue so that the earliest source is on top
+ */
+struct IsLater
+{
+    bool operator( )(const SourcePtr &left, const SourcePtr &right) const;
+};
+
+}
+
+// Class implementations
+
+Merge::Merge(const PathStore &inputs, KeyLength keyLength) :
+    inputs_(inputs),
+    keyLength_(keyLength)
+{
+}
+
+void Merge::operator( )(std::ostream &output) const
+{
+    std::priority_queue<SourcePtr, std::vector<SourcePtr>, IsLater> queue;
+
+    for (std::size_t i = 0; i < inputs_.size( ); ++i)
+    {
+        SourcePtr source(new Source(inputs_[i], i, keyLength_));
+        if (source->Next( ))
+        {
+            queue.push(source);
+        }
+    }
+
+    while (!queue.empty( ))
+    {
+        SourcePtr source(queue.top( ));
+        queue.pop( );
+        source->Write(output);
+        if (source->Next( ))
+        {
+            queue.push(source);
+        }
+    }
+
+    output.flush( );
+}
+
+Merge::CannotOpen::CannotOpen(const std::string &what) :
+    runtime_error(what)
+{
+}
+
+// Local implementations
+
+namespace
+{
+
+Source::Source(const boost::filesystem::path &path, std::size_t index,
+               const Merge::KeyLength &keyLength) :
+    position_(0),
+    end_(0),
+    index_(index),
+    keyLength_(keyLength),
+    recordBegin_(0),
+    recordEnd_(0)
+{
+    using namespace boost::interprocess;
+
+    try
+    {
+        // Empty files cannot be mapped, but there is nothing to merge in
+        // them either.
+        if (boost::filesystem::file_size(path))
+        {
+            // The mapping stays valid after the file is closed, so the count
+            // of inputs is not limited by the count of open files.
+            file_mapping file(path.string( ).c_str( ), read_only);
+            mapped_region(file, read_only).swap(region_);
+        }
+    }
+    catch (const std::exception &)
+    {
+        throw Merge::CannotOpen("Merge failed: cannot open " + path.string( ));
+    }
+
+    position_ = static_cast<const char *>(region_.get_address( ));
+    end_ = position_ + region_.get_size( );
+}
+
+bool Source::Next( )
+{
+    if (position_ == end_)
+    {
+        return false;
+    }
+
+    // Lines before the first key of the file form a record with an empty
+    // key, so that they are written first.
+    recordBegin_ = position_;
+    ReadLine( );
+    key_.assign(line_, 0, keyLength_(line_));
+
+    while (position_ != end_)
+    {
+        const char *lineBegin = position_;
+        ReadLine( );
+        if (keyLength_(line_))
+        {
+            position_ = lineBegin;
+            break;
+        }
+    }
+
+    recordEnd_ = position_;
+
+    return true;
+}
+
+void Source::ReadLine( )
+{
+    const char *lineEnd = static_cast<const char *>(
+        std::memchr(position_, '\n', end_ - position_));
+    if (!lineEnd)
+    {
+        lineEnd = end_;
+    }
+
+    line_.assign(position_, lineEnd);
+    position_ = lineEnd == end_ ? end_ : lineEnd + 1;
+}
+
+void Source::Write(std::ostream &output) const
+{
+    output.write(recordBegin_,
+                 static_cast<std::streamsize>(recordEnd_ - recordBegin_));
+
+    // The last line of a file may lack the line feed
+    if (recordEnd_[-1] != '\n')
+    {
+        output.put('\n');
+    }
+}
+
+bool Source::IsBefore(const Source &other) const
+{
+    const int RESULT = key_.compare(other.key_);
+    if (RESULT)
+    {
+        return RESULT < 0;
+    }
+
+    return index_ < other.index_;
+}
+
+bool IsLater::operator( )(const SourcePtr &left, const SourcePtr &right) const
+{
+    return right->IsBefore(*left);
+}
+
+}
+
+}
+
+}
@@ -12,6 +12,8 @@
 
 #include "myrrh/file/PositionScanner.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace myrrh
@@ -24,8 +26,33 @@ namespace
 
 void CheckStream(const std::ifstream &stream);
 std::streampos EndPosition(std::ifstream &stream);
+
+/**
+ * The size of the blocks read at a time. The blocks are aligned to its
+ * multiples, which avoids reading partial file system blocks.
+ */
+const std::streamoff BLOCK_SIZE = 16 * 1024;
+
+/**
+ * Finds the start of the line after the line end at or after the given
+ * position. The blocks are searched with memchr, which is vectorized on
+ * most platforms.
+ */
 std::streampos SeekNextLineStart(std::ifstream &stream, std::streampos toSeek,
                                  std::streampos end);
+
+/**
+ * Finds the start of the line that contains the given position. Can be the
+ * given position itself.
+ */
+std::streampos SeekPreviousLineStart(std::ifstream &stream,
+                                     std::streampos point);
+
+/**
+ * Returns the last line end in the given data, or 0 if there is none
+ */
+const char *FindLastLineEnd(const char *data, std::size_t size);
+
 class StreamStateReset
 {
 public:
@@ -118,6 +145,23 @@ std::streampos ScanFromEnd::DoScan(std::ifstream &stream) const
     return SeekNextLineStart(stream, END_POS - BYTES_FROM_END_, END_POS);
 }
 
+ScanBackFromEnd::ScanBackFromEnd(std::streamsize bytesFromEnd) :
+    BYTES_FROM_END_(bytesFromEnd)
+{
+}
+
+std::streampos ScanBackFromEnd::DoScan(std::ifstream &stream) const
+{
+    const std::streampos END_POS = EndPosition(stream);
+
+    if (BYTES_FROM_END_ >= END_POS)
+    {
+        return std::streampos(0);
+    }
+
+    return SeekPreviousLineStart(stream, END_POS - BYTES_FROM_END_);
+}
+
 namespace
 {
 
@@ -146,23 +190,84 @@ inline StreamStateReset::~StreamStateReset( )
     stream_.seekg(POSITION_);
 }
 
-inline std::streampos SeekNextLineStart(std::ifstream &stream,
-                                        std::streampos toSeek,
-                                        std::streampos end)
+std::streampos SeekNextLineStart(std::ifstream &stream, std::streampos toSeek,
+                                 std::streampos end)
 {
+    char buffer[BLOCK_SIZE];
+    std::streamoff position = toSeek;
     stream.seekg(toSeek);
-    stream.ignore(end - toSeek, '\n');
 
-    if (stream.good( ))
+    while (position < end)
     {
-        return stream.tellg( );
+        const std::streamsize COUNT =
+            std::min<std::streamoff>(end - position,
+                                     BLOCK_SIZE - position % BLOCK_SIZE);
+        if (!stream.read(buffer, COUNT))
+        {
+            /// @todo This will clear also any original stream errors.
+            stream.clear( );
+            return end;
+        }
+
+        const char *LINE_END =
+            static_cast<const char *>(std::memchr(buffer, '\n', COUNT));
+        if (LINE_END)
+        {
+            return position + (LINE_END - buffer) + 1;
+        }
+
+        position += COUNT;
     }
 
-    /// @todo This will clear also any original stream errors.
-    stream.clear( );
     return end;
 }
 
+std::streampos SeekPreviousLineStart(std::ifstream &stream,
+                                     std::streampos point)
+{
+    char buffer[BLOCK_SIZE];
+    std::streamoff position = point;
+
+    while (position > 0)
+    {
+        const std::streamoff REMAINDER = position % BLOCK_SIZE;
+        const std::streamsize COUNT = REMAINDER ? REMAINDER : BLOCK_SIZE;
+        position -= COUNT;
+
+        stream.seekg(position);
+        if (!stream.read(buffer, COUNT))
+        {
+            stream.clear( );
+            return point;
+        }
+
+        const char *LINE_END = FindLastLineEnd(buffer, COUNT);
+        if (LINE_END)
+        {
+            return position + (LINE_END - buffer) + 1;
+        }
+    }
+
+    return std::streampos(0);
+}
+
+inline const char *FindLastLineEnd(const char *data, std::size_t size)
+{
+#ifdef __GLIBC__
+    return static_cast<const char *>(memrchr(data, '\n', size));
+#else
+    while (size)
+    {
+        if ('\n' == data[--size])
+        {
+            return data + size;
+        }
+    }
+
+    return 0;
+#endif
+}
+
 }
 
 }
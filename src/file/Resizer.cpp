@@ -12,10 +12,10 @@
 #include "myrrh/file/Resizer.hpp"
 
 #include "myrrh/file/Copy.hpp"
+#include "myrrh/file/PositionScanner.hpp"
 #include "myrrh/file/SafeModify.hpp"
 #include "boost/filesystem/path.hpp"
 #include "boost/filesystem/operations.hpp"
-#include <fstream>
 
 namespace myrrh
 {
@@ -29,13 +29,6 @@ namespace
 
 void CopyFromTemporary(const Copy &copier,
                        const boost::filesystem::path &fileName);
-template <typename Stream>
-void Open(Stream &stream, const boost::filesystem::path &path,
-          const std::string &errorString);
-template <typename Stream>
-std::ios::openmode GetOpenMode( );
-template <>
-std::ios::openmode GetOpenMode<std::ifstream>( );
 
 }
 
@@ -106,47 +99,27 @@ void Resizer::Implementation::Resize( ) const
 namespace
 {
 
-// Refactor to smaller to avoid the need for comments. Or is the code just
-// self-explanatory?
 void CopyFromTemporary(const Copy &copier,
                        const boost::filesystem::path &fileName)
 {
-    // Open the original file for input. Note that at this point the original
-    // file is renamed as temporaray file.
-    std::ifstream input;
-    const std::string TMP_FILE_NAME(file::SafeModify::Name(fileName));
-    Open(input, TMP_FILE_NAME, "Failed to open input file for resizing");
-
-    // Open the temporary output file with the original file name
-    std::ofstream output;
-    Open(output, fileName.string( ), "Failed to open output file for resizing");
-
-    // Copy the original contents to the new file
-    copier(input, output);
-}
+    // Note that at this point the original file is renamed as temporary file.
+    // The contents are copied to a new file with the original file name.
+    const boost::filesystem::path TMP_FILE(file::SafeModify::Name(fileName));
 
-template <typename Stream>
-void Open(Stream &stream, const boost::filesystem::path &path,
-          const std::string &errorString)
-{
-    stream.open(path.string( ).c_str( ),
-                std::ios::binary | GetOpenMode<Stream>( ));
-    if (stream.fail( ))
+    try
     {
-        throw Resizer::CannotOpen(errorString + ": " + path.string( ));
+        copier(TMP_FILE, fileName);
+    }
+    catch (const PositionScanner::NotOpen &)
+    {
+        throw Resizer::CannotOpen("Failed to open input file for resizing: " +
+                                  TMP_FILE.string( ));
+    }
+    catch (const Copy::StreamNotOpen &)
+    {
+        throw Resizer::CannotOpen("Failed to open output file for resizing: " +
+                                  fileName.string( ));
     }
-}
-
-template <typename Stream>
-inline std::ios::openmode GetOpenMode( )
-{
-    return std::ios::out;
-}
-
-template <>
-inline std::ios::openmode GetOpenMode<std::ifstream>( )
-{
-    return std::ios::in;
 }
 
 }
@@ -0,0 +1,328 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementations of functions
+ * myrrh::file::ScanFolder and myrrh::file::ScanFolders.
+ */
+
+#include "myrrh/file/ScanFolder.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/scoped_array.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <algorithm>
+#include <exception>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace myrrh
+{
+
+namespace file
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * Scans the folders given out by Next( ) until all have been scanned. Several
+ * threads may run the same Worker.
+ */
+class Worker
+{
+public:
+
+    Worker(const PathStore &folders, const NameMatcher &matcher,
+           std::vector<EntryStore> &results);
+
+    void operator( )( );
+
+    /// Rethrows the first error caught by the threads
+    void Rethrow( ) const;
+
+private:
+
+    /// Gives the index of the next folder to scan
+    bool Next(std::size_t &index);
+
+    typedef boost::mutex::scoped_lock Lock;
+
+    const PathStore &FOLDERS_;
+    const NameMatcher &MATCHER_;
+    std::vector<EntryStore> &results_;
+    std::size_t next_;
+    std::exception_ptr error_;
+    boost::mutex mutex_;
+};
+
+#ifdef __linux__
+
+/// The size of the buffer into which the entries are read at a time
+const std::size_t BUFFER_SIZE = 64 * 1024;
+
+/**
+ * Owns a descriptor and closes it on destruction
+ */
+class Descriptor
+{
+public:
+
+    explicit Descriptor(int descriptor);
+    ~Descriptor( );
+
+    int Get( ) const;
+
+private:
+
+    Descriptor(const Descriptor &);
+    Descriptor &operator=(const Descriptor &);
+
+    const int DESCRIPTOR_;
+};
+
+/**
+ * Throws a filesystem_error describing the current errno
+ */
+void ThrowError(const boost::filesystem::path &folder);
+
+/**
+ * Tells if the entry is a directory. Only symbolic links and unknown types
+ * need to be checked with stat.
+ */
+bool IsDirectory(int folder, const char *name, unsigned char type);
+
+#endif
+
+}
+
+// Function implementations
+
+EntryStore ScanFolder(const boost::filesystem::path &folder,
+                      const NameMatcher &matcher)
+{
+    EntryStore result;
+
+#ifdef __linux__
+    const Descriptor FOLDER(open(folder.string( ).c_str( ),
+                                 O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (FOLDER.Get( ) < 0)
+    {
+        ThrowError(folder);
+    }
+
+    boost::scoped_array<char> buffer(new char[BUFFER_SIZE]);
+    for (;;)
+    {
+        const long READ = syscall(SYS_getdents64, FOLDER.Get( ), buffer.get( ),
+                                  BUFFER_SIZE);
+        if (READ < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            ThrowError(folder);
+        }
+
+        if (!READ)
+        {
+            break;
+        }
+
+        for (long offset = 0; offset < READ; )
+        {
+            const dirent64 *ENTRY =
+                reinterpret_cast<const dirent64 *>(buffer.get( ) + offset);
+            offset += ENTRY->d_reclen;
+
+            const char *NAME = ENTRY->d_name;
+            if (!std::strcmp(NAME, ".") || !std::strcmp(NAME, "..") ||
+                !matcher(NAME))
+            {
+                continue;
+            }
+
+            FolderEntry entry;
+            entry.path = folder / NAME;
+            entry.isDirectory = IsDirectory(FOLDER.Get( ), NAME,
+                                            ENTRY->d_type);
+            result.push_back(entry);
+        }
+    }
+#else
+    using boost::filesystem::directory_iterator;
+    for (directory_iterator i(folder); directory_iterator( ) != i; ++i)
+    {
+        if (matcher(i->path( ).leaf( ).string( )))
+        {
+            FolderEntry entry;
+            entry.path = i->path( );
+            entry.isDirectory = boost::filesystem::is_directory(i->status( ));
+            result.push_back(entry);
+        }
+    }
+#endif
+
+    return result;
+}
+
+EntryStore ScanFolders(const PathStore &folders, const NameMatcher &matcher,
+                       std::size_t threads)
+{
+    std::vector<EntryStore> results(folders.size( ));
+    Worker worker(folders, matcher, results);
+
+    threads = std::min(threads, folders.size( ));
+    if (threads <= 1)
+    {
+        worker( );
+    }
+    else
+    {
+        boost::thread_group group;
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            group.create_thread(boost::ref(worker));
+        }
+
+        group.join_all( );
+    }
+
+    worker.Rethrow( );
+
+    EntryStore result;
+    for (std::vector<EntryStore>::const_iterator i = results.begin( );
+         results.end( ) != i;
+         ++i)
+    {
+        result.insert(result.end( ), i->begin( ), i->end( ));
+    }
+
+    return result;
+}
+
+// Local implementations
+
+namespace
+{
+
+Worker::Worker(const PathStore &folders, const NameMatcher &matcher,
+               std::vector<EntryStore> &results) :
+    FOLDERS_(folders),
+    MATCHER_(matcher),
+    results_(results),
+    next_(0)
+{
+}
+
+void Worker::operator( )( )
+{
+    std::size_t index = 0;
+    while (Next(index))
+    {
+        try
+        {
+            results_[index] = ScanFolder(FOLDERS_[index], MATCHER_);
+        }
+        catch (...)
+        {
+            Lock lock(mutex_);
+            if (!error_)
+            {
+                error_ = std::current_exception( );
+            }
+
+            // The rest of the folders are not scanned
+            next_ = FOLDERS_.size( );
+        }
+    }
+}
+
+void Worker::Rethrow( ) const
+{
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+bool Worker::Next(std::size_t &index)
+{
+    Lock lock(mutex_);
+    if (next_ >= FOLDERS_.size( ))
+    {
+        return false;
+    }
+
+    index = next_++;
+    return true;
+}
+
+#ifdef __linux__
+
+Descriptor::Descriptor(int descriptor) :
+    DESCRIPTOR_(descriptor)
+{
+}
+
+Descriptor::~Descriptor( )
+{
+    if (DESCRIPTOR_ >= 0)
+    {
+        close(DESCRIPTOR_);
+    }
+}
+
+int Descriptor::Get( ) const
+{
+    return DESCRIPTOR_;
+}
+
+void ThrowError(const boost::filesystem::path &folder)
+{
+    using namespace boost::system;
+    throw boost::filesystem::filesystem_error(
+        "myrrh::file::ScanFolder", folder,
+        error_code(errno, system_category( )));
+}
+
+bool IsDirectory(int folder, const char *name, unsigned char type)
+{
+    if (DT_DIR == type)
+    {
+        return true;
+    }
+
+    if (DT_LNK != type && DT_UNKNOWN != type)
+    {
+        return false;
+    }
+
+    // Links are followed, as boost::filesystem::is_directory does
+    struct stat status;
+    return !fstatat(folder, name, &status, 0) && S_ISDIR(status.st_mode);
+}
+
+#endif
+
+}
+
+}
+
+}
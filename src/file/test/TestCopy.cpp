@@ -14,6 +14,9 @@
  * -The scanners point from midway to finish
  * -The scanners result in a very small range
  * -The copying is done from a very large file
+ * -The copying is done between files given as paths
+ * -Output file cannot be opened
+ * -Output file cannot be written
  *
  * The following situations are not tested, because they should already be
  * tested in PositionScanner unit tests:
@@ -37,6 +40,7 @@
 #include "boost/filesystem/path.hpp"
 #include "boost/test/unit_test.hpp"
 #include "boost/scoped_array.hpp"
+#include "boost/lexical_cast.hpp"
 
 #ifdef WIN32
 #pragma warning (pop)
@@ -57,6 +61,9 @@ void CopyFileEntirely( );
 void CopyFromMiddleToEnd( );
 void CopySmallRange( );
 void CopyLargeRange( );
+void CopyLargeRangeBetweenFiles( );
+void OutputFileNotOpen( );
+void OutputFileNotWritten( );
 std::string GetFileContent(const boost::filesystem::path &path);
 
 // Declarations for helper function
@@ -156,6 +163,9 @@ TestSuite *init_unit_test_suite(int, char *[])
     test->add(BOOST_TEST_CASE(CopyFromMiddleToEnd));
     test->add(BOOST_TEST_CASE(CopySmallRange));
     test->add(BOOST_TEST_CASE(CopyLargeRange));
+    test->add(BOOST_TEST_CASE(CopyLargeRangeBetweenFiles));
+    test->add(BOOST_TEST_CASE(OutputFileNotOpen));
+    test->add(BOOST_TEST_CASE(OutputFileNotWritten));
 
     return test;
 }
@@ -360,6 +370,60 @@ void CopyLargeRange( )
     testCase( );
 }
 
+void CopyLargeRangeBetweenFiles( )
+{
+    const std::string FILE_NAME("LargeFile.txt");
+    const std::string OUTPUT_NAME("output.txt");
+    Eraser fileDeleter(FILE_NAME.c_str( ));
+    Eraser outputDeleter(OUTPUT_NAME.c_str( ));
+
+    std::string content;
+    for (int i = 0; i < 200000; ++i)
+    {
+        content += boost::lexical_cast<std::string>(i) + '\n';
+    }
+
+    // A null character used to end the copying before it was done in chunks
+    content[200000] = '\0';
+
+    {
+        std::ofstream output(FILE_NAME.c_str( ), std::ios::binary);
+        BOOST_REQUIRE(output.is_open( ));
+        output << content;
+    }
+
+    typedef HardCodedScanner<123456> Start;
+    typedef HardCodedScanner<654321> End;
+    Copy copier(PositionScannerPtr(new Start), PositionScannerPtr(new End));
+    copier(FILE_NAME, OUTPUT_NAME);
+
+    const std::string EXPECTED(
+        content.substr(Start::ScanPoint, End::ScanPoint - Start::ScanPoint));
+    BOOST_CHECK(EXPECTED == GetFileContent(OUTPUT_NAME));
+}
+
+void OutputFileNotOpen( )
+{
+    Copy copier(PositionScannerPtr(new myrrh::file::StartScanner),
+                PositionScannerPtr(new myrrh::file::EndScanner));
+
+    BOOST_CHECK_THROW(copier(Path(Files::SEVERAL_LINES),
+                             "nonexistent/output.txt"),
+                      Copy::StreamNotOpen);
+}
+
+void OutputFileNotWritten( )
+{
+#ifdef __linux__
+    Copy copier(PositionScannerPtr(new myrrh::file::StartScanner),
+                PositionScannerPtr(new myrrh::file::EndScanner));
+
+    // Each write to the device fails as if the disk was full
+    BOOST_CHECK_THROW(copier(Path(Files::SEVERAL_LINES), "/dev/full"),
+                      Copy::Incomplete);
+#endif
+}
+
 template <int Value>
 std::streampos HardCodedScanner<Value>::DoScan(std::ifstream &) const
 {
@@ -0,0 +1,144 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for Merge
+ */
+
+#include "myrrh/file/Merge.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/filesystem/fstream.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <sstream>
+
+using namespace myrrh::file;
+
+// Local helper declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("mergeTestFiles");
+
+/// Lines starting with a digit are keyed with a single character
+std::size_t DigitKey(const std::string &line);
+
+boost::filesystem::path CreateFile(const std::string &name,
+                                   const std::string &content);
+
+std::string RunMerge(const PathStore &inputs);
+
+boost::filesystem::path CreateFolder( );
+
+class TestCase
+{
+public:
+    TestCase( );
+private:
+    Eraser eraser_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(NoInputs)
+{
+    BOOST_CHECK_EQUAL("", RunMerge(PathStore( )));
+}
+
+BOOST_AUTO_TEST_CASE(MissingInput)
+{
+    PathStore inputs;
+    inputs.push_back(FOLDER / "doesNotExist");
+    std::ostringstream output;
+    BOOST_CHECK_THROW(Merge(inputs, DigitKey)(output), Merge::CannotOpen);
+}
+
+BOOST_AUTO_TEST_CASE(SingleInput)
+{
+    TestCase testCase;
+    PathStore inputs;
+    inputs.push_back(CreateFile("a", "1 a\n2 b\n"));
+    BOOST_CHECK_EQUAL("1 a\n2 b\n", RunMerge(inputs));
+}
+
+BOOST_AUTO_TEST_CASE(InterleavedInputs)
+{
+    TestCase testCase;
+    PathStore inputs;
+    inputs.push_back(CreateFile("a", "1 a\n4 a\n5 a\n"));
+    inputs.push_back(CreateFile("b", "2 b\n3 b\n6 b\n"));
+    inputs.push_back(CreateFile("c", ""));
+    BOOST_CHECK_EQUAL("1 a\n2 b\n3 b\n4 a\n5 a\n6 b\n", RunMerge(inputs));
+}
+
+BOOST_AUTO_TEST_CASE(EqualKeysKeepInputOrder)
+{
+    TestCase testCase;
+    PathStore inputs;
+    inputs.push_back(CreateFile("a", "1 a\n"));
+    inputs.push_back(CreateFile("b", "1 b\n"));
+    BOOST_CHECK_EQUAL("1 a\n1 b\n", RunMerge(inputs));
+}
+
+BOOST_AUTO_TEST_CASE(ContinuationLinesStayWithRecord)
+{
+    TestCase testCase;
+    PathStore inputs;
+    inputs.push_back(CreateFile("a", "orphan\n1 a\n  more a\n3 a\n"));
+    inputs.push_back(CreateFile("b", "2 b\n  more b\n  still b"));
+    BOOST_CHECK_EQUAL("orphan\n1 a\n  more a\n2 b\n  more b\n  still b\n3 a\n",
+                      RunMerge(inputs));
+}
+
+// Local helper implementations
+
+namespace
+{
+
+std::size_t DigitKey(const std::string &line)
+{
+    return !line.empty( ) && std::isdigit(line[0]) ? 1 : 0;
+}
+
+boost::filesystem::path CreateFile(const std::string &name,
+                                   const std::string &content)
+{
+    const boost::filesystem::path PATH(FOLDER / name);
+    boost::filesystem::ofstream file(PATH, std::ios::binary);
+    file << content;
+    return PATH;
+}
+
+std::string RunMerge(const PathStore &inputs)
+{
+    std::ostringstream output;
+    Merge merge(inputs, DigitKey);
+    merge(output);
+    return output.str( );
+}
+
+TestCase::TestCase( ) :
+    eraser_(CreateFolder( ))
+{
+}
+
+boost::filesystem::path CreateFolder( )
+{
+    boost::filesystem::create_directory(FOLDER);
+    return FOLDER;
+}
+
+}
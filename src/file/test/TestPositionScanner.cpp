@@ -57,6 +57,7 @@ void AddBasicCases(TestSuite *suite);
 void AddToStartCases(TestSuite *suite);
 void AddScanFromStartPointCases(TestSuite *suite);
 void AddScanFromEndPointCases(TestSuite *suite);
+void AddScanBackFromEndPointCases(TestSuite *suite);
 
 template <typename T>
 boost::unit_test::test_case *NewCase(T caseFunction);
@@ -171,6 +172,13 @@ struct ScanFromEndOutcome
                                    const Params &params);
 };
 
+struct ScanBackFromEndOutcome
+{
+    template <typename Params>
+    std::streampos ExpectedOutcome(const boost::filesystem::path &path,
+                                   const Params &params);
+};
+
 struct NoSetup
 {
     template <typename T>
@@ -254,6 +262,14 @@ struct ScanFromEndTypes
     typedef ScanFromEndOutcome ExpectedOutcome;
 };
 
+template <typename PointCalculator>
+struct ScanBackFromEndTypes
+{
+    typedef ScanBackFromEnd Scanner;
+    typedef PointParams<PointCalculator> Params;
+    typedef ScanBackFromEndOutcome ExpectedOutcome;
+};
+
 TestSuite *init_unit_test_suite(int, char *[])
 {
     TestSuite* test = BOOST_TEST_SUITE("Test suite for PositionScanner");
@@ -261,6 +277,7 @@ TestSuite *init_unit_test_suite(int, char *[])
     AddBasicCases<EndScannerTypes>(test);
     AddScanFromStartPointCases(test);
     AddScanFromEndPointCases(test);
+    AddScanBackFromEndPointCases(test);
 
     return test;
 }
@@ -344,6 +361,14 @@ void AddScanFromEndPointCases(TestSuite *suite)
     AddBasicCases<ScanFromEndTypes<TwiceFileSize> >(suite);
 }
 
+void AddScanBackFromEndPointCases(TestSuite *suite)
+{
+    AddBasicCases<ScanBackFromEndTypes<BeginningOfFile> >(suite);
+    AddBasicCases<ScanBackFromEndTypes<EndOfFile> >(suite);
+    AddBasicCases<ScanBackFromEndTypes<MiddleOfFile> >(suite);
+    AddBasicCases<ScanBackFromEndTypes<TwiceFileSize> >(suite);
+}
+
 template <typename T>
 boost::unit_test::test_case *NewCase(T caseFunction)
 {
@@ -501,6 +526,29 @@ ExpectedOutcome(const boost::filesystem::path &path, const Params &params)
     return static_cast<std::streamsize>(NEXT_END_OF_LINE +1);
 }
 
+template <typename Params>
+std::streampos ScanBackFromEndOutcome::
+ExpectedOutcome(const boost::filesystem::path &path, const Params &params)
+{
+    const std::streamsize POINT = params.GetParam1(params);
+    const std::streamsize SIZE = FileEndPosition(path);
+
+    if (POINT >= SIZE)
+    {
+        return std::streampos(0);
+    }
+
+    const std::string CONTENT = GetContent(path);
+    const std::size_t PREVIOUS_END_OF_LINE =
+        CONTENT.rfind('\n', static_cast<std::size_t>(SIZE - POINT - 1));
+    if (std::string::npos == PREVIOUS_END_OF_LINE)
+    {
+        return std::streampos(0);
+    }
+
+    return static_cast<std::streamsize>(PREVIOUS_END_OF_LINE +1);
+}
+
 template <typename T>
 inline NoSetup::NoSetup(T &)
 {
@@ -0,0 +1,167 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for ScanFolder and ScanFolders
+ */
+
+#include "myrrh/file/ScanFolder.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/lexical_cast.hpp"
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <algorithm>
+#include <fstream>
+
+using namespace myrrh::file;
+
+// Local declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("scanFolderTest");
+
+bool MatchAll(const std::string &name);
+bool IsLog(const std::string &name);
+void CreateFile(const boost::filesystem::path &path);
+PathStore Paths(const EntryStore &entries);
+
+}
+
+BOOST_AUTO_TEST_CASE(FolderDoesNotExist)
+{
+    try
+    {
+        ScanFolder("A/path/That/Definitely/Does/Not/Exist", MatchAll);
+        BOOST_ERROR("Passing path to unexisting folder should throw");
+    }
+    catch (const boost::filesystem::filesystem_error &)
+    {
+    }
+}
+
+BOOST_AUTO_TEST_CASE(EmptyFolder)
+{
+    Eraser eraser(FOLDER);
+    boost::filesystem::create_directory(FOLDER);
+    BOOST_CHECK(ScanFolder(FOLDER, MatchAll).empty( ));
+}
+
+BOOST_AUTO_TEST_CASE(NamesAreMatched)
+{
+    Eraser eraser(FOLDER);
+    boost::filesystem::create_directory(FOLDER);
+    CreateFile(FOLDER / "1.log");
+    CreateFile(FOLDER / "2.txt");
+    CreateFile(FOLDER / "3.log");
+
+    PathStore found(Paths(ScanFolder(FOLDER, IsLog)));
+    std::sort(found.begin( ), found.end( ));
+
+    PathStore expected;
+    expected.push_back(FOLDER / "1.log");
+    expected.push_back(FOLDER / "3.log");
+    BOOST_CHECK(expected == found);
+}
+
+BOOST_AUTO_TEST_CASE(DirectoriesAreTold)
+{
+    Eraser eraser(FOLDER);
+    boost::filesystem::create_directories(FOLDER / "folder.log");
+    CreateFile(FOLDER / "file.log");
+
+    const EntryStore FOUND(ScanFolder(FOLDER, MatchAll));
+    BOOST_REQUIRE_EQUAL(2u, FOUND.size( ));
+    for (EntryStore::const_iterator i = FOUND.begin( ); FOUND.end( ) != i; ++i)
+    {
+        BOOST_CHECK_EQUAL(boost::filesystem::is_directory(i->path),
+                          i->isDirectory);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SeveralFoldersInOrder)
+{
+    Eraser eraser(FOLDER);
+    PathStore folders;
+    PathStore expected;
+    for (int i = 0; i < 16; ++i)
+    {
+        const boost::filesystem::path SUB_FOLDER(
+            FOLDER / boost::lexical_cast<std::string>(i));
+        boost::filesystem::create_directories(SUB_FOLDER);
+        CreateFile(SUB_FOLDER / "file.log");
+        CreateFile(SUB_FOLDER / "file.txt");
+        folders.push_back(SUB_FOLDER);
+        expected.push_back(SUB_FOLDER / "file.log");
+    }
+
+    BOOST_CHECK(expected == Paths(ScanFolders(folders, IsLog)));
+    BOOST_CHECK(expected == Paths(ScanFolders(folders, IsLog, 4)));
+}
+
+BOOST_AUTO_TEST_CASE(ErrorFromParallelScan)
+{
+    Eraser eraser(FOLDER);
+    boost::filesystem::create_directories(FOLDER / "1");
+    PathStore folders;
+    folders.push_back(FOLDER / "1");
+    folders.push_back(FOLDER / "2");
+
+    try
+    {
+        ScanFolders(folders, MatchAll, 2);
+        BOOST_ERROR("Scanning unexisting folder should throw");
+    }
+    catch (const boost::filesystem::filesystem_error &)
+    {
+    }
+}
+
+// Local implementations
+
+namespace
+{
+
+bool MatchAll(const std::string &)
+{
+    return true;
+}
+
+bool IsLog(const std::string &name)
+{
+    return boost::filesystem::path(name).extension( ) == ".log";
+}
+
+void CreateFile(const boost::filesystem::path &path)
+{
+    std::ofstream file(path.string( ).c_str( ));
+    BOOST_REQUIRE(file.is_open( ));
+}
+
+PathStore Paths(const EntryStore &entries)
+{
+    PathStore result;
+    for (EntryStore::const_iterator i = entries.begin( );
+         entries.end( ) != i;
+         ++i)
+    {
+        result.push_back(i->path);
+    }
+
+    return result;
+}
+
+}
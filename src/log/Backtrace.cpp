@@ -0,0 +1,96 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of class myrrh::log::Backtrace.
+ */
+
+#include "myrrh/log/Backtrace.hpp"
+
+#include <cassert>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+// Local declarations
+
+namespace
+{
+
+/// The memory reserved for each slot in advance. Should be enough for most of
+/// the lines, including the header.
+const std::size_t SLOT_CAPACITY = 256;
+
+}
+
+// Class implementations
+
+Backtrace::Backtrace(std::size_t size, VerbosityLevel capture,
+                     VerbosityLevel trigger) :
+    slots_(size),
+    next_(0),
+    count_(0),
+    capture_(capture),
+    trigger_(trigger)
+{
+    assert(size && "Backtrace without slots is useless");
+
+    for (std::size_t i = 0; i < slots_.size( ); ++i)
+    {
+        slots_[i].line.reserve(SLOT_CAPACITY);
+    }
+}
+
+bool Backtrace::IsCaptured(VerbosityLevel verbosity) const
+{
+    return capture_ >= verbosity;
+}
+
+bool Backtrace::IsTrigger(VerbosityLevel verbosity) const
+{
+    return trigger_ >= verbosity;
+}
+
+void Backtrace::Store(const std::string &line, VerbosityLevel verbosity)
+{
+    if (!IsCaptured(verbosity))
+    {
+        return;
+    }
+
+    Slot &slot = slots_[next_];
+    slot.line.assign(line);
+    slot.verbosity = verbosity;
+
+    next_ = (next_ + 1) % slots_.size( );
+    if (count_ < slots_.size( ))
+    {
+        ++count_;
+    }
+}
+
+void Backtrace::Flush(Visitor visitor)
+{
+    const std::size_t SIZE = slots_.size( );
+    const std::size_t OLDEST = (next_ + SIZE - count_) % SIZE;
+
+    // The ring is emptied before visiting, so that an exception from the
+    // visitor does not cause the same lines to be flushed again.
+    const std::size_t COUNT = count_;
+    count_ = 0;
+
+    for (std::size_t i = 0; i < COUNT; ++i)
+    {
+        const Slot &slot = slots_[(OLDEST + i) % SIZE];
+        visitor(slot.line, slot.verbosity);
+    }
+}
+
+}
+
+}
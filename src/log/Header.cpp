@@ -4,13 +4,15 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 
 /**
- * The file contains the non-inline implementation of class TimestampHeader.
+ * The file contains the non-inline implementation of class TimestampHeader and
+ * function TimestampKey.
  *
  * $Id: Header.cpp 286 2007-03-18 15:04:53Z Byon $
  */
 
 #include "myrrh/log/Header.hpp"
 #include "boost/date_time/posix_time/posix_time.hpp"
+#include <cctype>
 #include <ostream>
 
 namespace myrrh
@@ -19,6 +21,16 @@ namespace myrrh
 namespace log
 {
 
+// Local declarations
+
+namespace
+{
+
+/// The form of the timestamp written by TimestampHeader, 'd' marks a digit
+const std::string TIMESTAMP_FORM("dddd.dd.dd dd:dd:dd.dddddd");
+
+}
+
 // Class implementations
 
 void TimestampHeader::Write(std::ostream &stream, char id)
@@ -30,6 +42,30 @@ void TimestampHeader::Write(std::ostream &stream, char id)
            << " ";
 }
 
+std::function<std::size_t (const std::string &)> TimestampKey( )
+{
+    return [](const std::string &line) -> std::size_t
+    {
+        if (line.size( ) < TIMESTAMP_FORM.size( ))
+        {
+            return 0;
+        }
+
+        for (std::size_t i = 0; i < TIMESTAMP_FORM.size( ); ++i)
+        {
+            const bool IS_DIGIT =
+                std::isdigit(static_cast<unsigned char>(line[i])) != 0;
+            if (IS_DIGIT != ('d' == TIMESTAMP_FORM[i]) ||
+                (!IS_DIGIT && line[i] != TIMESTAMP_FORM[i]))
+            {
+                return 0;
+            }
+        }
+
+        return TIMESTAMP_FORM.size( );
+    };
+}
+
 }
 
 }
@@ -4,6 +4,10 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 
 #include "myrrh/log/Log.hpp"
+#include "myrrh/log/Backtrace.hpp"
+#include "myrrh/log/RepeatFilter.hpp"
+#include "myrrh/log/VerbosityAware.hpp"
+#include "boost/date_time/posix_time/posix_time.hpp"
 #include <algorithm>
 #include <cassert>
 #include <functional>
@@ -23,7 +27,11 @@ void WriteToTargets(const std::string &line, VerbosityLevel verbosity,
                     Log::OutputTargets &targets);
 void WriteLine(const std::string &line, VerbosityLevel verbosity,
                Log::OutputTarget &target);
+void WriteLine(const std::string &line, VerbosityLevel verbosity,
+               std::streambuf &buffer);
 void WriteLine(const std::string &line, std::streambuf& buffer);
+void WriteMissed(const std::string &line, VerbosityLevel verbosity,
+                 const Log &log, Log::OutputTargets &targets);
 
 }
 
@@ -41,6 +49,7 @@ void WriteLine(const std::string &line, std::streambuf& buffer);
 ///       logging. Then the initialization could report errors with exceptions.
 Log::Log( ) :
     verbosity_(INFO),
+    headerLength_(0),
     header_(new (std::nothrow) TimestampHeader)
 {
 }
@@ -63,9 +72,42 @@ Log::OutputGuard Log::AddOutputTarget(std::ostream &target,
     return OutputGuard(this, releaser);
 }
 
+Log::OutputGuard Log::AddOutputTarget(
+    std::ostream &target, VerbosityLevel verbosity,
+    const boost::posix_time::time_duration &repeatWindow)
+{
+    boost::shared_ptr<RepeatFilter> filter(new RepeatFilter(repeatWindow));
+    repeatFilters_[target.rdbuf( )] = filter;
+    targets_.push_back(std::make_pair(target.rdbuf( ), verbosity));
+    auto releaser = [&](void*)
+    {
+        this->EndRepeats(target);
+        target.flush( );
+        this->RemoveOutputTarget(target);
+    };
+    return OutputGuard(this, releaser);
+}
+
+Log::OutputGuard Log::AddBacktrace(std::size_t size, VerbosityLevel capture,
+                                   VerbosityLevel trigger)
+{
+    backtrace_.reset(new Backtrace(size, capture, trigger));
+    boost::shared_ptr<Backtrace> added(backtrace_);
+    auto releaser = [=](void*)
+    {
+        // A newer backtrace must not be removed
+        if (added == this->backtrace_)
+        {
+            this->backtrace_.reset( );
+        }
+    };
+    return OutputGuard(this, releaser);
+}
+
 void Log::RemoveAllOutputTargets( )
 {
     targets_.clear( );
+    repeatFilters_.clear( );
 }
 
 void Log::SetVerbosity(VerbosityLevel newVerbosity)
@@ -102,6 +144,8 @@ void Log::WriteHeader(char id)
     {
         header_->Write(line_, id);
     }
+
+    headerLength_ = static_cast<std::size_t>(line_.tellp( ));
 }
 
 void Log::RemoveOutputTarget(std::ostream &toRemove)
@@ -110,13 +154,34 @@ void Log::RemoveOutputTarget(std::ostream &toRemove)
         { return toRemove.rdbuf( ) == t.first; };
     auto first = std::remove_if(targets_.begin( ), targets_.end( ), finder);
     targets_.erase(first, targets_.end( ));
+    repeatFilters_.erase(toRemove.rdbuf( ));
+}
+
+bool Log::IsAccepted(VerbosityLevel verbosity) const
+{
+    return IsWritable(verbosity) ||
+           (backtrace_ && backtrace_->IsCaptured(verbosity));
 }
 
 void Log::Write(VerbosityLevel verbosity)
 {
     try
     {
-        WriteToTargets(line_.str( ), verbosity, targets_);
+        const std::string LINE(line_.str( ));
+        if (IsWritable(verbosity))
+        {
+            if (backtrace_ && backtrace_->IsTrigger(verbosity))
+            {
+                FlushBacktrace( );
+            }
+
+            WriteToTargets(LINE, verbosity);
+        }
+
+        if (backtrace_)
+        {
+            backtrace_->Store(LINE, verbosity);
+        }
     }
     catch (const std::bad_alloc&)
     {
@@ -130,6 +195,80 @@ void Log::Write(VerbosityLevel verbosity)
     }
 }
 
+void Log::FlushBacktrace( )
+{
+    auto writer = [this](const std::string &line, VerbosityLevel verbosity)
+    {
+        WriteMissed(line, verbosity, *this, this->targets_);
+    };
+    backtrace_->Flush(writer);
+}
+
+void Log::WriteToTargets(const std::string &line, VerbosityLevel verbosity)
+{
+    if (repeatFilters_.empty( ))
+    {
+        myrrh::log::WriteToTargets(line, verbosity, targets_);
+        return;
+    }
+
+    const boost::uint64_t HASH = RepeatFilter::Hash(line, headerLength_);
+    const RepeatFilter::Time NOW(
+        boost::posix_time::microsec_clock::universal_time( ));
+    RepeatFilter::Summary summary;
+
+    for (OutputTargets::iterator i(targets_.begin( )); targets_.end( ) != i;
+         ++i)
+    {
+        if (verbosity > i->second)
+        {
+            continue;
+        }
+
+        RepeatFilters::iterator filter(repeatFilters_.find(i->first));
+        if (repeatFilters_.end( ) != filter)
+        {
+            const bool IS_REPEAT =
+                filter->second->IsRepeat(line, headerLength_, HASH, verbosity,
+                                         NOW, summary);
+            if (!summary.line.empty( ))
+            {
+                WriteLine(summary.line, summary.verbosity, *i->first);
+            }
+
+            if (IS_REPEAT)
+            {
+                continue;
+            }
+        }
+
+        WriteLine(line, verbosity, *i->first);
+    }
+}
+
+void Log::EndRepeats(std::ostream &target)
+{
+    try
+    {
+        RepeatFilters::iterator filter(repeatFilters_.find(target.rdbuf( )));
+        if (repeatFilters_.end( ) == filter)
+        {
+            return;
+        }
+
+        RepeatFilter::Summary summary;
+        filter->second->EndRun(summary);
+        if (!summary.line.empty( ))
+        {
+            WriteLine(summary.line, summary.verbosity, *target.rdbuf( ));
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        // The summary is lost, but the target can still be removed
+    }
+}
+
 // Local implementations
 
 namespace
@@ -147,10 +286,22 @@ void WriteLine(const std::string &line, VerbosityLevel verbosity,
 {
     if (verbosity <= target.second)
     {
-        WriteLine(line, *target.first);
+        WriteLine(line, verbosity, *target.first);
     }
 }
 
+void WriteLine(const std::string &line, VerbosityLevel verbosity,
+               std::streambuf &buffer)
+{
+    VerbosityAware *aware = dynamic_cast<VerbosityAware *>(&buffer);
+    if (aware)
+    {
+        aware->SetVerbosity(verbosity);
+    }
+
+    WriteLine(line, buffer);
+}
+
 void WriteLine(const std::string &line, std::streambuf& buffer)
 {
     const std::streamsize SIZE = static_cast<std::streamsize>(line.size( ));
@@ -164,6 +315,20 @@ void WriteLine(const std::string &line, std::streambuf& buffer)
     }
 }
 
+void WriteMissed(const std::string &line, VerbosityLevel verbosity,
+                 const Log &log, Log::OutputTargets &targets)
+{
+    const bool WAS_WRITTEN = log.IsWritable(verbosity);
+    auto writer = [&](Log::OutputTarget &t)
+    {
+        if (!WAS_WRITTEN || verbosity > t.second)
+        {
+            WriteLine(line, verbosity, *t.first);
+        }
+    };
+    std::for_each(targets.begin( ), targets.end( ), writer);
+}
+
 }
 
 }
@@ -0,0 +1,109 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of class myrrh::log::RepeatFilter.
+ */
+
+#include "myrrh/log/RepeatFilter.hpp"
+
+#include "boost/cstdint.hpp"
+#include "boost/lexical_cast.hpp"
+
+#include <algorithm>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+// Local declarations
+
+namespace
+{
+
+// The constants of 64-bit FNV-1a hash
+const boost::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+const boost::uint64_t FNV_PRIME = 1099511628211ULL;
+
+}
+
+// Class implementations
+
+RepeatFilter::RepeatFilter(const boost::posix_time::time_duration &window) :
+    window_(window),
+    hasPrevious_(false),
+    hash_(0),
+    repeats_(0),
+    verbosity_(INFO)
+{
+}
+
+RepeatFilter::Summary::Summary( ) :
+    verbosity(INFO)
+{
+}
+
+boost::uint64_t RepeatFilter::Hash(const std::string &line,
+                                   std::size_t headerLength)
+{
+    boost::uint64_t result = FNV_OFFSET;
+    const std::size_t BEGIN = std::min(headerLength, line.size( ));
+    for (std::size_t i = BEGIN; i < line.size( ); ++i)
+    {
+        result ^= static_cast<unsigned char>(line[i]);
+        result *= FNV_PRIME;
+    }
+
+    return result;
+}
+
+bool RepeatFilter::IsRepeat(const std::string &line, std::size_t headerLength,
+                            boost::uint64_t hash, VerbosityLevel verbosity,
+                            const Time &now, Summary &summary)
+{
+    const std::size_t HEADER = std::min(headerLength, line.size( ));
+    const std::size_t SIZE = line.size( ) - HEADER;
+
+    // The hash and the size rule out most of the differing lines, before
+    // the payloads are compared
+    if (hasPrevious_ && hash == hash_ && SIZE == payload_.size( ) &&
+        !line.compare(HEADER, SIZE, payload_) && now - start_ < window_)
+    {
+        ++repeats_;
+        header_.assign(line, 0, HEADER);
+        verbosity_ = verbosity;
+        summary.line.clear( );
+        return true;
+    }
+
+    EndRun(summary);
+
+    payload_.assign(line, HEADER, SIZE);
+    hasPrevious_ = true;
+    hash_ = hash;
+    start_ = now;
+
+    return false;
+}
+
+void RepeatFilter::EndRun(Summary &summary)
+{
+    summary.line.clear( );
+    if (repeats_)
+    {
+        summary.line = header_ + "last message repeated " +
+                       boost::lexical_cast<std::string>(repeats_) + " times";
+        summary.verbosity = verbosity_;
+    }
+
+    repeats_ = 0;
+    hasPrevious_ = false;
+}
+
+}
+
+}
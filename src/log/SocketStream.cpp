@@ -0,0 +1,504 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of classes myrrh::log::SocketBuffer
+ * and myrrh::log::SocketStream.
+ */
+
+#include "myrrh/log/SocketStream.hpp"
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+// Local declarations
+
+namespace
+{
+
+/// Tells that there is no socket
+const int NO_DESCRIPTOR = -1;
+
+/**
+ * Result of sending one batch
+ */
+enum SendResult
+{
+    SENT,
+    DISCARDED, ///< The collector will never accept the batch
+    FAILED     ///< The connection is not usable
+};
+
+/**
+ * Opens a non-blocking socket and connects it to the given path
+ * @return The socket or NO_DESCRIPTOR, if the connecting failed
+ */
+int Connect(const std::string &path, SocketBuffer::Type type);
+
+/**
+ * Sends the whole batch. Waits at most the given time for the socket to
+ * become writable between the partial writes.
+ * @param sent Receives the count of bytes sent, also when the sending fails
+ */
+SendResult Send(int descriptor, SocketBuffer::Type type,
+                const std::string &batch, int waitMilliseconds,
+                std::size_t &sent);
+
+std::size_t CountLines(const std::string &batch);
+
+}
+
+class SocketBuffer::Implementation
+{
+public:
+
+    Implementation(const std::string &path, int descriptor, Type type,
+                   std::size_t batchSize, unsigned int flushMilliseconds);
+    ~Implementation( );
+
+    void Add(const std::string &line);
+    std::size_t Dropped( ) const;
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    /// The loop of the background thread
+    void Run( );
+    /// Moves the current batch to the batches that are ready to be sent
+    void FinishBatch( );
+    /// Sends the ready batches, returns false if the connection failed
+    bool SendReady(Lock &lock);
+    /**
+     * Removes the lines that were sent from the first ready batch. A line
+     * that was sent only partially is dropped, so that the batch can be
+     * sent on from a line boundary.
+     */
+    void RemoveSent(std::size_t sent);
+    /// Drops the ready batches and the current one
+    void DropAll( );
+
+    const std::string PATH_;
+    const Type TYPE_;
+    const std::size_t BATCH_SIZE_;
+    const boost::posix_time::time_duration INTERVAL_;
+
+    /// Only used by the background thread
+    int descriptor_;
+
+    mutable boost::mutex mutex_;
+    boost::condition_variable condition_;
+    std::string current_;
+    std::deque<std::string> ready_;
+    /// The count of bytes in current_ and ready_
+    std::size_t queued_;
+    std::size_t dropped_;
+    bool stop_;
+
+    /// Started last, after the other members have been initialized
+    boost::thread thread_;
+};
+
+// Class implementations
+
+const std::size_t SocketBuffer::DEFAULT_BATCH_SIZE;
+const unsigned int SocketBuffer::DEFAULT_FLUSH_MILLISECONDS;
+const std::size_t SocketBuffer::MAX_QUEUED_BATCHES;
+
+SocketBuffer::SocketBuffer(const std::string &path, Type type,
+                           std::size_t batchSize,
+                           unsigned int flushMilliseconds) :
+    implementation_(new Implementation(path, NO_DESCRIPTOR, type, batchSize,
+                                       flushMilliseconds))
+{
+}
+
+SocketBuffer::SocketBuffer(int descriptor, Type type, std::size_t batchSize,
+                           unsigned int flushMilliseconds) :
+    implementation_(new Implementation("", descriptor, type, batchSize,
+                                       flushMilliseconds))
+{
+}
+
+SocketBuffer::~SocketBuffer( )
+{
+}
+
+std::size_t SocketBuffer::Dropped( ) const
+{
+    return implementation_->Dropped( );
+}
+
+int SocketBuffer::SyncImpl( )
+{
+    try
+    {
+        implementation_->Add(GetBuffer( ));
+    }
+    catch (...)
+    {
+        // Most likely out of memory. The line is lost, but the writing must
+        // not throw.
+    }
+
+    return 0;
+}
+
+SocketBuffer::Implementation::Implementation(const std::string &path,
+                                             int descriptor, Type type,
+                                             std::size_t batchSize,
+                                             unsigned int flushMilliseconds) :
+    PATH_(path),
+    TYPE_(type),
+    BATCH_SIZE_(std::max<std::size_t>(batchSize, 1)),
+    INTERVAL_(boost::posix_time::milliseconds(flushMilliseconds)),
+    descriptor_(descriptor),
+    queued_(0),
+    dropped_(0),
+    stop_(false),
+    thread_(&Implementation::Run, this)
+{
+}
+
+SocketBuffer::Implementation::~Implementation( )
+{
+    {
+        Lock lock(mutex_);
+        stop_ = true;
+    }
+
+    condition_.notify_one( );
+    thread_.join( );
+
+    if (NO_DESCRIPTOR != descriptor_)
+    {
+        close(descriptor_);
+    }
+}
+
+void SocketBuffer::Implementation::Add(const std::string &line)
+{
+    const bool NEEDS_FRAMING =
+        line.empty( ) || '\n' != line[line.size( ) - 1];
+    const std::size_t SIZE = line.size( ) + (NEEDS_FRAMING ? 1 : 0);
+
+    Lock lock(mutex_);
+    if (queued_ + SIZE > BATCH_SIZE_ * MAX_QUEUED_BATCHES)
+    {
+        ++dropped_;
+        return;
+    }
+
+    if (!current_.empty( ) && current_.size( ) + SIZE > BATCH_SIZE_)
+    {
+        FinishBatch( );
+    }
+
+    if (current_.capacity( ) < BATCH_SIZE_)
+    {
+        current_.reserve(BATCH_SIZE_);
+    }
+
+    current_ += line;
+    if (NEEDS_FRAMING)
+    {
+        current_ += '\n';
+    }
+
+    queued_ += SIZE;
+
+    if (current_.size( ) >= BATCH_SIZE_)
+    {
+        FinishBatch( );
+        condition_.notify_one( );
+    }
+}
+
+std::size_t SocketBuffer::Implementation::Dropped( ) const
+{
+    Lock lock(mutex_);
+    return dropped_;
+}
+
+void SocketBuffer::Implementation::Run( )
+{
+    Lock lock(mutex_);
+    while (true)
+    {
+        if (ready_.empty( ) && !stop_)
+        {
+            condition_.timed_wait(lock, INTERVAL_);
+        }
+
+        // Either the interval has passed or the batches are needed anyway
+        if (ready_.empty( ) && !current_.empty( ))
+        {
+            FinishBatch( );
+        }
+
+        if (ready_.empty( ))
+        {
+            if (stop_)
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        if (!SendReady(lock))
+        {
+            if (stop_ || PATH_.empty( ))
+            {
+                DropAll( );
+                if (stop_)
+                {
+                    return;
+                }
+
+                continue;
+            }
+
+            // Wait before reconnecting. If stopped meanwhile, there is one
+            // more attempt before the batches are dropped.
+            condition_.timed_wait(lock, INTERVAL_);
+        }
+    }
+}
+
+void SocketBuffer::Implementation::FinishBatch( )
+{
+    ready_.push_back(std::string( ));
+    ready_.back( ).swap(current_);
+}
+
+bool SocketBuffer::Implementation::SendReady(Lock &lock)
+{
+    const int WAIT = static_cast<int>(INTERVAL_.total_milliseconds( ));
+
+    while (!ready_.empty( ))
+    {
+        // The batch is sent without holding the lock, so that the writers
+        // can continue meanwhile. Only this thread removes batches.
+        const std::string &BATCH = ready_.front( );
+        SendResult result = FAILED;
+        std::size_t sent = 0;
+
+        lock.unlock( );
+        if (NO_DESCRIPTOR == descriptor_)
+        {
+            descriptor_ = Connect(PATH_, TYPE_);
+        }
+
+        if (NO_DESCRIPTOR != descriptor_)
+        {
+            result = Send(descriptor_, TYPE_, BATCH, WAIT, sent);
+        }
+
+        if (FAILED == result && NO_DESCRIPTOR != descriptor_)
+        {
+            close(descriptor_);
+            descriptor_ = NO_DESCRIPTOR;
+        }
+        lock.lock( );
+
+        if (FAILED == result)
+        {
+            // The collector already has the lines that were sent on the
+            // closed connection, so they are not sent again
+            RemoveSent(sent);
+            return false;
+        }
+
+        if (DISCARDED == result)
+        {
+            dropped_ += CountLines(BATCH);
+        }
+
+        queued_ -= BATCH.size( );
+        ready_.pop_front( );
+    }
+
+    return true;
+}
+
+void SocketBuffer::Implementation::RemoveSent(std::size_t sent)
+{
+    if (!sent)
+    {
+        return;
+    }
+
+    std::string &batch = ready_.front( );
+    std::size_t end = sent;
+    if ('\n' != batch[sent - 1])
+    {
+        // The collector got the beginning of the line, which cannot be
+        // completed on a new connection. Each line ends with a line feed.
+        end = batch.find('\n', sent) + 1;
+        ++dropped_;
+    }
+
+    queued_ -= end;
+    if (batch.size( ) == end)
+    {
+        ready_.pop_front( );
+        return;
+    }
+
+    batch.erase(0, end);
+}
+
+void SocketBuffer::Implementation::DropAll( )
+{
+    for (std::deque<std::string>::const_iterator i(ready_.begin( ));
+         ready_.end( ) != i;
+         ++i)
+    {
+        dropped_ += CountLines(*i);
+    }
+
+    dropped_ += CountLines(current_);
+    ready_.clear( );
+    current_.clear( );
+    queued_ = 0;
+}
+
+SocketStream::SocketStream(const std::string &path, SocketBuffer::Type type,
+                           std::size_t batchSize,
+                           unsigned int flushMilliseconds) :
+    std::ostream(0),
+    buffer_(path, type, batchSize, flushMilliseconds)
+{
+    rdbuf(&buffer_);
+}
+
+SocketStream::SocketStream(int descriptor, SocketBuffer::Type type,
+                           std::size_t batchSize,
+                           unsigned int flushMilliseconds) :
+    std::ostream(0),
+    buffer_(descriptor, type, batchSize, flushMilliseconds)
+{
+    rdbuf(&buffer_);
+}
+
+std::size_t SocketStream::Dropped( ) const
+{
+    return buffer_.Dropped( );
+}
+
+// Local implementations
+
+namespace
+{
+
+int Connect(const std::string &path, SocketBuffer::Type type)
+{
+    sockaddr_un address;
+    if (path.empty( ) || path.size( ) >= sizeof(address.sun_path))
+    {
+        return NO_DESCRIPTOR;
+    }
+
+    const int SOCKET_TYPE =
+        SocketBuffer::DATAGRAM == type ? SOCK_DGRAM : SOCK_STREAM;
+    const int DESCRIPTOR = socket(AF_UNIX, SOCKET_TYPE, 0);
+    if (NO_DESCRIPTOR == DESCRIPTOR)
+    {
+        return NO_DESCRIPTOR;
+    }
+
+    fcntl(DESCRIPTOR, F_SETFD, FD_CLOEXEC);
+    fcntl(DESCRIPTOR, F_SETFL, fcntl(DESCRIPTOR, F_GETFL) | O_NONBLOCK);
+
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str( ));
+
+    // With Unix domain sockets a non-blocking connect either succeeds or
+    // fails immediately. A full backlog is just retried later.
+    if (connect(DESCRIPTOR, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)))
+    {
+        close(DESCRIPTOR);
+        return NO_DESCRIPTOR;
+    }
+
+    return DESCRIPTOR;
+}
+
+SendResult Send(int descriptor, SocketBuffer::Type type,
+                const std::string &batch, int waitMilliseconds,
+                std::size_t &sent)
+{
+    sent = 0;
+    while (sent < batch.size( ))
+    {
+        const ssize_t RESULT = send(descriptor, batch.data( ) + sent,
+                                    batch.size( ) - sent,
+                                    MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (RESULT >= 0)
+        {
+            // A datagram is always sent as whole
+            sent = SocketBuffer::DATAGRAM == type ?
+                   batch.size( ) : sent + static_cast<std::size_t>(RESULT);
+            continue;
+        }
+
+        if (EINTR == errno)
+        {
+            continue;
+        }
+
+        if (EMSGSIZE == errno)
+        {
+            return DISCARDED;
+        }
+
+        if (EAGAIN != errno && EWOULDBLOCK != errno && ENOBUFS != errno)
+        {
+            return FAILED;
+        }
+
+        pollfd writable = { descriptor, POLLOUT, 0 };
+        if (poll(&writable, 1, waitMilliseconds) <= 0)
+        {
+            // The collector is stuck, give it a new connection later
+            return FAILED;
+        }
+    }
+
+    return SENT;
+}
+
+std::size_t CountLines(const std::string &batch)
+{
+    return static_cast<std::size_t>(std::count(batch.begin( ), batch.end( ),
+                                               '\n'));
+}
+
+}
+
+}
+
+}
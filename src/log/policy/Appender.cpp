@@ -10,9 +10,11 @@
  */
 
 #include "myrrh/log/policy/Appender.hpp"
+#include "myrrh/log/policy/Compressor.hpp"
+#include "myrrh/log/policy/Manifest.hpp"
 #include "myrrh/log/policy/Path.hpp"
 #include "myrrh/log/policy/PathEntity.hpp"
-#include "myrrh/file/MatchFiles.hpp"
+#include "myrrh/file/ScanFolder.hpp"
 
 #define DISABLE_SIGNED_UNSIGNED_MISMATCH
 #include "myrrh/util/Preprocessor.hpp"
@@ -25,6 +27,14 @@
 
 #include "boost/filesystem/operations.hpp"
 
+#include <cerrno>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
 namespace myrrh
 {
 
@@ -38,8 +48,44 @@ namespace policy
 namespace
 {
 
-boost::filesystem::path SelectPathToUseHideErrors(Path &path);
+boost::filesystem::path SelectPathToUseHideErrors(Path &path,
+                                                  const Manifest *manifest);
 boost::filesystem::path SelectPathToUse(Path &path);
+bool FindLatest(const boost::filesystem::path &folder,
+                const Path::Entity &entity, file::FolderEntry &latest);
+
+/**
+ * Generates the path of a new file that is later than the latest file. The
+ * names already in use (also by the compressed files) are skipped, as long as
+ * the generated names change (e.g. with Index).
+ */
+boost::filesystem::path GenerateAfter(Path &path,
+                                      const boost::filesystem::path &latest);
+
+/**
+ * Tells if the path or its compressed form exists
+ */
+bool IsInUse(const boost::filesystem::path &path);
+
+/// The name of the lock file of the shared files
+const char *const LOCK_NAME = ".myrrh.lock";
+
+/**
+ * Holds an advisory lock of the lock file in the folder during its lifetime.
+ * If the lock file cannot be opened, nothing is locked.
+ */
+class FolderLock
+{
+public:
+    explicit FolderLock(const boost::filesystem::path &folder);
+    ~FolderLock( );
+private:
+    FolderLock(const FolderLock &);
+    FolderLock &operator=(const FolderLock &);
+
+    int descriptor_;
+};
+
 boost::filesystem::path SelectParentPath(const Path &path);
 bool CreateDirectoryTree(const boost::filesystem::path &directory);
 
@@ -47,13 +93,16 @@ bool CreateDirectoryTree(const boost::filesystem::path &directory);
 
 // Class implementations
 
-Appender::Appender( )
+Appender::Appender(Sharing sharing) :
+    SHARING_(sharing)
 {
+    SetShared(SHARED == sharing);
 }
 
 boost::filesystem::path Appender::DoOpen(std::filebuf &file, Path& path)
 {
-    const boost::filesystem::path PATH(SelectPathToUseHideErrors(path));
+    const boost::filesystem::path
+        PATH(SelectPathToUseHideErrors(path, GetManifest( ).get( )));
     CreateDirectoryTree(PATH.branch_path( ));
     using namespace std;
     // Extract flags to function
@@ -62,12 +111,68 @@ boost::filesystem::path Appender::DoOpen(std::filebuf &file, Path& path)
     return PATH;
 }
 
+bool Appender::DoOpenDescriptor(int &descriptor, Path &path,
+                                boost::filesystem::path &opened)
+{
+    if (SHARED == SHARING_)
+    {
+        OpenShared(descriptor, path, opened);
+        return true;
+    }
+
+    opened = SelectPathToUseHideErrors(path, GetManifest( ).get( ));
+    CreateDirectoryTree(opened.branch_path( ));
+    descriptor = OpenDescriptor(opened, false);
+
+    return true;
+}
+
+void Appender::OpenShared(int &descriptor, Path &path,
+                          boost::filesystem::path &opened)
+{
+    descriptor = NO_DESCRIPTOR;
+
+    try
+    {
+        // The processes select the file one at a time, so that only one of
+        // them starts the next file
+        const boost::filesystem::path FOLDER(SelectParentPath(path));
+        CreateDirectoryTree(FOLDER);
+        const FolderLock LOCK(FOLDER);
+
+        // The file opened before is only opened again once the restrictions
+        // apply to it. Unless another process has already started the next
+        // file, this one does.
+        opened = SelectPathToUseHideErrors(path, 0);
+        if (opened.string( ) == previous_)
+        {
+            opened = GenerateAfter(path, opened);
+        }
+
+        CreateDirectoryTree(opened.branch_path( ));
+        descriptor = OpenDescriptor(opened, false);
+        previous_ = opened.string( );
+    }
+    catch (...)
+    {
+        // No memory
+    }
+}
+
 // Local implementations
 namespace
 {
 
-boost::filesystem::path SelectPathToUseHideErrors(Path &path)
+boost::filesystem::path SelectPathToUseHideErrors(Path &path,
+                                                  const Manifest *manifest)
 {
+    // The manifest is only valid, if none of the folders has been modified
+    boost::filesystem::path latest;
+    if (manifest && manifest->Lookup(path, latest))
+    {
+        return latest;
+    }
+
     // Why are the exceptions hidden?
     try
     {
@@ -93,33 +198,108 @@ boost::filesystem::path SelectPathToUse(Path &path)
          path.EndEntity( ) != i;
          ++i)
     {
-        using namespace file;
-        PathStore matches(MatchFiles(folder, i->Matcher( )));
-        if (matches.empty( ))
+        file::FolderEntry match;
+        if (!FindLatest(folder, *i, match))
         {
             break;
         }
 
-        PathStore::iterator match(std::max_element(matches.begin( ),
-                                                   matches.end( ),
-                                                   i->GetComparer( )));
-
-        if (!boost::filesystem::is_directory(*match))
+        if (!match.isDirectory)
         {
             if (i + 1 != path.EndEntity( ))
             {
                 break;
             }
 
-            return *match;
+            // A compressed file is not appended to, the next one is started
+            Path::Entity::Key key;
+            if (!i->Parse(match.path, key))
+            {
+                return GenerateAfter(path, match.path);
+            }
+
+            return match.path;
         }
 
-        folder = *match;
+        folder = match.path;
     }
 
     return path.Generate( );
 }
 
+bool FindLatest(const boost::filesystem::path &folder,
+                const Path::Entity &entity, file::FolderEntry &latest)
+{
+    // Each name is parsed only once. The matcher accepts only the names that
+    // are later than the ones before, so the last entry is the latest. Of
+    // equal keys the last one is chosen, as std::max_element would do with
+    // the comparer of the entity.
+    Path::Entity::Key latestKey;
+    bool found = false;
+
+    const file::EntryStore ENTRIES(file::ScanFolder(folder,
+        [&](const std::string &name) -> bool
+        {
+            Path::Entity::Key key;
+            if (!Compressor::Parse(entity, name, key) ||
+                (found && key < latestKey))
+            {
+                return false;
+            }
+
+            latestKey.swap(key);
+            found = true;
+            return true;
+        }));
+
+    if (ENTRIES.empty( ))
+    {
+        return false;
+    }
+
+    latest = ENTRIES.back( );
+    return true;
+}
+
+boost::filesystem::path GenerateAfter(Path &path,
+                                      const boost::filesystem::path &latest)
+{
+    std::string name(latest.string( ));
+    if (Compressor::IsCompressed(name))
+    {
+        name.resize(name.size( ) - Compressor::SUFFIX.size( ));
+    }
+
+    Path::Entity::Key latestKey;
+    const bool KNOWN = path.Parse(name, latestKey);
+
+    boost::filesystem::path result(path.Generate( ));
+    for (;;)
+    {
+        Path::Entity::Key key;
+        const bool LATER =
+            !KNOWN || (path.Parse(result, key) && latestKey < key);
+        if (LATER && !IsInUse(result))
+        {
+            return result;
+        }
+
+        const boost::filesystem::path NEXT(path.Generate( ));
+        if (NEXT == result)
+        {
+            return result;
+        }
+
+        result = NEXT;
+    }
+}
+
+bool IsInUse(const boost::filesystem::path &path)
+{
+    return boost::filesystem::exists(path) ||
+           boost::filesystem::exists(path.string( ) + Compressor::SUFFIX);
+}
+
 boost::filesystem::path SelectParentPath(const Path &path)
 {
     const boost::filesystem::path PARENT_PATH(path.ParentPath( ));
@@ -146,6 +326,31 @@ bool CreateDirectoryTree(const boost::filesystem::path &directory)
     return true;
 }
 
+FolderLock::FolderLock(const boost::filesystem::path &folder) :
+    descriptor_(-1)
+{
+#ifndef WIN32
+    const boost::filesystem::path LOCK_FILE(folder / LOCK_NAME);
+    descriptor_ = open(LOCK_FILE.string( ).c_str( ),
+                       O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    while (descriptor_ >= 0 && flock(descriptor_, LOCK_EX) < 0 &&
+           EINTR == errno)
+    {
+    }
+#endif
+}
+
+FolderLock::~FolderLock( )
+{
+#ifndef WIN32
+    if (descriptor_ >= 0)
+    {
+        // Closing releases the lock
+        close(descriptor_);
+    }
+#endif
+}
+
 }
 
 }
@@ -0,0 +1,332 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains implementation of class myrrh::log::policy::AsyncPolicy
+ */
+
+#include "myrrh/log/policy/AsyncPolicy.hpp"
+
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <deque>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * A text or a restriction waiting for the background thread
+ */
+struct Item
+{
+    Item( );
+
+    std::string text;
+    /// If set, the item adds the restriction instead of writing
+    RestrictionPtr restriction;
+    /// The verbosity level of the text, if hasVerbosity is set
+    VerbosityLevel verbosity;
+    bool hasVerbosity;
+};
+
+typedef std::deque<Item> Items;
+
+}
+
+/**
+ * The background thread takes all of the queued items at once and handles
+ * them without the lock. The writers waiting for room are woken once the
+ * items have been taken, so the queue can be filled again while the previous
+ * items are written.
+ */
+class AsyncPolicy::Queue
+{
+public:
+
+    Queue(PolicyPtr policy, std::size_t capacity, Overflow overflow);
+    ~Queue( );
+
+    void AddRestriction(RestrictionPtr restriction);
+    std::streamsize Write(const std::string &toWrite, Item &item);
+    void Flush( );
+    std::size_t GetDropCount( ) const;
+    std::size_t GetFailureCount( ) const;
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    /// Queues the item, returns false if it was dropped
+    bool Push(Item &item);
+    /// The loop of the background thread
+    void Run( );
+    /// Handles the items taken from the queue
+    void Handle(const Items &items);
+
+    const PolicyPtr POLICY_;
+    const std::size_t CAPACITY_;
+    const Overflow OVERFLOW_;
+
+    Items items_;
+    /// The total size of the queued texts
+    std::size_t size_;
+    /// Tells if the thread is handling the items it has taken
+    bool handling_;
+    bool stopping_;
+    std::size_t drops_;
+    std::size_t failures_;
+    mutable boost::mutex mutex_;
+    /// Signalled for the thread, when the queue is no longer empty
+    boost::condition_variable filled_;
+    /// Signalled for the writers, when the thread has taken the items
+    boost::condition_variable emptied_;
+    boost::thread thread_;
+};
+
+// Class implementations
+
+AsyncPolicy::AsyncPolicy(PolicyPtr policy, std::size_t capacity,
+                         Overflow overflow) :
+    queue_(new Queue(policy, capacity, overflow))
+{
+}
+
+AsyncPolicy::~AsyncPolicy( )
+{
+}
+
+void AsyncPolicy::Flush( )
+{
+    queue_->Flush( );
+}
+
+std::size_t AsyncPolicy::GetDropCount( ) const
+{
+    return queue_->GetDropCount( );
+}
+
+std::size_t AsyncPolicy::GetFailureCount( ) const
+{
+    return queue_->GetFailureCount( );
+}
+
+void AsyncPolicy::DoAddRestriction(RestrictionPtr restriction)
+{
+    queue_->AddRestriction(restriction);
+}
+
+std::streamsize AsyncPolicy::DoWrite(const std::string &toWrite)
+{
+    Item item;
+    return queue_->Write(toWrite, item);
+}
+
+std::streamsize AsyncPolicy::DoWriteWithLevel(const std::string &toWrite,
+                                              VerbosityLevel verbosity)
+{
+    Item item;
+    item.verbosity = verbosity;
+    item.hasVerbosity = true;
+    return queue_->Write(toWrite, item);
+}
+
+AsyncPolicy::Queue::Queue(PolicyPtr policy, std::size_t capacity,
+                          Overflow overflow) :
+    POLICY_(policy),
+    CAPACITY_(capacity),
+    OVERFLOW_(overflow),
+    size_(0),
+    handling_(false),
+    stopping_(false),
+    drops_(0),
+    failures_(0)
+{
+    // Started last, when the members are ready for the thread
+    thread_ = boost::thread(&Queue::Run, this);
+}
+
+AsyncPolicy::Queue::~Queue( )
+{
+    {
+        Lock lock(mutex_);
+        stopping_ = true;
+    }
+
+    filled_.notify_one( );
+    thread_.join( );
+}
+
+void AsyncPolicy::Queue::AddRestriction(RestrictionPtr restriction)
+{
+    Item item;
+    item.restriction = restriction;
+
+    // The restriction is added even if the queue is full
+    Lock lock(mutex_);
+    items_.push_back(item);
+    lock.unlock( );
+
+    filled_.notify_one( );
+}
+
+std::streamsize AsyncPolicy::Queue::Write(const std::string &toWrite,
+                                          Item &item)
+{
+    try
+    {
+        item.text = toWrite;
+        if (!Push(item))
+        {
+            return 0;
+        }
+    }
+    catch (...)
+    {
+        // No memory for the text
+        return -1;
+    }
+
+    return static_cast<std::streamsize>(toWrite.size( ));
+}
+
+void AsyncPolicy::Queue::Flush( )
+{
+    Lock lock(mutex_);
+    while (!items_.empty( ) || handling_)
+    {
+        emptied_.wait(lock);
+    }
+}
+
+std::size_t AsyncPolicy::Queue::GetDropCount( ) const
+{
+    Lock lock(mutex_);
+    return drops_;
+}
+
+std::size_t AsyncPolicy::Queue::GetFailureCount( ) const
+{
+    Lock lock(mutex_);
+    return failures_;
+}
+
+bool AsyncPolicy::Queue::Push(Item &item)
+{
+    const std::size_t SIZE = item.text.size( );
+
+    Lock lock(mutex_);
+    while (size_ && size_ + SIZE > CAPACITY_)
+    {
+        if (DROP == OVERFLOW_)
+        {
+            ++drops_;
+            return false;
+        }
+
+        emptied_.wait(lock);
+    }
+
+    // The text is swapped, so that it is not copied again
+    items_.push_back(Item( ));
+    items_.back( ).text.swap(item.text);
+    items_.back( ).verbosity = item.verbosity;
+    items_.back( ).hasVerbosity = item.hasVerbosity;
+    size_ += SIZE;
+    lock.unlock( );
+
+    filled_.notify_one( );
+    return true;
+}
+
+void AsyncPolicy::Queue::Run( )
+{
+    Lock lock(mutex_);
+    for (;;)
+    {
+        while (items_.empty( ) && !stopping_)
+        {
+            filled_.wait(lock);
+        }
+
+        if (items_.empty( ))
+        {
+            return;
+        }
+
+        Items items;
+        items.swap(items_);
+        size_ = 0;
+        handling_ = true;
+        lock.unlock( );
+        emptied_.notify_all( );
+
+        Handle(items);
+
+        lock.lock( );
+        handling_ = false;
+        emptied_.notify_all( );
+    }
+}
+
+void AsyncPolicy::Queue::Handle(const Items &items)
+{
+    std::size_t failures = 0;
+    for (Items::const_iterator i = items.begin( ); items.end( ) != i; ++i)
+    {
+        if (i->restriction)
+        {
+            POLICY_->AddRestriction(i->restriction);
+            continue;
+        }
+
+        const std::streamsize SIZE =
+            static_cast<std::streamsize>(i->text.size( ));
+        const std::streamsize WRITTEN = i->hasVerbosity ?
+            POLICY_->WriteWithLevel(i->text, i->verbosity) :
+            POLICY_->Write(i->text);
+        if (SIZE != WRITTEN)
+        {
+            ++failures;
+        }
+    }
+
+    if (failures)
+    {
+        Lock lock(mutex_);
+        failures_ += failures;
+    }
+}
+
+// Local implementations
+
+namespace
+{
+
+Item::Item( ) :
+    verbosity(TRACE),
+    hasVerbosity(false)
+{
+}
+
+}
+
+}
+
+}
+
+}
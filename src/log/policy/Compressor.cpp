@@ -0,0 +1,281 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of class
+ * myrrh::log::policy::Compressor.
+ */
+
+#include "myrrh/log/policy/Compressor.hpp"
+
+#include "boost/bind.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/scoped_array.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <fstream>
+
+#include <zlib.h>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+/// The size of the chunks compressed at a time
+const std::size_t CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Compresses the input file into the output file
+ * @return false, if reading or writing failed
+ */
+bool CompressInto(const boost::filesystem::path &input,
+                  const boost::filesystem::path &output);
+
+}
+
+/**
+ * The worker threads take the files from a queue. When stopping, the threads
+ * empty the queue before they exit.
+ */
+class Compressor::Implementation
+{
+public:
+
+    explicit Implementation(std::size_t threads);
+    ~Implementation( );
+
+    void Closed(const boost::filesystem::path &file);
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    /// The loop of the worker threads
+    void Run( );
+
+    std::deque<boost::filesystem::path> queue_;
+    bool stopping_;
+    boost::mutex mutex_;
+    boost::condition_variable condition_;
+    boost::thread_group threads_;
+};
+
+// Class implementations
+
+const std::string Compressor::SUFFIX(".gz");
+
+Compressor::Compressor(std::size_t threads) :
+    implementation_(new Implementation(threads))
+{
+}
+
+Compressor::~Compressor( )
+{
+}
+
+void Compressor::Closed(const boost::filesystem::path &file)
+{
+    implementation_->Closed(file);
+}
+
+bool Compressor::Compress(const boost::filesystem::path &file)
+{
+    try
+    {
+        const std::string COMPRESSED(file.string( ) + SUFFIX);
+        const std::string TEMPORARY(COMPRESSED + ".tmp");
+
+        // An earlier file with the same name has been compressed already
+        if (boost::filesystem::exists(COMPRESSED))
+        {
+            return false;
+        }
+
+        if (!CompressInto(file, TEMPORARY))
+        {
+            boost::system::error_code error;
+            boost::filesystem::remove(TEMPORARY, error);
+            return false;
+        }
+
+        // The modification time tells the age of the content, e.g. for
+        // Retention
+        boost::system::error_code error;
+        const std::time_t TIME = boost::filesystem::last_write_time(file,
+                                                                    error);
+        if (!error)
+        {
+            boost::filesystem::last_write_time(TEMPORARY, TIME, error);
+        }
+
+        boost::filesystem::rename(TEMPORARY, COMPRESSED);
+        boost::filesystem::remove(file);
+        return true;
+    }
+    catch (...)
+    {
+    }
+
+    return false;
+}
+
+bool Compressor::IsCompressed(const std::string &name)
+{
+    return name.size( ) > SUFFIX.size( ) &&
+           !name.compare(name.size( ) - SUFFIX.size( ), SUFFIX.size( ),
+                         SUFFIX);
+}
+
+bool Compressor::Parse(const Path::Entity &entity, const std::string &name,
+                       Path::Entity::Key &key)
+{
+    if (entity.Parse(name, key))
+    {
+        return true;
+    }
+
+    return IsCompressed(name) &&
+           entity.Parse(name.substr(0, name.size( ) - SUFFIX.size( )), key);
+}
+
+Compressor::Implementation::Implementation(std::size_t threads) :
+    stopping_(false)
+{
+    try
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i)
+        {
+            threads_.create_thread(boost::bind(&Implementation::Run, this));
+        }
+    }
+    catch (...)
+    {
+        {
+            Lock lock(mutex_);
+            stopping_ = true;
+        }
+
+        condition_.notify_all( );
+        threads_.join_all( );
+        throw;
+    }
+}
+
+Compressor::Implementation::~Implementation( )
+{
+    {
+        Lock lock(mutex_);
+        stopping_ = true;
+    }
+
+    condition_.notify_all( );
+    threads_.join_all( );
+}
+
+void Compressor::Implementation::Closed(const boost::filesystem::path &file)
+{
+    try
+    {
+        Lock lock(mutex_);
+        queue_.push_back(file);
+    }
+    catch (...)
+    {
+        // The file is left uncompressed
+        return;
+    }
+
+    condition_.notify_one( );
+}
+
+void Compressor::Implementation::Run( )
+{
+    Lock lock(mutex_);
+    for (;;)
+    {
+        while (queue_.empty( ) && !stopping_)
+        {
+            condition_.wait(lock);
+        }
+
+        if (queue_.empty( ))
+        {
+            return;
+        }
+
+        const boost::filesystem::path FILE(queue_.front( ));
+        queue_.pop_front( );
+        lock.unlock( );
+
+        Compress(FILE);
+
+        lock.lock( );
+    }
+}
+
+// Local implementations
+
+namespace
+{
+
+bool CompressInto(const boost::filesystem::path &input,
+                  const boost::filesystem::path &output)
+{
+    std::ifstream file(input.string( ).c_str( ), std::ios::binary);
+    if (!file.is_open( ))
+    {
+        return false;
+    }
+
+    boost::scoped_array<char> buffer(new char[CHUNK_SIZE]);
+    gzFile compressed = gzopen(output.string( ).c_str( ), "wb");
+    if (!compressed)
+    {
+        return false;
+    }
+
+    bool result = true;
+    while (result && file)
+    {
+        file.read(buffer.get( ), static_cast<std::streamsize>(CHUNK_SIZE));
+        const unsigned READ = static_cast<unsigned>(file.gcount( ));
+        if (READ &&
+            gzwrite(compressed, buffer.get( ), READ) != static_cast<int>(READ))
+        {
+            result = false;
+        }
+    }
+
+    if (file.bad( ))
+    {
+        result = false;
+    }
+
+    return Z_OK == gzclose(compressed) && result;
+}
+
+}
+
+}
+
+}
+
+}
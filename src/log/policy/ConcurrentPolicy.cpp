@@ -0,0 +1,414 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains implementation of class
+ * myrrh::log::policy::ConcurrentPolicy
+ */
+
+#include "myrrh/log/policy/ConcurrentPolicy.hpp"
+#include "myrrh/log/policy/File.hpp"
+#include "myrrh/log/policy/Opener.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/log/policy/RestrictionStore.hpp"
+#include "myrrh/util/CoarseClock.hpp"
+
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <atomic>
+#include <limits>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * The count of epochs whose files can be open at once. The file of the
+ * previous epoch stays open until its writers have left.
+ */
+const unsigned int SLOTS = 2;
+
+/**
+ * The file of one epoch and the state shared by its writers
+ */
+struct Slot
+{
+    Slot( );
+
+    FilePtr file;
+    /// Tells if the file is written at the reserved offsets
+    bool reserving;
+    /// The offset at which the file was taken into use
+    unsigned long long start;
+    /// The offset of the next reservation
+    std::atomic<unsigned long long> offset;
+    /// The reservations must end before this offset
+    std::atomic<unsigned long long> limit;
+    /// The time after which the restrictions need to be checked
+    std::atomic<util::CoarseClock::Ticks> deadline;
+    /// The count of the writers inside the epoch
+    std::atomic<unsigned long> writers;
+
+private:
+
+    Slot(const Slot &);
+    Slot &operator=(const Slot &);
+};
+
+/**
+ * Returns the offset at which the budget beginning from start ends
+ */
+unsigned long long LimitOf(unsigned long long start, std::size_t budget);
+
+}
+
+/**
+ * The epochs are numbered, and each epoch uses the slot given by its number.
+ * The writers enter an epoch by incrementing the count of its writers and
+ * then checking that the epoch is still current. The rotation starts the next
+ * epoch before waiting for the count of the previous one to drop to zero, so
+ * the two cannot miss each other.
+ */
+class ConcurrentPolicy::Epochs
+{
+public:
+    Epochs(Path path, InitialOpenerPtr initialOpener,
+           InitialOpenerPtr subsequentOpener);
+    void AddRestriction(RestrictionPtr restriction);
+    std::streamsize Write(const std::string &toWrite);
+private:
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    /// Enters the current epoch and returns its number
+    unsigned int Enter( );
+    void Leave(unsigned int epoch);
+
+    /**
+     * Writes the text with the lock held, for files that are not written at
+     * reserved offsets
+     * @param retry Set to true, if the file of the next epoch is written at
+     *              reserved offsets
+     */
+    std::streamsize WriteLocked(const std::string &toWrite, bool &retry);
+
+    /// Evaluates the restrictions after the deadline of the epoch
+    bool Check(unsigned int epoch);
+    /// Rotates the file, unless another writer has already done it
+    bool Rotate(unsigned int epoch);
+    /// Opens the next file and starts the next epoch. Requires the lock.
+    bool RotateLocked(unsigned int epoch);
+    /// Takes the file into use in the slot. Requires the lock.
+    void Fill(Slot &slot, FilePtr file);
+    /// Sets the limits of the file of the slot. Requires the lock.
+    bool Arm(Slot &slot);
+
+    Path path_;
+    InitialOpenerPtr subsequentOpener_;
+    RestrictionStore restrictions_;
+    Slot slots_[SLOTS];
+    std::atomic<unsigned int> epoch_;
+    boost::mutex mutex_;
+};
+
+// Class implementations
+
+ConcurrentPolicy::ConcurrentPolicy(Path path, InitialOpenerPtr initialOpener,
+                                   InitialOpenerPtr subsequentOpener) :
+    epochs_(new Epochs(path, initialOpener, subsequentOpener))
+{
+}
+
+ConcurrentPolicy::~ConcurrentPolicy( )
+{
+}
+
+void ConcurrentPolicy::DoAddRestriction(RestrictionPtr restriction)
+{
+    epochs_->AddRestriction(restriction);
+}
+
+std::streamsize ConcurrentPolicy::DoWrite(const std::string &toWrite)
+{
+    return epochs_->Write(toWrite);
+}
+
+ConcurrentPolicy::Epochs::Epochs(Path path, InitialOpenerPtr initialOpener,
+                                 InitialOpenerPtr subsequentOpener) :
+    path_(path),
+    subsequentOpener_(subsequentOpener),
+    epoch_(0)
+{
+    path_.AppendRestrictions(restrictions_);
+
+    FilePtr file(initialOpener->Open(path_));
+    if (file)
+    {
+        Fill(slots_[0], file);
+    }
+}
+
+void ConcurrentPolicy::Epochs::AddRestriction(RestrictionPtr restriction)
+{
+    Lock lock(mutex_);
+    restrictions_.Add(restriction);
+
+    const unsigned int EPOCH = epoch_;
+    Slot &slot = slots_[EPOCH % SLOTS];
+    if (slot.file && slot.reserving && !Arm(slot))
+    {
+        // Nothing would check the restriction before the limits of the
+        // others are crossed, so the next file is written under the lock
+        RotateLocked(EPOCH);
+    }
+}
+
+// Divide smaller
+std::streamsize ConcurrentPolicy::Epochs::Write(const std::string &toWrite)
+{
+    const unsigned long long SIZE = toWrite.size( );
+
+    for (;;)
+    {
+        const unsigned int EPOCH = Enter( );
+        Slot &slot = slots_[EPOCH % SLOTS];
+
+        if (!slot.file)
+        {
+            // The file could not be opened for lack of memory
+            Leave(EPOCH);
+            return -1;
+        }
+
+        if (!slot.reserving)
+        {
+            Leave(EPOCH);
+            bool retry = false;
+            const std::streamsize RESULT = WriteLocked(toWrite, retry);
+            if (retry)
+            {
+                continue;
+            }
+
+            return RESULT;
+        }
+
+        if (util::CoarseClock::Now( ) >= slot.deadline)
+        {
+            Leave(EPOCH);
+            if (!Check(EPOCH))
+            {
+                return -1;
+            }
+
+            continue;
+        }
+
+        // A text that does not fit even into an empty file is written alone,
+        // as rotating would not help
+        const unsigned long long START = slot.offset.fetch_add(SIZE);
+        if (START + SIZE > slot.limit && START != slot.start)
+        {
+            // The reservations after this one cross the limit as well, so
+            // nothing is written after the unused range
+            Leave(EPOCH);
+            if (!Rotate(EPOCH))
+            {
+                return -1;
+            }
+
+            continue;
+        }
+
+        const bool WRITTEN =
+            slot.file->WriteAt(toWrite, static_cast<std::streamsize>(START));
+        Leave(EPOCH);
+
+        return WRITTEN ? static_cast<std::streamsize>(SIZE) : -1;
+    }
+}
+
+unsigned int ConcurrentPolicy::Epochs::Enter( )
+{
+    for (;;)
+    {
+        const unsigned int EPOCH = epoch_;
+        std::atomic<unsigned long> &writers = slots_[EPOCH % SLOTS].writers;
+        ++writers;
+        if (epoch_ == EPOCH)
+        {
+            return EPOCH;
+        }
+
+        // The epoch ended before it was entered
+        --writers;
+    }
+}
+
+void ConcurrentPolicy::Epochs::Leave(unsigned int epoch)
+{
+    --slots_[epoch % SLOTS].writers;
+}
+
+std::streamsize
+ConcurrentPolicy::Epochs::WriteLocked(const std::string &toWrite, bool &retry)
+{
+    Lock lock(mutex_);
+
+    // Like in Policy, an opened file is written even if the restrictions
+    // still apply to it
+    for (bool rotated = false; ; rotated = true)
+    {
+        const unsigned int EPOCH = epoch_;
+        Slot &slot = slots_[EPOCH % SLOTS];
+        if (slot.reserving)
+        {
+            retry = true;
+            return 0;
+        }
+
+        if (rotated || !restrictions_.Charge(*slot.file, toWrite.size( )))
+        {
+            return slot.file->Write(toWrite);
+        }
+
+        if (!RotateLocked(EPOCH))
+        {
+            return -1;
+        }
+    }
+}
+
+bool ConcurrentPolicy::Epochs::Check(unsigned int epoch)
+{
+    Lock lock(mutex_);
+
+    Slot &slot = slots_[epoch % SLOTS];
+    if (epoch_ != epoch || util::CoarseClock::Now( ) < slot.deadline)
+    {
+        // Another writer has already checked or rotated
+        return true;
+    }
+
+    // The restrictions see the file as if the reserved ranges were written
+    const std::size_t RESERVED =
+        static_cast<std::size_t>(slot.offset - slot.start);
+    if (restrictions_.IsRestricted(*slot.file, RESERVED))
+    {
+        return RotateLocked(epoch);
+    }
+
+    if (!Arm(slot))
+    {
+        // A restriction no longer publishes limits
+        return RotateLocked(epoch);
+    }
+
+    return true;
+}
+
+bool ConcurrentPolicy::Epochs::Rotate(unsigned int epoch)
+{
+    Lock lock(mutex_);
+    if (epoch_ != epoch)
+    {
+        return true;
+    }
+
+    return RotateLocked(epoch);
+}
+
+bool ConcurrentPolicy::Epochs::RotateLocked(unsigned int epoch)
+{
+    Slot &current = slots_[epoch % SLOTS];
+    Slot &next = slots_[(epoch + 1) % SLOTS];
+
+    // Only the writers that found the epoch ended can still be counted
+    while (next.writers)
+    {
+        boost::this_thread::yield( );
+    }
+
+    FilePtr file(subsequentOpener_->Open(path_));
+    if (!file)
+    {
+        // No memory
+        return false;
+    }
+
+    Fill(next, file);
+    restrictions_.Disarm( );
+    epoch_ = epoch + 1;
+
+    // The writes in flight finish in the previous file before it is closed
+    while (current.writers)
+    {
+        boost::this_thread::yield( );
+    }
+
+    current.file.reset( );
+    return true;
+}
+
+void ConcurrentPolicy::Epochs::Fill(Slot &slot, FilePtr file)
+{
+    slot.file = file;
+    slot.start = static_cast<unsigned long long>(file->WrittenSize( ));
+    slot.offset = slot.start;
+    slot.reserving = Arm(slot) && file->BeginWritingAt( );
+}
+
+bool ConcurrentPolicy::Epochs::Arm(Slot &slot)
+{
+    Limits limits;
+    const bool RESULT = restrictions_.GetLimits(*slot.file, limits);
+
+    // The budget is counted from the size of the file when it was opened,
+    // which is the size the restrictions see
+    slot.limit = LimitOf(slot.start, limits.budget);
+    slot.deadline = limits.deadline;
+    return RESULT;
+}
+
+// Local implementations
+
+namespace
+{
+
+Slot::Slot( ) :
+    reserving(false),
+    start(0),
+    offset(0),
+    limit(0),
+    deadline(0),
+    writers(0)
+{
+}
+
+unsigned long long LimitOf(unsigned long long start, std::size_t budget)
+{
+    const unsigned long long MAX =
+        std::numeric_limits<unsigned long long>::max( );
+    return MAX - start < budget ? MAX : start + budget;
+}
+
+}
+
+}
+
+}
+
+}
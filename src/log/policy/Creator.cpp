@@ -11,6 +11,7 @@
 
 #include "myrrh/log/policy/Creator.hpp"
 #include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/Retention.hpp"
 
 #include "boost/filesystem/convenience.hpp"
 
@@ -25,11 +26,35 @@ namespace log
 namespace policy
 {
 
+// Local declarations
+
+namespace
+{
+
+void CreateParentPath(const boost::filesystem::path &path);
+
+}
+
+// Class implementations
+
 Creator::Creator( )
 {
 }
 
-/// Divide smaller
+void Creator::SetRecycling(RetentionPtr retention)
+{
+    if (retention_)
+    {
+        retention_->SetRecycling(false);
+    }
+
+    retention_ = retention;
+    if (retention_)
+    {
+        retention_->SetRecycling(true);
+    }
+}
+
 boost::filesystem::path Creator::DoOpen(std::filebuf &file, Path& path)
 {
     const boost::filesystem::path PATH(path.Generate( ));
@@ -37,11 +62,7 @@ boost::filesystem::path Creator::DoOpen(std::filebuf &file, Path& path)
 
     try
     {
-        if (PATH.has_parent_path( ))
-        {
-            // These days there is a no-throw version available
-            boost::filesystem::create_directories(PATH.parent_path( ));
-        }
+        CreateParentPath(PATH);
         file.open(PATH.string( ).c_str( ), std::ios::out | std::ios::trunc);
     }
     catch (...)
@@ -51,6 +72,49 @@ boost::filesystem::path Creator::DoOpen(std::filebuf &file, Path& path)
     return PATH;
 }
 
+bool Creator::DoOpenDescriptor(int &descriptor, Path &path,
+                               boost::filesystem::path &opened)
+{
+    descriptor = NO_DESCRIPTOR;
+    opened = path.Generate( );
+    assert(!opened.empty( ));
+
+    try
+    {
+        CreateParentPath(opened);
+        if (retention_ && retention_->Recycle(opened))
+        {
+            descriptor = OverwriteDescriptor(opened);
+        }
+
+        if (NO_DESCRIPTOR == descriptor)
+        {
+            descriptor = OpenDescriptor(opened, true);
+        }
+    }
+    catch (...)
+    {
+    }
+
+    return true;
+}
+
+// Local implementations
+
+namespace
+{
+
+void CreateParentPath(const boost::filesystem::path &path)
+{
+    if (path.has_parent_path( ))
+    {
+        // These days there is a no-throw version available
+        boost::filesystem::create_directories(path.parent_path( ));
+    }
+}
+
+}
+
 }
 
 }
@@ -13,9 +13,27 @@
 #include "myrrh/log/policy/File.hpp"
 #include "myrrh/log/policy/Opener.hpp"
 #include "myrrh/log/policy/Path.hpp"
+#include "myrrh/util/CoarseClock.hpp"
+#include "boost/bind.hpp"
+#include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/scoped_ptr.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace myrrh
 {
@@ -24,26 +42,219 @@ namespace log
 namespace policy
 {
 
+// Local declarations
+
+namespace
+{
+
+/**
+ * Writes the whole data into the descriptor
+ * @return false, if the writing failed
+ */
+bool WriteAll(int descriptor, const char *data, std::size_t size);
+
+/**
+ * Writes the whole data into the descriptor starting from the offset
+ * @return false, if the writing failed
+ */
+bool WriteAllAt(int descriptor, const char *data, std::size_t size,
+                std::streamsize offset);
+
+#ifndef WIN32
+
+/**
+ * Rounds the size up to whole pages, at least one
+ */
+std::size_t RoundToPages(std::size_t size);
+
+/**
+ * Writes a file by copying the text into a memory mapped window of it. Once
+ * the window is full, the writer moves on to the next window, which the
+ * background thread has already mapped. The full windows are synchronized
+ * and unmapped by the thread, so the writer makes no system calls, unless it
+ * gets ahead of the thread.
+ *
+ * The file is extended a window at a time, so the end of the file reads as
+ * zeros while it is written. The file is truncated to the written size on
+ * destruction.
+ */
+class MappedWindow
+{
+public:
+
+    /**
+     * Constructor. The window is mapped, if IsMapped returns true.
+     * @param descriptor The file opened for reading and writing. Owned by
+     *                   the object, unless the constructor throws.
+     * @param end The offset from which the writing starts
+     * @param size The size of the windows
+     * @throws boost::thread_resource_error, if the thread cannot be started
+     */
+    MappedWindow(int descriptor, off_t end, std::size_t size);
+    ~MappedWindow( );
+
+    bool IsMapped( ) const;
+    bool Write(const char *data, std::size_t size);
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    struct Window
+    {
+        Window( );
+
+        char *data;
+        off_t offset;
+    };
+
+    typedef std::vector<Window> WindowStore;
+
+    /// Maps the window at the offset, extending the file first if needed.
+    /// Requires the lock.
+    bool Map(off_t offset, Window &window);
+    void Unmap(Window &window) const;
+    /// Moves the writing to the next window
+    bool Slide( );
+    /// The loop of the background thread
+    void Run( );
+
+    const int DESCRIPTOR_;
+    const std::size_t SIZE_;
+    /// The window written to. Only changed by the writer, with the lock.
+    Window current_;
+    off_t end_;
+
+    /// The size the file has been extended to
+    off_t extended_;
+    /// The window mapped ahead by the thread
+    Window next_;
+    /// The full windows to be unmapped by the thread
+    WindowStore retired_;
+    bool stopping_;
+    boost::mutex mutex_;
+    boost::condition_variable condition_;
+    boost::thread thread_;
+};
+
+#endif
+
+}
+
+/**
+ * The file is written either through a raw descriptor, if the Opener supports
+ * it, or through a stream. With the descriptor the written size is counted
+ * from the sizes of the writes. The stream needs to be asked for its
+ * position, because the line endings may be converted.
+ *
+ * A descriptor opened without O_APPEND is written over from its beginning,
+ * and the old content after the written part is cut off on destruction. The
+ * space preallocated beyond the end of the file is released at the same
+ * time.
+ *
+ * With the mapping, the descriptor is opened again for reading, which
+ * mmap requires, and the lines are copied into MappedWindow instead.
+ *
+ * The durability is taken care of after each write into the descriptor. For
+ * DSYNC the descriptor is opened again with O_DSYNC, which cannot be set
+ * with fcntl. The intervals of BUFFERED and SYNCED are also kept by a
+ * background thread, which flushes the buffer or synchronizes the file once
+ * the interval has passed without new writes. While the thread runs, the
+ * writing methods lock the mutex shared with it. The room returned by
+ * Reserve is not flushed by the thread until it has been committed.
+ */
 class File::Implementation
 {
 public:
 
     Implementation(Opener &opener, policy::Path& path);
+    ~Implementation( );
 
     std::streamsize Write(const std::string &line);
+    char *Reserve(std::size_t size, std::size_t &available);
+    std::streamsize Commit(std::size_t size);
+    bool BeginWritingAt( );
+    bool WriteAt(const std::string &text, std::streamsize offset) const;
     std::streamsize WrittenSize( ) const;
+    bool IsShared( ) const;
+    util::CoarseClock::Ticks OpenTime( ) const;
     const boost::filesystem::path &Path( ) const;
+    bool Rename(const boost::filesystem::path &name);
     bool Compare(const Implementation &other);
 
 private:
 
+    typedef boost::unique_lock<boost::mutex> Lock;
+
     static boost::filesystem::path TryOpening(Opener &opener,
                                               policy::Path &path,
-                                              std::ofstream &file);
+                                              std::ofstream &file,
+                                              int &descriptor);
+
+    std::streamsize WriteToStream(const std::string &line);
+    std::streamsize WriteToDescriptor(const std::string &line);
+    /// Allocates the buffer, unless it already is
+    bool Allocate( );
+    /// Writes the buffer into the descriptor and empties it
+    bool Flush( );
+    /// Allocates the disk space for PREALLOCATION_ bytes
+    void Preallocate( );
+    /// Cuts off the old content and the unused preallocated space
+    void Trim( );
+    /// Starts writing through a memory mapped window of the given size
+    void Map(std::size_t size);
+    /// Opens the descriptor again with O_DSYNC
+    void OpenSynchronized( );
+    /// Writes the buffer, if the interval of BUFFERED has passed since its
+    /// first line was added
+    void CheckBuffer( );
+    /// Pushes the data written into the descriptor towards the disk, as the
+    /// durability requires
+    void Synchronize(std::size_t written);
+    /// Calls fdatasync and sets the next interval (SYNCED)
+    void SynchronizeData( );
+    /// Starts the thread that keeps the interval, if there is one
+    void StartTimer( );
+    /// Locks the mutex, if the thread of the interval runs
+    Lock LockForTimer( ) const;
+    /// The loop of the thread of the interval
+    void Run( );
 
     std::ofstream file_;
+    int descriptor_;
+    const bool SHARED_;
+    const std::size_t BUFFER_SIZE_;
+    /// Allocated in full on the first use, so that it never moves
+    std::vector<char> buffer_;
+    std::size_t buffered_;
+    /// DSYNC is replaced by SYNCED, if the file cannot be opened again
+    Opener::Durability durability_;
+    const std::size_t SYNC_BYTES_;
+    const util::CoarseClock::Ticks INTERVAL_;
+    /// The time by which the buffer is written (BUFFERED)
+    util::CoarseClock::Ticks flushDue_;
+    /// The time by which the file is synchronized (SYNCED)
+    util::CoarseClock::Ticks syncDue_;
+    /// The count of bytes written since the latest synchronization
+    std::size_t unsynced_;
+    /// The range whose writeback was started last (WRITEBACK)
+    std::streamsize writebackFrom_;
+    std::streamsize writebackTo_;
+    /// Not used for shared files, as the trimming could cut off lines
+    const std::size_t PREALLOCATION_;
+    bool overwriting_;
+#ifndef WIN32
+    boost::scoped_ptr<MappedWindow> mapped_;
+#endif
     std::streamsize writtenSize_;
-    const boost::filesystem::path PATH_;
+    boost::filesystem::path path_;
+    util::CoarseClock::Ticks opened_;
+    /// The room returned by Reserve has not been committed yet
+    bool reserved_;
+    bool stopping_;
+    mutable boost::mutex mutex_;
+    boost::condition_variable condition_;
+    boost::thread timer_;
 };
 
 File::File(Opener &opener, policy::Path& path) :
@@ -56,6 +267,26 @@ std::streamsize File::Write(const std::string &line)
     return implementation_->Write(line);
 }
 
+char *File::Reserve(std::size_t size, std::size_t &available)
+{
+    return implementation_->Reserve(size, available);
+}
+
+std::streamsize File::Commit(std::size_t size)
+{
+    return implementation_->Commit(size);
+}
+
+bool File::BeginWritingAt( )
+{
+    return implementation_->BeginWritingAt( );
+}
+
+bool File::WriteAt(const std::string &text, std::streamsize offset) const
+{
+    return implementation_->WriteAt(text, offset);
+}
+
 bool operator==(const File &left, const File &right)
 {
     return left.implementation_->Compare(*right.implementation_);
@@ -71,17 +302,89 @@ std::streamsize File::WrittenSize( ) const
     return implementation_->WrittenSize( );
 }
 
+bool File::IsShared( ) const
+{
+    return implementation_->IsShared( );
+}
+
+util::CoarseClock::Ticks File::OpenTime( ) const
+{
+    return implementation_->OpenTime( );
+}
+
 const boost::filesystem::path &File::Path( ) const
 {
     return implementation_->Path( );
 }
 
+bool File::Rename(const boost::filesystem::path &name)
+{
+    return implementation_->Rename(name);
+}
+
 // File::Implementation class implementations
 
 File::Implementation::Implementation(Opener &opener, policy::Path& path) :
+    descriptor_(Opener::NO_DESCRIPTOR),
+    SHARED_(opener.shared_),
+    // The lines of the other processes must not be split by a partial line
+    BUFFER_SIZE_(opener.shared_ ? 0 :
+                 !opener.bufferSize_ && Opener::BUFFERED == opener.durability_ ?
+                 Opener::DEFAULT_BUFFER_SIZE : opener.bufferSize_),
+    buffered_(0),
+    durability_(opener.durability_),
+    SYNC_BYTES_(Opener::WRITEBACK == opener.durability_ &&
+                !opener.durabilityBytes_ ?
+                Opener::DEFAULT_WRITEBACK_SIZE : opener.durabilityBytes_),
+    INTERVAL_(opener.durabilityInterval_),
+    flushDue_(util::CoarseClock::NEVER),
+    syncDue_(util::CoarseClock::NEVER),
+    unsynced_(0),
+    writebackFrom_(0),
+    writebackTo_(0),
+    PREALLOCATION_(opener.shared_ ? 0 : opener.preallocation_),
+    overwriting_(false),
     writtenSize_(0),
-    PATH_(TryOpening(opener, path, file_))
+    path_(TryOpening(opener, path, file_, descriptor_)),
+    opened_(util::CoarseClock::Now( )),
+    reserved_(false),
+    stopping_(false)
 {
+#ifndef WIN32
+    if (Opener::NO_DESCRIPTOR != descriptor_)
+    {
+        const int FLAGS = fcntl(descriptor_, F_GETFL);
+        overwriting_ = FLAGS >= 0 && !(FLAGS & O_APPEND);
+        if (Opener::DSYNC == durability_)
+        {
+            OpenSynchronized( );
+        }
+
+        // The only seek, the size is counted from here on
+        const off_t END =
+            lseek(descriptor_, 0, overwriting_ ? SEEK_CUR : SEEK_END);
+        if (END > 0)
+        {
+            writtenSize_ = static_cast<std::streamsize>(END);
+        }
+
+        writebackFrom_ = writebackTo_ = writtenSize_;
+        if (Opener::SYNCED == durability_ && INTERVAL_)
+        {
+            syncDue_ = util::CoarseClock::Now( ) + INTERVAL_;
+        }
+
+        Preallocate( );
+        if (opener.mapping_ && !SHARED_)
+        {
+            Map(opener.mapping_);
+        }
+
+        StartTimer( );
+        return;
+    }
+#endif
+
     std::streamsize end = file_.tellp( );
     if (end > 0)
     {
@@ -89,7 +392,56 @@ File::Implementation::Implementation(Opener &opener, policy::Path& path) :
     }
 }
 
+File::Implementation::~Implementation( )
+{
+#ifndef WIN32
+    if (Opener::NO_DESCRIPTOR != descriptor_)
+    {
+        if (timer_.joinable( ))
+        {
+            {
+                Lock lock(mutex_);
+                stopping_ = true;
+            }
+
+            condition_.notify_one( );
+            timer_.join( );
+        }
+
+        Flush( );
+        if (Opener::SYNCED == durability_ && unsynced_)
+        {
+            fdatasync(descriptor_);
+        }
+
+        if (mapped_)
+        {
+            // The mapped file is truncated to the written size
+            mapped_.reset( );
+        }
+        else
+        {
+            Trim( );
+        }
+
+        close(descriptor_);
+    }
+#endif
+}
+
 std::streamsize File::Implementation::Write(const std::string &line)
+{
+    if (Opener::NO_DESCRIPTOR != descriptor_)
+    {
+        const Lock LOCK(LockForTimer( ));
+        reserved_ = false;
+        return WriteToDescriptor(line);
+    }
+
+    return WriteToStream(line);
+}
+
+std::streamsize File::Implementation::WriteToStream(const std::string &line)
 {
     // It can be a programming error, if the file buffer is not open. But it
     // is possible that the file just could not be opened. Because we are
@@ -109,24 +461,465 @@ std::streamsize File::Implementation::Write(const std::string &line)
     return DIFFERENCE;
 }
 
+std::streamsize
+File::Implementation::WriteToDescriptor(const std::string &line)
+{
+    const std::streamsize SIZE = static_cast<std::streamsize>(line.size( ));
+
+#ifndef WIN32
+    if (mapped_)
+    {
+        if (!mapped_->Write(line.data( ), line.size( )))
+        {
+            return -1;
+        }
+
+        writtenSize_ += SIZE;
+        return SIZE;
+    }
+#endif
+
+    if (buffered_ + line.size( ) <= BUFFER_SIZE_ && Allocate( ))
+    {
+        std::copy(line.begin( ), line.end( ), &buffer_[buffered_]);
+        buffered_ += line.size( );
+        writtenSize_ += SIZE;
+        CheckBuffer( );
+        return SIZE;
+    }
+
+    if (!Flush( ) || !WriteAll(descriptor_, line.data( ), line.size( )))
+    {
+        return -1;
+    }
+
+    writtenSize_ += SIZE;
+    Synchronize(line.size( ));
+    return SIZE;
+}
+
+bool File::Implementation::BeginWritingAt( )
+{
+#ifdef WIN32
+    return false;
+#else
+    const Lock LOCK(LockForTimer( ));
+
+    // The other processes would not know about the reserved offsets, and
+    // the end of an overwritten file is only known from the position
+    if (Opener::NO_DESCRIPTOR == descriptor_ || SHARED_ || overwriting_ ||
+        mapped_ || !Flush( ))
+    {
+        return false;
+    }
+
+    // With O_APPEND the offsets of pwrite would be ignored
+    const int FLAGS = fcntl(descriptor_, F_GETFL);
+    return FLAGS >= 0 && fcntl(descriptor_, F_SETFL, FLAGS & ~O_APPEND) >= 0;
+#endif
+}
+
+bool File::Implementation::WriteAt(const std::string &text,
+                                   std::streamsize offset) const
+{
+    if (Opener::NO_DESCRIPTOR == descriptor_)
+    {
+        return false;
+    }
+
+    return WriteAllAt(descriptor_, text.data( ), text.size( ), offset);
+}
+
+char *File::Implementation::Reserve(std::size_t size, std::size_t &available)
+{
+    available = 0;
+#ifndef WIN32
+    if (mapped_)
+    {
+        return 0;
+    }
+#endif
+
+    const Lock LOCK(LockForTimer( ));
+    if (Opener::NO_DESCRIPTOR == descriptor_ || !BUFFER_SIZE_ || !Allocate( ))
+    {
+        return 0;
+    }
+
+    if (BUFFER_SIZE_ - buffered_ < std::max<std::size_t>(size, 1) &&
+        !Flush( ))
+    {
+        return 0;
+    }
+
+    available = BUFFER_SIZE_ - buffered_;
+    reserved_ = true;
+    return &buffer_[buffered_];
+}
+
+std::streamsize File::Implementation::Commit(std::size_t size)
+{
+    assert(buffered_ + size <= buffer_.size( ));
+
+    const Lock LOCK(LockForTimer( ));
+    reserved_ = false;
+    buffered_ += size;
+    writtenSize_ += static_cast<std::streamsize>(size);
+    CheckBuffer( );
+    return static_cast<std::streamsize>(size);
+}
+
+bool File::Implementation::Allocate( )
+{
+    if (buffer_.size( ) == BUFFER_SIZE_)
+    {
+        return true;
+    }
+
+    try
+    {
+        buffer_.resize(BUFFER_SIZE_);
+    }
+    catch (const std::bad_alloc &)
+    {
+        // Written directly instead
+        return false;
+    }
+
+    return true;
+}
+
+bool File::Implementation::Flush( )
+{
+    if (!buffered_)
+    {
+        return true;
+    }
+
+    const bool RESULT = WriteAll(descriptor_, &buffer_[0], buffered_);
+    if (!RESULT)
+    {
+        // The buffered lines are lost, so they are not counted either
+        writtenSize_ -= static_cast<std::streamsize>(buffered_);
+    }
+    else
+    {
+        Synchronize(buffered_);
+    }
+
+    buffered_ = 0;
+    flushDue_ = util::CoarseClock::NEVER;
+    return RESULT;
+}
+
+void File::Implementation::CheckBuffer( )
+{
+    if (Opener::BUFFERED != durability_ || !INTERVAL_)
+    {
+        return;
+    }
+
+    const util::CoarseClock::Ticks NOW = util::CoarseClock::Now( );
+    if (util::CoarseClock::NEVER == flushDue_)
+    {
+        // The first line in the buffer
+        flushDue_ = NOW + INTERVAL_;
+    }
+    else if (NOW >= flushDue_)
+    {
+        Flush( );
+    }
+}
+
+void File::Implementation::Synchronize(std::size_t written)
+{
+#ifndef WIN32
+    if (Opener::SYNCED == durability_)
+    {
+        unsynced_ += written;
+        if ((!SYNC_BYTES_ && !INTERVAL_) ||
+            (SYNC_BYTES_ && unsynced_ >= SYNC_BYTES_) ||
+            (INTERVAL_ && util::CoarseClock::Now( ) >= syncDue_))
+        {
+            SynchronizeData( );
+        }
+
+        return;
+    }
+
+    const std::streamsize END = writtenSize_;
+    if (Opener::WRITEBACK != durability_ ||
+        END - writebackTo_ < static_cast<std::streamsize>(SYNC_BYTES_))
+    {
+        return;
+    }
+
+#ifdef SYNC_FILE_RANGE_WRITE
+    sync_file_range(descriptor_, writebackTo_, END - writebackTo_,
+                    SYNC_FILE_RANGE_WRITE);
+
+    // By now the previous range has most likely been written, so waiting
+    // for it rarely blocks, but keeps the amount of dirty pages bounded
+    if (writebackTo_ > writebackFrom_)
+    {
+        sync_file_range(descriptor_, writebackFrom_,
+                        writebackTo_ - writebackFrom_,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                        SYNC_FILE_RANGE_WAIT_AFTER);
+    }
+#else
+    fdatasync(descriptor_);
+#endif
+
+    writebackFrom_ = writebackTo_;
+    writebackTo_ = END;
+#endif
+}
+
+void File::Implementation::SynchronizeData( )
+{
+#ifndef WIN32
+    fdatasync(descriptor_);
+    unsynced_ = 0;
+    if (INTERVAL_)
+    {
+        syncDue_ = util::CoarseClock::Now( ) + INTERVAL_;
+    }
+#endif
+}
+
+void File::Implementation::StartTimer( )
+{
+    const bool BUFFERING = Opener::BUFFERED == durability_ && BUFFER_SIZE_;
+#ifndef WIN32
+    if (mapped_)
+    {
+        return;
+    }
+#endif
+
+    if (!INTERVAL_ || (!BUFFERING && Opener::SYNCED != durability_))
+    {
+        return;
+    }
+
+    try
+    {
+        // Started last, when the members are ready for the thread
+        timer_ = boost::thread(&File::Implementation::Run, this);
+    }
+    catch (...)
+    {
+        // The interval is then only checked when the lines are written
+    }
+}
+
+File::Implementation::Lock File::Implementation::LockForTimer( ) const
+{
+    // Without the thread the file is only used by one thread at a time
+    Lock lock(mutex_, boost::defer_lock);
+    if (timer_.joinable( ))
+    {
+        lock.lock( );
+    }
+
+    return lock;
+}
+
+void File::Implementation::Run( )
+{
+    // Retried this soon, if the buffer cannot be flushed yet
+    const util::CoarseClock::Ticks RESERVED_RETRY = 10;
+
+    Lock lock(mutex_);
+    while (!stopping_)
+    {
+        const util::CoarseClock::Ticks NOW = util::CoarseClock::Now( );
+        const util::CoarseClock::Ticks DUE =
+            Opener::BUFFERED == durability_ ? flushDue_ : syncDue_;
+
+        // Without a deadline, the first line added to the buffer sets one
+        // at most the interval ahead, so it is never missed
+        util::CoarseClock::Ticks wait = INTERVAL_;
+        if (NOW < DUE)
+        {
+            wait = std::min(DUE - NOW, INTERVAL_);
+        }
+        else if (Opener::SYNCED == durability_)
+        {
+            if (unsynced_)
+            {
+                SynchronizeData( );
+            }
+            else
+            {
+                syncDue_ = NOW + INTERVAL_;
+            }
+        }
+        else if (reserved_)
+        {
+            // The writer is formatting into the buffer
+            wait = std::min(RESERVED_RETRY, INTERVAL_);
+        }
+        else
+        {
+            Flush( );
+        }
+
+        condition_.timed_wait(lock, boost::posix_time::milliseconds(wait));
+    }
+}
+
+void File::Implementation::Preallocate( )
+{
+#if !defined(WIN32) && defined(FALLOC_FL_KEEP_SIZE)
+    const std::size_t WRITTEN = static_cast<std::size_t>(writtenSize_);
+    if (PREALLOCATION_ > WRITTEN)
+    {
+        // The size is kept, so that the readers never see the unwritten part.
+        // Failing is harmless, the space is then allocated while writing.
+        fallocate(descriptor_, FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(WRITTEN),
+                  static_cast<off_t>(PREALLOCATION_ - WRITTEN));
+    }
+#endif
+}
+
+void File::Implementation::Trim( )
+{
+#ifndef WIN32
+    off_t end = -1;
+    if (overwriting_)
+    {
+        end = lseek(descriptor_, 0, SEEK_CUR);
+    }
+    else if (PREALLOCATION_)
+    {
+        // Truncating to the current size releases the space beyond it
+        struct stat status;
+        if (!fstat(descriptor_, &status))
+        {
+            end = status.st_size;
+        }
+    }
+
+    if (end >= 0 && ftruncate(descriptor_, end))
+    {
+        // The file is left as it is. An overwritten file then ends with
+        // the old content, but it is still readable.
+    }
+#endif
+}
+
+void File::Implementation::Map(std::size_t size)
+{
+#ifndef WIN32
+    // The descriptor of the opener may be opened for writing only
+    const int DESCRIPTOR = open(path_.string( ).c_str( ), O_RDWR | O_CLOEXEC);
+    if (DESCRIPTOR < 0)
+    {
+        return;
+    }
+
+    try
+    {
+        mapped_.reset(new MappedWindow(DESCRIPTOR,
+                                       static_cast<off_t>(writtenSize_),
+                                       size));
+    }
+    catch (...)
+    {
+        // Written without the mapping
+        close(DESCRIPTOR);
+        return;
+    }
+
+    if (!mapped_->IsMapped( ))
+    {
+        mapped_.reset( );
+    }
+#endif
+}
+
+void File::Implementation::OpenSynchronized( )
+{
+#ifndef WIN32
+    const int FLAGS = fcntl(descriptor_, F_GETFL);
+    const int DESCRIPTOR = FLAGS < 0 ? -1 :
+        open(path_.string( ).c_str( ),
+             (FLAGS & O_APPEND) | O_WRONLY | O_DSYNC | O_CLOEXEC);
+    if (DESCRIPTOR < 0)
+    {
+        // Each line is synchronized with fdatasync instead
+        durability_ = Opener::SYNCED;
+        return;
+    }
+
+    // Both descriptors are at the beginning of an overwritten file
+    close(descriptor_);
+    descriptor_ = DESCRIPTOR;
+#endif
+}
+
 bool File::Implementation::Compare(const Implementation &other)
 {
-    return PATH_ == other.PATH_;
+    return path_ == other.path_;
 }
 
 std::streamsize File::Implementation::WrittenSize( ) const
 {
+    const Lock LOCK(LockForTimer( ));
+
+#ifndef WIN32
+    if (IsShared( ))
+    {
+        // Only called when the restrictions are checked, not for each line
+        struct stat status;
+        if (!fstat(descriptor_, &status))
+        {
+            return static_cast<std::streamsize>(status.st_size);
+        }
+    }
+#endif
+
     assert(writtenSize_ >= 0);
     return writtenSize_;
 }
 
+bool File::Implementation::IsShared( ) const
+{
+    return SHARED_ && Opener::NO_DESCRIPTOR != descriptor_;
+}
+
+util::CoarseClock::Ticks File::Implementation::OpenTime( ) const
+{
+    return opened_;
+}
+
 const boost::filesystem::path &File::Implementation::Path( ) const
 {
-    return PATH_;
+    return path_;
+}
+
+bool File::Implementation::Rename(const boost::filesystem::path &name)
+{
+    // The file stays open, so the written lines follow it to the new name
+    boost::system::error_code error;
+    boost::filesystem::rename(path_, name, error);
+    if (error)
+    {
+        return false;
+    }
+
+    // The age of the file is counted from the moment it got its name
+    path_ = name;
+    opened_ = util::CoarseClock::Now( );
+    return true;
 }
 
 boost::filesystem::path File::Implementation::
-TryOpening(Opener &opener, policy::Path &path, std::ofstream &file)
+TryOpening(Opener &opener, policy::Path &path, std::ofstream &file,
+           int &descriptor)
 {
     // The opening is done in this separate function, because it is possible
     // to fail for lack of memory. Any other exceptions are programming errors
@@ -136,6 +929,14 @@ TryOpening(Opener &opener, policy::Path &path, std::ofstream &file)
     /// implementations?
     try
     {
+#ifndef WIN32
+        boost::filesystem::path opened;
+        if (opener.DoOpenDescriptor(descriptor, path, opened))
+        {
+            return opened;
+        }
+#endif
+
         return opener.DoOpen(*file.rdbuf( ), path);
     }
     catch (const std::bad_alloc&)
@@ -150,6 +951,272 @@ TryOpening(Opener &opener, policy::Path &path, std::ofstream &file)
     return "";
 }
 
+// Local implementations
+
+namespace
+{
+
+bool WriteAll(int descriptor, const char *data, std::size_t size)
+{
+#ifdef WIN32
+    return false;
+#else
+    while (size)
+    {
+        const ssize_t RESULT = write(descriptor, data, size);
+        if (RESULT < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += RESULT;
+        size -= static_cast<std::size_t>(RESULT);
+    }
+
+    return true;
+#endif
+}
+
+bool WriteAllAt(int descriptor, const char *data, std::size_t size,
+                std::streamsize offset)
+{
+#ifdef WIN32
+    return false;
+#else
+    while (size)
+    {
+        const ssize_t RESULT = pwrite(descriptor, data, size,
+                                      static_cast<off_t>(offset));
+        if (RESULT < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += RESULT;
+        size -= static_cast<std::size_t>(RESULT);
+        offset += RESULT;
+    }
+
+    return true;
+#endif
+}
+
+#ifndef WIN32
+
+MappedWindow::MappedWindow(int descriptor, off_t end, std::size_t size) :
+    DESCRIPTOR_(descriptor),
+    SIZE_(RoundToPages(size)),
+    end_(end),
+    extended_(0),
+    stopping_(false)
+{
+    struct stat status;
+    if (fstat(DESCRIPTOR_, &status))
+    {
+        return;
+    }
+
+    extended_ = status.st_size;
+
+    Lock lock(mutex_);
+    if (!Map(end - end % static_cast<off_t>(SIZE_), current_))
+    {
+        return;
+    }
+
+    lock.unlock( );
+
+    try
+    {
+        // Started last, when the members are ready for the thread
+        thread_ = boost::thread(&MappedWindow::Run, this);
+    }
+    catch (...)
+    {
+        Unmap(current_);
+        if (ftruncate(DESCRIPTOR_, end_))
+        {
+            // The file ends with zeros
+        }
+
+        throw;
+    }
+}
+
+MappedWindow::~MappedWindow( )
+{
+    {
+        Lock lock(mutex_);
+        stopping_ = true;
+    }
+
+    condition_.notify_one( );
+    if (thread_.joinable( ))
+    {
+        thread_.join( );
+    }
+
+    Unmap(current_);
+    Unmap(next_);
+    std::for_each(retired_.begin( ), retired_.end( ),
+                  boost::bind(&MappedWindow::Unmap, this, _1));
+
+    // The readers must not see the zeros after the written part
+    if (extended_ != end_ && ftruncate(DESCRIPTOR_, end_))
+    {
+        // The file ends with zeros
+    }
+
+    close(DESCRIPTOR_);
+}
+
+bool MappedWindow::IsMapped( ) const
+{
+    return 0 != current_.data;
+}
+
+bool MappedWindow::Write(const char *data, std::size_t size)
+{
+    while (size)
+    {
+        const off_t WINDOW_END = current_.offset + static_cast<off_t>(SIZE_);
+        if (WINDOW_END == end_ && !Slide( ))
+        {
+            return false;
+        }
+
+        const std::size_t ROOM = static_cast<std::size_t>(
+            current_.offset + static_cast<off_t>(SIZE_) - end_);
+        const std::size_t PART = std::min(size, ROOM);
+        std::memcpy(current_.data + (end_ - current_.offset), data, PART);
+
+        end_ += static_cast<off_t>(PART);
+        data += PART;
+        size -= PART;
+    }
+
+    return true;
+}
+
+bool MappedWindow::Map(off_t offset, Window &window)
+{
+    const off_t END = offset + static_cast<off_t>(SIZE_);
+    if (END > extended_)
+    {
+        if (ftruncate(DESCRIPTOR_, END))
+        {
+            return false;
+        }
+
+        extended_ = END;
+    }
+
+    void *data = mmap(0, SIZE_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      DESCRIPTOR_, offset);
+    if (MAP_FAILED == data)
+    {
+        return false;
+    }
+
+    window.data = static_cast<char *>(data);
+    window.offset = offset;
+    return true;
+}
+
+void MappedWindow::Unmap(Window &window) const
+{
+    if (!window.data)
+    {
+        return;
+    }
+
+    // Starts the writeback without waiting for it
+    msync(window.data, SIZE_, MS_ASYNC);
+    munmap(window.data, SIZE_);
+    window.data = 0;
+}
+
+bool MappedWindow::Slide( )
+{
+    Lock lock(mutex_);
+
+    Window next;
+    std::swap(next, next_);
+    if (!next.data && !Map(current_.offset + static_cast<off_t>(SIZE_), next))
+    {
+        return false;
+    }
+
+    try
+    {
+        retired_.push_back(current_);
+    }
+    catch (const std::bad_alloc &)
+    {
+        // Unmapped by the writer instead
+        Unmap(current_);
+    }
+
+    current_ = next;
+    lock.unlock( );
+
+    condition_.notify_one( );
+    return true;
+}
+
+void MappedWindow::Run( )
+{
+    Lock lock(mutex_);
+    while (!stopping_)
+    {
+        // If the mapping fails, the writer tries again once it needs the
+        // window
+        if (!next_.data)
+        {
+            Map(current_.offset + static_cast<off_t>(SIZE_), next_);
+        }
+
+        WindowStore retired;
+        retired.swap(retired_);
+        lock.unlock( );
+
+        std::for_each(retired.begin( ), retired.end( ),
+                      boost::bind(&MappedWindow::Unmap, this, _1));
+
+        lock.lock( );
+        if (retired_.empty( ) && !stopping_)
+        {
+            condition_.wait(lock);
+        }
+    }
+}
+
+std::size_t RoundToPages(std::size_t size)
+{
+    const std::size_t PAGE = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return std::max<std::size_t>((size + PAGE - 1) / PAGE, 1) * PAGE;
+}
+
+MappedWindow::Window::Window( ) :
+    data(0),
+    offset(0)
+{
+}
+
+#endif
+
+}
+
 }
 }
 }
@@ -0,0 +1,368 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of class
+ * myrrh::log::policy::Manifest.
+ */
+
+#include "myrrh/log/policy/Manifest.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathEntity.hpp"
+#include "myrrh/file/MatchFiles.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/thread/mutex.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+typedef std::vector<std::string> Components;
+
+/**
+ * Returns the folder from which Appender starts scanning for the first
+ * entity of the path
+ */
+boost::filesystem::path StartFolder(const Path &path);
+
+/**
+ * Splits the given file path into one component per entity of the path
+ * @return false, if the file path does not match the rules of the path
+ */
+bool Split(const Path &path, const boost::filesystem::path &file,
+           Components &components);
+
+/**
+ * Tells if the left components name an earlier file than the right ones,
+ * according to the rules of the path
+ */
+bool IsEarlier(const Path &path, const Components &left,
+               const Components &right);
+
+/**
+ * Returns the modification time of the folder, or an empty string if it
+ * does not exist
+ */
+std::string Stamp(const boost::filesystem::path &folder);
+
+}
+
+/**
+ * The manifest file contains the recorded file on the first line and the
+ * modification times of the scanned folders on the following lines, one for
+ * each entity of the path.
+ */
+class Manifest::Implementation
+{
+public:
+
+    explicit Implementation(const boost::filesystem::path &file);
+    bool Lookup(const Path &path, boost::filesystem::path &latest) const;
+    void Record(const Path &path, const boost::filesystem::path &opened);
+
+private:
+
+    typedef boost::mutex::scoped_lock Lock;
+
+    /// Reads the content of the manifest file
+    bool Read(boost::filesystem::path &recorded, Components &stamps) const;
+    /// Removes the manifest file, so that the folders will be scanned
+    void Remove( ) const;
+
+    const boost::filesystem::path FILE_;
+    mutable boost::mutex mutex_;
+};
+
+// Class implementations
+
+Manifest::Manifest(const boost::filesystem::path &file) :
+    implementation_(new Implementation(file))
+{
+}
+
+bool Manifest::Lookup(const Path &path, boost::filesystem::path &latest) const
+{
+    return implementation_->Lookup(path, latest);
+}
+
+void Manifest::Record(const Path &path, const boost::filesystem::path &opened)
+{
+    implementation_->Record(path, opened);
+}
+
+Manifest::Implementation::Implementation(const boost::filesystem::path &file) :
+    FILE_(file)
+{
+}
+
+bool Manifest::Implementation::Lookup(const Path &path,
+                                      boost::filesystem::path &latest) const
+{
+    try
+    {
+        Lock lock(mutex_);
+
+        boost::filesystem::path recorded;
+        Components stamps;
+        Components components;
+        if (!Read(recorded, stamps) || !Split(path, recorded, components) ||
+            stamps.size( ) != components.size( ))
+        {
+            return false;
+        }
+
+        boost::filesystem::path folder(StartFolder(path));
+        for (std::size_t i = 0; i < stamps.size( ); ++i)
+        {
+            if (Stamp(folder) != stamps[i])
+            {
+                return false;
+            }
+
+            folder /= components[i];
+        }
+
+        if (!boost::filesystem::exists(recorded) ||
+            boost::filesystem::is_directory(recorded))
+        {
+            return false;
+        }
+
+        latest = recorded;
+        return true;
+    }
+    catch (...)
+    {
+    }
+
+    return false;
+}
+
+void Manifest::Implementation::Record(const Path &path,
+                                      const boost::filesystem::path &opened)
+{
+    try
+    {
+        Lock lock(mutex_);
+
+        Components components;
+        if (!Split(path, opened, components))
+        {
+            Remove( );
+            return;
+        }
+
+        boost::filesystem::path previous;
+        Components previousStamps;
+        Components previousComponents;
+        if (Read(previous, previousStamps) &&
+            Split(path, previous, previousComponents) &&
+            IsEarlier(path, components, previousComponents))
+        {
+            Remove( );
+            return;
+        }
+
+        // The manifest is created before reading the stamps, because it may
+        // be located in one of the folders. Rewriting it later does not
+        // modify the folder.
+        std::ofstream output(FILE_.string( ).c_str( ),
+                             std::ios::out | std::ios::trunc);
+        if (!output.is_open( ))
+        {
+            return;
+        }
+
+        std::string content(opened.string( ) + '\n');
+        boost::filesystem::path folder(StartFolder(path));
+        for (Components::const_iterator i = components.begin( );
+             components.end( ) != i;
+             ++i)
+        {
+            const std::string STAMP(Stamp(folder));
+            if (STAMP.empty( ))
+            {
+                output.close( );
+                Remove( );
+                return;
+            }
+
+            content += STAMP + '\n';
+            folder /= *i;
+        }
+
+        output << content;
+    }
+    catch (...)
+    {
+        // The folders are scanned at the next start-up
+    }
+}
+
+bool Manifest::Implementation::Read(boost::filesystem::path &recorded,
+                                    Components &stamps) const
+{
+    std::ifstream input(FILE_.string( ).c_str( ));
+    std::string line;
+    if (!std::getline(input, line) || line.empty( ))
+    {
+        return false;
+    }
+
+    recorded = line;
+    while (std::getline(input, line))
+    {
+        stamps.push_back(line);
+    }
+
+    return !stamps.empty( );
+}
+
+void Manifest::Implementation::Remove( ) const
+{
+    boost::system::error_code error;
+    boost::filesystem::remove(FILE_, error);
+}
+
+// Local implementations
+
+namespace
+{
+
+boost::filesystem::path StartFolder(const Path &path)
+{
+    const boost::filesystem::path PARENT_PATH(path.ParentPath( ));
+    if (PARENT_PATH.empty( ))
+    {
+        return ".";
+    }
+
+    return PARENT_PATH;
+}
+
+bool Split(const Path &path, const boost::filesystem::path &file,
+           Components &components)
+{
+    const std::string PARENT(path.ParentPath( ).string( ));
+    const std::string FILE(file.string( ));
+    if (FILE.compare(0, PARENT.size( ), PARENT))
+    {
+        return false;
+    }
+
+    std::string component;
+    for (std::string::const_iterator i = FILE.begin( ) + PARENT.size( );
+         FILE.end( ) != i;
+         ++i)
+    {
+        if ('/' != *i && '\\' != *i)
+        {
+            component += *i;
+        }
+        else if (!component.empty( ))
+        {
+            components.push_back(component);
+            component.clear( );
+        }
+    }
+
+    if (!component.empty( ))
+    {
+        components.push_back(component);
+    }
+
+    if (static_cast<std::ptrdiff_t>(components.size( )) !=
+        std::distance(path.BeginEntity( ), path.EndEntity( )))
+    {
+        return false;
+    }
+
+    Path::EntityIterator entity(path.BeginEntity( ));
+    for (Components::const_iterator i = components.begin( );
+         components.end( ) != i;
+         ++i, ++entity)
+    {
+        if (!entity->Matcher( )(boost::filesystem::path(*i)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool IsEarlier(const Path &path, const Components &left,
+               const Components &right)
+{
+    Path::EntityIterator entity(path.BeginEntity( ));
+    for (std::size_t i = 0; i < left.size( ); ++i, ++entity)
+    {
+        Path::Entity::Key leftKey;
+        Path::Entity::Key rightKey;
+        if (entity->Parse(left[i], leftKey) &&
+            entity->Parse(right[i], rightKey) && leftKey != rightKey)
+        {
+            return leftKey < rightKey;
+        }
+    }
+
+    return false;
+}
+
+std::string Stamp(const boost::filesystem::path &folder)
+{
+#ifdef __linux__
+    // The nanoseconds are needed to notice the files added within the same
+    // second
+    struct stat status;
+    if (stat(folder.string( ).c_str( ), &status) || !S_ISDIR(status.st_mode))
+    {
+        return "";
+    }
+
+    using boost::lexical_cast;
+    return lexical_cast<std::string>(status.st_mtim.tv_sec) + '.' +
+           lexical_cast<std::string>(status.st_mtim.tv_nsec);
+#else
+    boost::system::error_code error;
+    const std::time_t TIME = boost::filesystem::last_write_time(folder, error);
+    if (error)
+    {
+        return "";
+    }
+
+    return boost::lexical_cast<std::string>(TIME);
+#endif
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,105 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains implementation of function
+ * myrrh::log::policy::MatchLogs
+ */
+
+#include "myrrh/log/policy/MatchLogs.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathEntity.hpp"
+#include "myrrh/file/ScanFolder.hpp"
+
+#include <algorithm>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * Returns the folder from which the matching starts
+ */
+boost::filesystem::path SelectParentPath(const Path &path);
+
+}
+
+file::PathStore MatchLogs(const Path &path, std::size_t threads)
+{
+    using namespace file;
+
+    PathStore folders(1, SelectParentPath(path));
+    if (!boost::filesystem::exists(folders.front( )))
+    {
+        return PathStore( );
+    }
+
+    PathStore result;
+    for (Path::EntityIterator i(path.BeginEntity( ));
+         path.EndEntity( ) != i;
+         ++i)
+    {
+        const bool IS_LAST = i + 1 == path.EndEntity( );
+        const ExpressionMatcher MATCHER(i->Matcher( ));
+        const EntryStore FOUND(ScanFolders(folders,
+            [&](const std::string &name)
+            {
+                return MATCHER(name);
+            },
+            threads));
+
+        PathStore matches;
+        for (EntryStore::const_iterator j(FOUND.begin( ));
+             FOUND.end( ) != j;
+             ++j)
+        {
+            // Only the last entity names files, the others folders
+            if (j->isDirectory != IS_LAST)
+            {
+                (IS_LAST ? result : matches).push_back(j->path);
+            }
+        }
+
+        folders.swap(matches);
+    }
+
+    std::sort(result.begin( ), result.end( ));
+
+    return result;
+}
+
+// Local implementations
+
+namespace
+{
+
+boost::filesystem::path SelectParentPath(const Path &path)
+{
+    const boost::filesystem::path PARENT_PATH(path.ParentPath( ));
+    if (PARENT_PATH.empty( ))
+    {
+        return ".";
+    }
+
+    return PARENT_PATH;
+}
+
+}
+
+}
+
+}
+
+}
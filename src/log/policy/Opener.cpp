@@ -13,6 +13,14 @@
 #include "myrrh/log/policy/Opener.hpp"
 #include "myrrh/log/policy/Path.hpp"
 #include "myrrh/log/policy/File.hpp"
+#include "myrrh/log/policy/Manifest.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
 namespace myrrh
 {
@@ -21,13 +29,143 @@ namespace log
 namespace policy
 {
 
+const int Opener::NO_DESCRIPTOR;
+const std::size_t Opener::DEFAULT_BUFFER_SIZE;
+const std::size_t Opener::DEFAULT_WRITEBACK_SIZE;
+
+Opener::Opener( ) :
+    bufferSize_(0),
+    preallocation_(0),
+    mapping_(0),
+    durability_(FLUSHED),
+    durabilityBytes_(0),
+    durabilityInterval_(0),
+    shared_(false)
+{
+}
+
 Opener::~Opener( )
 {
 }
 
 FilePtr Opener::Open(Path path)
 {
-    return FilePtr(new (std::nothrow) File(*this, path));
+    FilePtr file(new (std::nothrow) File(*this, path));
+    if (file && manifest_)
+    {
+        manifest_->Record(path, file->Path( ));
+    }
+
+    return file;
+}
+
+FilePtr Opener::OpenTemporary(const boost::filesystem::path &folder)
+{
+    try
+    {
+        Path temporary(folder);
+        temporary += boost::filesystem::unique_path(
+            ".%%%%-%%%%-%%%%-%%%%.tmp").string( );
+        return FilePtr(new File(*this, temporary));
+    }
+    catch (...)
+    {
+        return FilePtr( );
+    }
+}
+
+bool Opener::Name(File &file, const Path &path,
+                  const boost::filesystem::path &name)
+{
+    if (!file.Rename(name))
+    {
+        return false;
+    }
+
+    if (manifest_)
+    {
+        manifest_->Record(path, file.Path( ));
+    }
+
+    return true;
+}
+
+void Opener::SetBufferSize(std::size_t size)
+{
+    bufferSize_ = size;
+}
+
+void Opener::SetPreallocation(std::size_t size)
+{
+    preallocation_ = size;
+}
+
+void Opener::SetMapping(std::size_t size)
+{
+    mapping_ = size;
+}
+
+void Opener::SetDurability(Durability durability, std::size_t bytes,
+                           unsigned int interval)
+{
+    durability_ = durability;
+    durabilityBytes_ = bytes;
+    durabilityInterval_ = interval;
+}
+
+void Opener::SetManifest(ManifestPtr manifest)
+{
+    manifest_ = manifest;
+}
+
+void Opener::SetShared(bool shared)
+{
+    shared_ = shared;
+}
+
+const ManifestPtr &Opener::GetManifest( ) const
+{
+    return manifest_;
+}
+
+int Opener::OpenDescriptor(const boost::filesystem::path &path, bool truncate)
+{
+#ifdef WIN32
+    return NO_DESCRIPTOR;
+#else
+    const int FLAGS =
+        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+    return open(path.string( ).c_str( ), FLAGS, 0666);
+#endif
+}
+
+int Opener::OverwriteDescriptor(const boost::filesystem::path &path)
+{
+#ifdef WIN32
+    return NO_DESCRIPTOR;
+#else
+    // Without O_APPEND, the writing starts from the beginning
+    const int DESCRIPTOR = open(path.string( ).c_str( ), O_WRONLY | O_CLOEXEC);
+#ifdef FALLOC_FL_ZERO_RANGE
+    struct stat status;
+    if (DESCRIPTOR >= 0 && !fstat(DESCRIPTOR, &status) && status.st_size)
+    {
+        // The blocks are kept as unwritten extents, so only the metadata is
+        // written. Failing leaves the old lines visible until the file is
+        // closed, which is no reason to give up recycling.
+        fallocate(DESCRIPTOR, FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE, 0,
+                  status.st_size);
+    }
+#endif
+    return DESCRIPTOR;
+#endif
+}
+
+bool Opener::DoOpenDescriptor(int &descriptor, Path &,
+                              boost::filesystem::path &)
+{
+    descriptor = NO_DESCRIPTOR;
+    return false;
 }
 
 }
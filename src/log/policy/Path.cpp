@@ -36,13 +36,15 @@ public:
     explicit Implementation(const boost::filesystem::path &parentPath);
     const boost::filesystem::path &ParentPath( ) const;
     boost::filesystem::path Generate( );
+    boost::filesystem::path GenerateFolder( );
+    bool Parse(const boost::filesystem::path &file, std::string &key) const;
     void Add(const PartSum &parts);
     void Add(const std::string &path);
     EntityIterator BeginEntity( ) const;
     EntityIterator EndEntity( ) const;
     void AppendRestrictions(RestrictionStore &store) const;
 private:
-    boost::filesystem::path CombineEntities( );
+    boost::filesystem::path CombineEntities(bool withName = true);
     static EntityStore AddNewParts(const EntityStore &store,
                                    const PartSum &parts);
     static void AddNewEntity(EntityStore &store, const PartStore &parts);
@@ -76,6 +78,16 @@ boost::filesystem::path Path::Generate( )
     return implementation_->Generate( );
 }
 
+boost::filesystem::path Path::GenerateFolder( )
+{
+    return implementation_->GenerateFolder( );
+}
+
+bool Path::Parse(const boost::filesystem::path &file, std::string &key) const
+{
+    return implementation_->Parse(file, key);
+}
+
 Path &Path::operator+=(const PartSum &parts)
 {
     implementation_->Add(parts);
@@ -119,6 +131,47 @@ boost::filesystem::path Path::Implementation::Generate( )
     return PARENT_PATH_ / CombineEntities( );
 }
 
+boost::filesystem::path Path::Implementation::GenerateFolder( )
+{
+    return PARENT_PATH_ / CombineEntities(false);
+}
+
+bool Path::Implementation::Parse(const boost::filesystem::path &file,
+                                 std::string &key) const
+{
+    // The last names of the file path belong to the entities
+    std::vector<std::string> names;
+    boost::filesystem::path remaining(file);
+    for (std::size_t i = 0; i < entityStore_.size( ); ++i)
+    {
+        if (remaining.empty( ))
+        {
+            return false;
+        }
+
+        names.push_back(remaining.leaf( ).string( ));
+        remaining = remaining.branch_path( );
+    }
+
+    Entity::Key result;
+    std::vector<std::string>::const_reverse_iterator name(names.rbegin( ));
+    for (EntityIterator i = entityStore_.begin( );
+         entityStore_.end( ) != i;
+         ++i, ++name)
+    {
+        Entity::Key part;
+        if (!i->Parse(*name, part))
+        {
+            return false;
+        }
+
+        result += part;
+    }
+
+    key.swap(result);
+    return true;
+}
+
 void Path::Implementation::Add(const PartSum &parts)
 {
     auto copy = AddNewParts(entityStore_, parts);
@@ -142,12 +195,15 @@ Path::EntityIterator Path::Implementation::EndEntity( ) const
     return entityStore_.end( );
 }
 
-boost::filesystem::path Path::Implementation::CombineEntities( )
+boost::filesystem::path Path::Implementation::CombineEntities(bool withName)
 {
     boost::filesystem::path result;
 
+    // The last entity is the name of the file
     typedef EntityStore::iterator EntityIter;
-    for (EntityIter i = entityStore_.begin( ); entityStore_.end( ) != i; ++i)
+    const EntityIter END(withName || entityStore_.empty( ) ?
+                         entityStore_.end( ) : entityStore_.end( ) - 1);
+    for (EntityIter i = entityStore_.begin( ); END != i; ++i)
     {
         result /= boost::filesystem::path(i->Generate( ));
     }
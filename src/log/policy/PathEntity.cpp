@@ -15,30 +15,6 @@ namespace log
 namespace policy
 {
 
-// Local declarations
-
-namespace
-{
-
-enum Comparison
-{
-    LESS = 0,
-    EVEN,
-    MORE
-};
-
-bool IsFolder(const PathPartPtr &part);
-boost::regex operator+(const boost::regex &left, const boost::regex &right);
-
-/**
- * @todo Refactor. The code is a bit too complex to understand
- */
-std::string FirstMatch(const boost::regex &expression,
-                       const std::string &toMatch);
-Comparison CompareAndUpdate(const PathPart &part, std::string &left,
-                            std::string &right);
-}
-
 // Path::Entity class implementations
 
 Path::Entity::Entity( )
@@ -49,6 +25,24 @@ void Path::Entity::Add(const PartStore &parts)
 {
     assert(!parts.empty( ));
     partStore_.insert(partStore_.end( ), parts.begin( ), parts.end( ));
+
+    // Each part is put into a sub-expression of its own, so that the matches
+    // of the parts can be read from a single match of the whole name
+    std::string expression;
+    std::vector<int> groups;
+    int group = 1;
+
+    typedef PartStore::const_iterator PartIter;
+    for (PartIter i = partStore_.begin( ); partStore_.end( ) != i; ++i)
+    {
+        const boost::regex PART((*i)->GetExpression( ));
+        expression += '(' + PART.str( ) + ')';
+        groups.push_back(group);
+        group += 1 + static_cast<int>(PART.mark_count( ));
+    }
+
+    expression_.reset(new boost::regex(expression));
+    groups_.swap(groups);
 }
 
 std::string Path::Entity::Generate( )
@@ -66,15 +60,8 @@ std::string Path::Entity::Generate( )
 
 file::ExpressionMatcher Path::Entity::Matcher( ) const
 {
-    boost::regex result;
-
-    typedef PartStore::const_iterator PartIter;
-    for (PartIter i = partStore_.begin( ); partStore_.end( ) != i; ++i)
-    {
-        result = result + (*i)->GetExpression( );
-    }
-
-    return file::ExpressionMatcher(result);
+    assert(expression_);
+    return file::ExpressionMatcher(*expression_);
 }
 
 Path::Entity::Comparer Path::Entity::GetComparer( ) const
@@ -86,93 +73,54 @@ Path::Entity::Comparer Path::Entity::GetComparer( ) const
     };
 }
 
-// Divide smaller
-bool Path::Entity::IsFirstEarlier(const boost::filesystem::path &left,
-                                  const boost::filesystem::path &right) const
+bool Path::Entity::Parse(const boost::filesystem::path &path,
+                         Key &key) const
 {
-    std::string leftString(left.string( ));
-    std::string rightString(right.string( ));
+    assert(expression_);
+    assert(groups_.size( ) == partStore_.size( ));
 
-    assert(Matcher( )(leftString));
-    assert(Matcher( )(rightString));
+    const std::string NAME(path.leaf( ).string( ));
+    boost::smatch match;
+    if (!boost::regex_match(NAME, match, *expression_))
+    {
+        return false;
+    }
 
-    // Why is there a loop, if always comparing only the first?
-    typedef PartStore::const_iterator PartIter;
-    for (PartIter i = partStore_.begin( ); partStore_.end( ) != i; ++i)
+    // The keys of the parts are separated with null characters, which sort
+    // before any other. Thus a shorter key of a part is earlier than a longer
+    // one that starts with it, as it is when the strings are compared.
+    Key result;
+    for (std::size_t i = 0; i < partStore_.size( ); ++i)
     {
-        assert(!leftString.empty( ));
-        assert(!rightString.empty( ));
-        switch (CompareAndUpdate(**i, leftString, rightString))
-        {
-        case LESS:
-            return true;
-        case EVEN:
-            break;
-        case MORE:
-            return false;
-        default:
-            assert(false && "Unidentified Comparison enum value");
-        }
+        result += partStore_[i]->SortKey(match.str(groups_[i]));
+        result += '\0';
     }
 
+    key.swap(result);
     return true;
 }
 
-void Path::Entity::AppendRestrictions(RestrictionStore &store) const
+bool Path::Entity::IsFirstEarlier(const boost::filesystem::path &left,
+                                  const boost::filesystem::path &right) const
 {
-    for (auto i = partStore_.begin( ); partStore_.end( ) != i; ++i)
+    Key leftKey;
+    Key rightKey;
+    if (!Parse(left, leftKey) || !Parse(right, rightKey))
     {
-        (*i)->AppendRestrictions(store);
+        assert(false && "Compared path does not match the entity");
+        return false;
     }
-}
-
-// Local implementations
-
-namespace
-{
-
-inline boost::regex operator+(const boost::regex &left,
-                              const boost::regex &right)
-{
-    return boost::regex(left.str( ) + right.str( ));
-}
-
-std::string FirstMatch(const boost::regex &expression,
-                       const std::string &toMatch)
-{
-    boost::sregex_iterator matches(toMatch.begin( ), toMatch.end( ),
-                                   expression);
-    assert(matches != boost::sregex_iterator( ));
-    assert(matches->begin( ) != matches->end( ));
 
-    return *matches->begin( );
+    // Equal names are considered earlier as well
+    return !(rightKey < leftKey);
 }
 
-// Divide smaller
-Comparison CompareAndUpdate(const PathPart &part, std::string &left,
-                            std::string &right)
+void Path::Entity::AppendRestrictions(RestrictionStore &store) const
 {
-    const boost::regex EXPRESSION(part.GetExpression( ));
-
-    const std::string LEFT_MATCH(FirstMatch(EXPRESSION, left));
-    const std::string RIGHT_MATCH(FirstMatch(EXPRESSION, right));
-
-    if (part.IsFirstEarlier(LEFT_MATCH, RIGHT_MATCH))
-    {
-        return LESS;
-    }
-
-    if (part.IsFirstEarlier(RIGHT_MATCH, LEFT_MATCH))
+    for (auto i = partStore_.begin( ); partStore_.end( ) != i; ++i)
     {
-        return MORE;
+        (*i)->AppendRestrictions(store);
     }
-
-    left = left.substr(LEFT_MATCH.size( ));
-    right = right.substr(RIGHT_MATCH.size( ));
-
-    return EVEN;
-}
-
 }
 
 }
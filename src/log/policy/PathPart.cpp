@@ -29,7 +29,9 @@
 
 #ifdef WIN32
 #include <process.h>
+#include <windows.h>
 #else
+#include <sys/syscall.h>
 #include <unistd.h>
 #endif
 
@@ -47,11 +49,28 @@ namespace policy
 namespace
 {
 
+/// Matches the hours of a day
+const std::string HOURS_EXPRESSION("([01]\\d|2[0-3])");
+/// Matches the minutes of an hour
+const std::string MINUTES_EXPRESSION("([0-5]\\d)");
+/// The count of index digits that are compared. Fits into a char.
+const std::size_t MAX_KEY_DIGITS = 127;
+
 /**
  * Constructs a regular expression string that matches timestamps
  */
 std::string TimeExpression( );
 
+/**
+ * Returns the count of minutes passed since the local midnight
+ */
+unsigned int LocalMinutes( );
+
+/**
+ * Formats the given minutes of a day as "HHMM"
+ */
+std::string FormatMinutes(unsigned int minutes);
+
 /**
  * Constructs a regular expression string that matches timestamp fractions
  */
@@ -62,6 +81,11 @@ std::string FractionString( );
  */
 std::string GetProcessId( );
 
+/**
+ * Returns the id of the calling thread as string
+ */
+std::string GetThreadId( );
+
 /**
  * A helper function for creating new PartSum object from a PathPart object
  * @param A PathPart object to be added to the new PartSum object.
@@ -92,6 +116,16 @@ bool PathPart::IsFirstEarlier(const std::string &left, const std::string &right)
     return DoIsFirstEarlier(left, right);
 }
 
+std::string PathPart::SortKey(const std::string &match) const
+{
+    return DoSortKey(match);
+}
+
+std::string PathPart::DoSortKey(const std::string &match) const
+{
+    return match;
+}
+
 // PartSum class implementation
 
 PartSum::PartSum( )
@@ -160,6 +194,11 @@ bool Text::DoIsFirstEarlier(const std::string &, const std::string &) const
     return false;
 }
 
+std::string Text::DoSortKey(const std::string &) const
+{
+    return "";
+}
+
 Text::operator PartSum( ) const
 {
     return NewPartSum(*this);
@@ -343,6 +382,71 @@ Time::operator PartSum( ) const
     return NewPartSum(*this);
 }
 
+// Hour class implementation
+
+std::string Hour::DoGenerate( )
+{
+    return FormatMinutes(LocalMinutes( )).substr(0, 2);
+}
+
+boost::regex Hour::DoGetExpression( ) const
+{
+    return boost::regex(HOURS_EXPRESSION);
+}
+
+void Hour::AppendRestrictions(RestrictionStore &store)
+{
+    RestrictionPtr restriction(new IntervalRestriction(60));
+    store.Add(restriction);
+}
+
+bool Hour::DoIsFirstEarlier(const std::string &left,
+                            const std::string &right) const
+{
+    return left < right;
+}
+
+Hour::operator PartSum( ) const
+{
+    return NewPartSum(*this);
+}
+
+// Minutes class implementation
+
+Minutes::Minutes(unsigned int interval) :
+    interval_(interval)
+{
+    assert(interval > 0 && interval <= IntervalRestriction::MINUTES_IN_DAY);
+}
+
+std::string Minutes::DoGenerate( )
+{
+    const unsigned int PASSED = LocalMinutes( );
+    return FormatMinutes(PASSED - PASSED % std::max(1u, interval_));
+}
+
+boost::regex Minutes::DoGetExpression( ) const
+{
+    return boost::regex(HOURS_EXPRESSION + MINUTES_EXPRESSION);
+}
+
+void Minutes::AppendRestrictions(RestrictionStore &store)
+{
+    RestrictionPtr restriction(new IntervalRestriction(interval_));
+    store.Add(restriction);
+}
+
+bool Minutes::DoIsFirstEarlier(const std::string &left,
+                               const std::string &right) const
+{
+    return left < right;
+}
+
+Minutes::operator PartSum( ) const
+{
+    return NewPartSum(*this);
+}
+
 // Index class implementation
 
 Index::Index( ) :
@@ -369,7 +473,18 @@ void Index::AppendRestrictions(RestrictionStore &)
 bool Index::DoIsFirstEarlier(const std::string &left,
                              const std::string &right) const
 {
-    return boost::lexical_cast<int>(left) < boost::lexical_cast<int>(right);
+    return DoSortKey(left) < DoSortKey(right);
+}
+
+std::string Index::DoSortKey(const std::string &match) const
+{
+    const std::size_t FIRST = std::min(match.find_first_not_of('0'),
+                                       match.size( ) - 1);
+    const std::size_t DIGITS = std::min<std::size_t>(match.size( ) - FIRST,
+                                                     MAX_KEY_DIGITS);
+
+    // The count is never zero, so the key does not contain null characters
+    return static_cast<char>(DIGITS) + match.substr(FIRST, DIGITS);
 }
 
 Index::operator PartSum( ) const
@@ -379,8 +494,9 @@ Index::operator PartSum( ) const
 
 // ProcessId class implementation
 
-ProcessId::ProcessId( ) :
-    pid_(GetProcessId( ))
+ProcessId::ProcessId(Match match) :
+    pid_(GetProcessId( )),
+    match_(match)
 {
 }
 
@@ -391,6 +507,11 @@ std::string ProcessId::DoGenerate( )
 
 boost::regex ProcessId::DoGetExpression( ) const
 {
+    if (ANY == match_)
+    {
+        return boost::regex("\\d+");
+    }
+
     return boost::regex(pid_);
 }
 
@@ -403,11 +524,52 @@ bool ProcessId::DoIsFirstEarlier(const std::string &, const std::string &) const
     return false;
 }
 
+std::string ProcessId::DoSortKey(const std::string &) const
+{
+    return "";
+}
+
 ProcessId::operator PartSum( ) const
 {
     return NewPartSum(*this);
 }
 
+// ThreadId class implementation
+
+ThreadId::ThreadId( ) :
+    tid_(GetThreadId( ))
+{
+}
+
+std::string ThreadId::DoGenerate( )
+{
+    return tid_;
+}
+
+boost::regex ThreadId::DoGetExpression( ) const
+{
+    return boost::regex(tid_);
+}
+
+void ThreadId::AppendRestrictions(RestrictionStore &)
+{
+}
+
+bool ThreadId::DoIsFirstEarlier(const std::string &, const std::string &) const
+{
+    return false;
+}
+
+std::string ThreadId::DoSortKey(const std::string &) const
+{
+    return "";
+}
+
+ThreadId::operator PartSum( ) const
+{
+    return NewPartSum(*this);
+}
+
 /// Divide smaller
 PartSum &operator+=(PartSum &left, const std::string &right)
 {
@@ -478,6 +640,22 @@ std::string FractionString( )
     return boost::lexical_cast<std::string>(FRACTION_SIZE);
 }
 
+unsigned int LocalMinutes( )
+{
+    using namespace boost::posix_time;
+    const time_duration NOW(second_clock::local_time( ).time_of_day( ));
+    return static_cast<unsigned int>(NOW.hours( ) * 60 + NOW.minutes( ));
+}
+
+std::string FormatMinutes(unsigned int minutes)
+{
+    std::ostringstream stream;
+    stream << std::setfill('0') << std::setw(2) << minutes / 60
+           << std::setfill('0') << std::setw(2) << minutes % 60;
+
+    return stream.str( );
+}
+
 /// @todo This is now duplicated both into production and test code
 std::string GetProcessId( )
 {
@@ -490,6 +668,17 @@ std::string GetProcessId( )
     return boost::lexical_cast<std::string>(PID);
 }
 
+std::string GetThreadId( )
+{
+#ifdef WIN32
+    const unsigned long TID(GetCurrentThreadId( ));
+#else
+    const long TID(syscall(SYS_gettid));
+#endif
+
+    return boost::lexical_cast<std::string>(TID);
+}
+
 template <typename T>
 inline PartSum NewPartSum(const T &part)
 {
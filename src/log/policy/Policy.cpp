@@ -10,11 +10,20 @@
  */
 
 #include "myrrh/log/policy/Policy.hpp"
+#include "myrrh/log/policy/Compressor.hpp"
 #include "myrrh/log/policy/RestrictionStore.hpp"
 #include "myrrh/log/policy/Path.hpp"
 #include "myrrh/log/policy/Opener.hpp"
 #include "myrrh/log/policy/File.hpp"
+#include "myrrh/log/policy/Retention.hpp"
+#include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <cassert>
+#include <new>
 
 namespace myrrh
 {
@@ -85,6 +94,64 @@ private:
 
 typedef SizeAdjusterImpl<ADJUSTING_NEEDED> SizeAdjuster;
 
+/**
+ * Opens the next file under a temporary name in a background thread, so that
+ * the writing thread only needs to name it and take it into use. The
+ * restrictions of the path are checked periodically for the prepared file.
+ * Once they apply, the folder of the prepared file may be outdated and the
+ * file is replaced.
+ *
+ * The lock is only held while the path and the prepared file are handled in
+ * memory. The files are opened, renamed and removed without it, so the
+ * writing thread never waits for the background thread to open a file.
+ */
+class Preparer
+{
+public:
+
+    /**
+     * Constructor. The path is only generated while holding the lock of the
+     * Preparer object. Its rules, which do not change, are also read
+     * without the lock.
+     */
+    Preparer(Path &path, OpenerPtr opener);
+    ~Preparer( );
+
+    /**
+     * Generates the next path and returns the prepared file under it. If
+     * there is none ready, or it cannot be given the path, the file is
+     * opened immediately with the path.
+     */
+    FilePtr Take( );
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    /// The loop of the background thread
+    void Run( );
+    /// Opens the next file under a temporary name in the next folder. The
+    /// lock is released while opening.
+    void Prepare(Lock &lock);
+    /// Opens the next file with the path. Requires the lock.
+    FilePtr Open( );
+    /// Tells if the restrictions of the path have applied after Prepare
+    bool IsOutdated( );
+    /// Removes the file, if nothing has been written to it
+    static void Discard(FilePtr &file);
+
+    static const boost::posix_time::time_duration INTERVAL;
+
+    Path &path_;
+    OpenerPtr opener_;
+    FilePtr next_;
+    RestrictionStore validity_;
+    bool stopping_;
+    boost::mutex mutex_;
+    boost::condition_variable condition_;
+    boost::thread thread_;
+};
+
 }
 
 class Policy::Implementation
@@ -94,11 +161,31 @@ public:
            OpenerPtr subsequentOpener);
     void AddRestriction(RestrictionPtr restriction);
     std::streamsize Write(const std::string &toWrite);
+    char *Reserve(std::size_t size, std::size_t &available);
+    std::streamsize Commit(std::size_t size);
+    void OpenAhead( );
+    void SetRetention(RetentionPtr retention);
+    void SetCompressor(CompressorPtr compressor);
 private:
+    /**
+     * Opens the next file until the restrictions allow writing the given
+     * size into it
+     * @param result Receives the result of the writing, if it fails
+     * @return false, if the next file could not be opened
+     */
+    bool Reopen(std::streamsize toWrite, std::streamsize &result);
+    /// Tells the retention and the compressor about the new file
+    void Report(const boost::filesystem::path &closed);
+
     Path path_;
     RestrictionStore restrictions_;
     OpenerPtr subsequentOpener_;
     FilePtr file_;
+    boost::shared_ptr<Preparer> preparer_;
+    RetentionPtr retention_;
+    CompressorPtr compressor_;
+    /// The room returned by the latest Reserve
+    char *reserved_;
 };
 
 // Class implementations
@@ -109,23 +196,91 @@ Policy::Policy(Path path, InitialOpenerPtr initialOpener,
 {
 }
 
+Policy::Policy( )
+{
+}
+
+Policy::~Policy( )
+{
+}
+
 void Policy::AddRestriction(RestrictionPtr restriction)
 {
+    DoAddRestriction(restriction);
+}
+
+std::streamsize Policy::Write(const std::string &toWrite)
+{
+    return DoWrite(toWrite);
+}
+
+std::streamsize Policy::WriteWithLevel(const std::string &toWrite,
+                                       VerbosityLevel verbosity)
+{
+    return DoWriteWithLevel(toWrite, verbosity);
+}
+
+char *Policy::Reserve(std::size_t size, std::size_t &available)
+{
+    if (!implementation_)
+    {
+        available = 0;
+        return 0;
+    }
+
+    return implementation_->Reserve(size, available);
+}
+
+std::streamsize Policy::Commit(std::size_t size)
+{
+    assert(implementation_);
+    return implementation_->Commit(size);
+}
+
+void Policy::DoAddRestriction(RestrictionPtr restriction)
+{
+    assert(implementation_);
     implementation_->AddRestriction(restriction);
 }
 
+void Policy::OpenAhead( )
+{
+    assert(implementation_);
+    implementation_->OpenAhead( );
+}
+
+void Policy::SetRetention(RetentionPtr retention)
+{
+    assert(implementation_);
+    implementation_->SetRetention(retention);
+}
+
+void Policy::SetCompressor(CompressorPtr compressor)
+{
+    assert(implementation_);
+    implementation_->SetCompressor(compressor);
+}
+
 // Divide smaller
-std::streamsize Policy::Write(const std::string &toWrite)
+std::streamsize Policy::DoWrite(const std::string &toWrite)
 {
+    assert(implementation_);
     return implementation_->Write(toWrite);
 }
 
+std::streamsize Policy::DoWriteWithLevel(const std::string &toWrite,
+                                         VerbosityLevel)
+{
+    return DoWrite(toWrite);
+}
+
 Policy::Implementation::
 Implementation(Path path, InitialOpenerPtr initialOpener,
                OpenerPtr subsequentOpener) :
     path_(path),
     subsequentOpener_(subsequentOpener),
-    file_(initialOpener->Open(path_))
+    file_(initialOpener->Open(path_)),
+    reserved_(0)
 {
     path_.AppendRestrictions(restrictions_);
 }
@@ -135,11 +290,57 @@ void Policy::Implementation::AddRestriction(RestrictionPtr restriction)
     restrictions_.Add(restriction);
 }
 
-// Divide smaller
+void Policy::Implementation::OpenAhead( )
+{
+    // An opener that modifies the current file (like Resizer does) would
+    // modify it while it is still being written.
+    assert(dynamic_cast<InitialOpener *>(subsequentOpener_.get( )));
+
+    if (preparer_ || !file_)
+    {
+        return;
+    }
+
+    try
+    {
+        preparer_.reset(new Preparer(path_, subsequentOpener_));
+    }
+    catch (...)
+    {
+        // The files are opened by the writing thread as before
+    }
+}
+
+void Policy::Implementation::SetRetention(RetentionPtr retention)
+{
+    retention_ = retention;
+    if (retention_ && file_)
+    {
+        retention_->Opened(file_->Path( ));
+    }
+}
+
+void Policy::Implementation::SetCompressor(CompressorPtr compressor)
+{
+    compressor_ = compressor;
+}
+
+void Policy::Implementation::Report(const boost::filesystem::path &closed)
+{
+    if (retention_)
+    {
+        retention_->Opened(file_->Path( ));
+    }
+
+    // With the same path the file may be opened again, like Resizer does
+    if (compressor_ && !closed.empty( ) && closed != file_->Path( ))
+    {
+        compressor_->Closed(closed);
+    }
+}
+
 std::streamsize Policy::Implementation::Write(const std::string &toWrite)
 {
-    boost::filesystem::path originalPath(file_->Path( ));
-    int counter = 0;
     // On windows the possible line endings will have size of two ("\n\r").
     // Because of this the size may need to be adjusted so that the original
     // text size is returned.
@@ -147,21 +348,81 @@ std::streamsize Policy::Implementation::Write(const std::string &toWrite)
 
     // Is the file size counting the responsibility of this class? It is
     // only used by the policies which are based on file size.
-    while (restrictions_.IsRestricted(*file_, ADJUSTER.GetSize( )))
+    std::streamsize result = 0;
+    if (restrictions_.Charge(*file_, ADJUSTER.GetSize( )) &&
+        !Reopen(ADJUSTER.GetSize( ), result))
+    {
+        return result;
+    }
+
+    return AdjustSize(toWrite, file_->Write(toWrite));
+}
+
+char *Policy::Implementation::Reserve(std::size_t size,
+                                      std::size_t &available)
+{
+    reserved_ = file_->Reserve(size, available);
+    return reserved_;
+}
+
+std::streamsize Policy::Implementation::Commit(std::size_t size)
+{
+    assert(reserved_);
+
+    const std::streamsize SIZE = static_cast<std::streamsize>(size);
+    if (!size || !restrictions_.Charge(*file_, SIZE))
+    {
+        return file_->Commit(size);
+    }
+
+    // The room belongs to the buffer of the current file, so the text is
+    // taken out of it before the file is closed
+    std::string text;
+    try
+    {
+        text.assign(reserved_, size);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return -1;
+    }
+
+    reserved_ = 0;
+    std::streamsize result = 0;
+    if (!Reopen(SIZE, result))
+    {
+        return result;
+    }
+
+    return file_->Write(text);
+}
+
+// Divide smaller
+bool Policy::Implementation::Reopen(std::streamsize toWrite,
+                                    std::streamsize &result)
+{
+    boost::filesystem::path originalPath(file_->Path( ));
+    int counter = 0;
+
+    do
     {
         // The file needs to be explicitly destructed before opening the next
         // file. This is needed, because the File object owns an open stream
         // to the underlying file. If the new File object needs to access the
         // same file and modify it somehow (like Resizer does), this will fail
         // as there already exists an open stream.
+        const boost::filesystem::path CLOSED(file_->Path( ));
         file_.reset( );
-        file_ = subsequentOpener_->Open(path_);
+        file_ = preparer_ ? preparer_->Take( ) : subsequentOpener_->Open(path_);
         if (!file_)
         {
             // No memory
-            return -1;
+            result = -1;
+            return false;
         }
 
+        Report(CLOSED);
+
         // The loop brings the possibility of infinite loop if the Opener
         // object does not truly open the next file. If the Opener object is
         // supposed only to modify the file somehow (like Resizer does), this
@@ -176,11 +437,13 @@ std::streamsize Policy::Implementation::Write(const std::string &toWrite)
         if (counter++ != 0 && file_->Path( ) == originalPath)
         {
             assert("Infinite loop noticed in Policy::Write" && false);
-            return 0;
+            result = 0;
+            return false;
         }
     }
+    while (restrictions_.Charge(*file_, toWrite));
 
-    return AdjustSize(toWrite, file_->Write(toWrite));
+    return true;
 }
 
 // Local implementations
@@ -254,6 +517,161 @@ SizeAdjusterImpl<false>::Adjust(std::streamsize written) const
     return written;
 }
 
+const boost::posix_time::time_duration Preparer::INTERVAL =
+    boost::posix_time::milliseconds(100);
+
+Preparer::Preparer(Path &path, OpenerPtr opener) :
+    path_(path),
+    opener_(opener),
+    stopping_(false),
+    thread_(&Preparer::Run, this)
+{
+}
+
+Preparer::~Preparer( )
+{
+    {
+        Lock lock(mutex_);
+        stopping_ = true;
+    }
+
+    condition_.notify_one( );
+    thread_.join( );
+    Discard(next_);
+}
+
+FilePtr Preparer::Take( )
+{
+    FilePtr prepared;
+    boost::filesystem::path next;
+    {
+        Lock lock(mutex_);
+
+        // An outdated file is left for the background thread to remove. If
+        // the file is still being prepared, the next one is opened here.
+        if (!next_ || IsOutdated( ))
+        {
+            return Open( );
+        }
+
+        // The path is generated only now, so that its time parts are current
+        // and no Index is skipped while the prepared file can be used
+        try
+        {
+            next = path_.Generate( );
+        }
+        catch (...)
+        {
+            return Open( );
+        }
+
+        prepared.swap(next_);
+    }
+
+    condition_.notify_one( );
+
+    // A file that already exists is left for the opener, which may append
+    // to it. The error of a missing file is reported along with its type.
+    boost::system::error_code error;
+    if (next.parent_path( ) == prepared->Path( ).parent_path( ) &&
+        boost::filesystem::file_not_found ==
+            boost::filesystem::status(next, error).type( ) &&
+        opener_->Name(*prepared, path_, next))
+    {
+        return prepared;
+    }
+
+    Discard(prepared);
+
+    Lock lock(mutex_);
+    return Open( );
+}
+
+void Preparer::Run( )
+{
+    Lock lock(mutex_);
+
+    while (!stopping_)
+    {
+        if (next_ && IsOutdated( ))
+        {
+            FilePtr outdated;
+            outdated.swap(next_);
+            lock.unlock( );
+            Discard(outdated);
+            lock.lock( );
+        }
+
+        if (!next_)
+        {
+            Prepare(lock);
+        }
+
+        if (!stopping_)
+        {
+            condition_.timed_wait(lock, INTERVAL);
+        }
+    }
+}
+
+void Preparer::Prepare(Lock &lock)
+{
+    boost::filesystem::path folder;
+    try
+    {
+        // The restrictions are collected before generating, so that they
+        // apply if a boundary is crossed during the generation. They are not
+        // used until the file is ready.
+        validity_ = RestrictionStore( );
+        path_.AppendRestrictions(validity_);
+
+        // Only the folder is generated, the name is given by Take
+        folder = path_.GenerateFolder( );
+    }
+    catch (...)
+    {
+        // Nothing is prepared, the file is opened by the writing thread
+        return;
+    }
+
+    lock.unlock( );
+    FilePtr file(opener_->OpenTemporary(folder));
+    lock.lock( );
+    next_ = file;
+}
+
+FilePtr Preparer::Open( )
+{
+    // The opener is given the rules themselves, so that it can use them for
+    // selecting the file (like Appender does), and the manifest is recorded
+    // for them. The name is generated again.
+    return opener_->Open(path_);
+}
+
+bool Preparer::IsOutdated( )
+{
+    assert(next_);
+    return validity_.IsRestricted(*next_, 0);
+}
+
+void Preparer::Discard(FilePtr &file)
+{
+    if (!file)
+    {
+        return;
+    }
+
+    const boost::filesystem::path PATH(file->Path( ));
+    const bool EMPTY = 0 == file->WrittenSize( );
+    file.reset( );
+
+    if (EMPTY)
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(PATH, error);
+    }
+}
+
 }
 
 }
@@ -11,6 +11,7 @@
 
 #include "myrrh/log/policy/Resizer.hpp"
 #include "myrrh/log/policy/Path.hpp"
+#include "myrrh/file/Copy.hpp"
 #include "myrrh/file/Resizer.hpp"
 #include "myrrh/file/PositionScanner.hpp"
 
@@ -23,8 +24,14 @@
 
 #ifdef WIN32
 #pragma warning(pop)
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
+#include <fstream>
+
 namespace myrrh
 {
 
@@ -41,8 +48,28 @@ using namespace file;
 namespace
 {
 
+/**
+ * Resizes the file, if it exists, or creates the folders for it
+ * @return false, if the file could not be resized or the folders could not
+ *         be created
+ */
+bool Prepare(const boost::filesystem::path &path,
+             std::streamsize sizeLeftAfter);
+
 file::Resizer NewResizer(const boost::filesystem::path &path,
                          std::streamsize sizeLeftAfter);
+
+/**
+ * Drops the head of the file in place, so that the kept content is not
+ * copied. The head is dropped in whole filesystem blocks up to the start of
+ * the kept content, so the rest of the block before it is kept as well,
+ * beginning with the end of the line cut by the block boundary. Nothing is
+ * done, if the head is shorter than a block.
+ * @return false, if the head was not dropped
+ */
+bool Collapse(const boost::filesystem::path &path,
+              std::streamsize sizeLeftAfter);
+
 }
 
 // Class implementations
@@ -52,13 +79,44 @@ Resizer::Resizer(std::streamsize sizeLeftAfter) :
 {
 }
 
-// Divide smaller
 boost::filesystem::path Resizer::DoOpen(std::filebuf &file, Path& path)
 {
     const boost::filesystem::path PATH(path.Generate( ));
     assert(!PATH.empty( ));
 
-    if (boost::filesystem::exists(PATH))
+    if (Prepare(PATH, SIZE_LEFT_AFTER_))
+    {
+        using namespace std;
+        file.open(PATH.string( ).c_str( ), ios::out | ios::app | ios::ate);
+    }
+
+    return PATH;
+}
+
+bool Resizer::DoOpenDescriptor(int &descriptor, Path &path,
+                               boost::filesystem::path &opened)
+{
+    descriptor = NO_DESCRIPTOR;
+    opened = path.Generate( );
+    assert(!opened.empty( ));
+
+    if (Prepare(opened, SIZE_LEFT_AFTER_))
+    {
+        descriptor = OpenDescriptor(opened, false);
+    }
+
+    return true;
+}
+
+// Local implementations
+
+namespace
+{
+
+bool Prepare(const boost::filesystem::path &path,
+             std::streamsize sizeLeftAfter)
+{
+    if (boost::filesystem::exists(path))
     {
         // The myrrh::file::Resizer throws if the file does not exist. It is
         // not an error in this case. Normally myrrh::log::Resizer is used
@@ -68,38 +126,45 @@ boost::filesystem::path Resizer::DoOpen(std::filebuf &file, Path& path)
         // must be able to handle this kind of situation and just open a new
         // file. Also, if we were to throw here, the no-throw guarantee would
         // be broken.
-        file::Resizer resizer(NewResizer(PATH, SIZE_LEFT_AFTER_));
-        resizer( );
-    }
-    else
-    {
+        if (Collapse(path, sizeLeftAfter))
+        {
+            return true;
+        }
+
         try
         {
-            // The creation of the directory path may throw, we will silently
-            // ignore the possible exceptions.
-            if (PATH.has_parent_path( ))
-            {
-                // There is also a version with no-throw guarantee
-                boost::filesystem::create_directories(PATH.parent_path( ));
-            }
+            // If the copying fails, for instance because the disk is full,
+            // the original file is kept. It is not opened, so that it does
+            // not grow beyond the size any further.
+            file::Resizer resizer(NewResizer(path, sizeLeftAfter));
+            resizer( );
         }
-        catch (...)
+        catch (const Copy::Incomplete &)
         {
-            return PATH;
+            return false;
         }
+
+        return true;
     }
 
-    using namespace std;
-    file.open(PATH.string( ).c_str( ), ios::out | ios::app | ios::ate);
+    try
+    {
+        // The creation of the directory path may throw, we will silently
+        // ignore the possible exceptions.
+        if (path.has_parent_path( ))
+        {
+            // There is also a version with no-throw guarantee
+            boost::filesystem::create_directories(path.parent_path( ));
+        }
+    }
+    catch (...)
+    {
+        return false;
+    }
 
-    return PATH;
+    return true;
 }
 
-// Local implementations
-
-namespace
-{
-
 inline file::Resizer NewResizer(const boost::filesystem::path &path,
                                 std::streamsize sizeLeftAfter)
 {
@@ -108,6 +173,54 @@ inline file::Resizer NewResizer(const boost::filesystem::path &path,
     return file::Resizer(path, startScanner, endScanner);
 }
 
+bool Collapse(const boost::filesystem::path &path,
+              std::streamsize sizeLeftAfter)
+{
+#ifdef FALLOC_FL_COLLAPSE_RANGE
+    // The same start of the kept content as the copying resize would use
+    off_t start = 0;
+    try
+    {
+        std::ifstream stream(path.string( ).c_str( ), std::ios::binary);
+        start = static_cast<off_t>(ScanFromEnd(sizeLeftAfter).Scan(stream));
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    const int DESCRIPTOR = open(path.string( ).c_str( ), O_RDWR | O_CLOEXEC);
+    if (DESCRIPTOR < 0)
+    {
+        return false;
+    }
+
+    bool result = false;
+    struct stat status;
+    if (!fstat(DESCRIPTOR, &status) && status.st_blksize > 0)
+    {
+        // Rounded down, so that nothing is written into the kept content
+        const off_t BLOCK = static_cast<off_t>(status.st_blksize);
+        const off_t LENGTH = start / BLOCK * BLOCK;
+
+        if (start >= status.st_size)
+        {
+            result = !ftruncate(DESCRIPTOR, 0);
+        }
+        else if (LENGTH)
+        {
+            result =
+                !fallocate(DESCRIPTOR, FALLOC_FL_COLLAPSE_RANGE, 0, LENGTH);
+        }
+    }
+
+    close(DESCRIPTOR);
+    return result;
+#else
+    return false;
+#endif
+}
+
 }
 
 }
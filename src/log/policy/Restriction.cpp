@@ -13,6 +13,12 @@
 #include "myrrh/log/policy/File.hpp"
 
 #include "boost/date_time/gregorian/gregorian_types.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/date_time/c_local_time_adjustor.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
 
 namespace myrrh
 {
@@ -23,14 +29,50 @@ namespace log
 namespace policy
 {
 
+// Local declarations
+
+namespace
+{
+
+/**
+ * The longest time the change of date is trusted to the deadline. If the
+ * offset of the local time changes, the new offset is noticed within this
+ * time.
+ */
+const boost::posix_time::minutes MAX_DATE_DEADLINE(1);
+
+/**
+ * Returns the first boundary of the interval of given minutes after the given
+ * time. The boundaries are aligned to the local midnight.
+ */
+util::CoarseClock::Ticks NextBoundary(unsigned int interval,
+                                      util::CoarseClock::Ticks after);
+
+}
+
+// Limits class implementations
+
+Limits::Limits( ) :
+    budget(std::numeric_limits<std::size_t>::max( )),
+    deadline(util::CoarseClock::NEVER)
+{
+}
+
 // Restriction class implementations
 
 Restriction::~Restriction( )
 {
 }
 
+bool Restriction::GetLimits(const File &, Limits &) const
+{
+    return false;
+}
+
 // SizeRestriction class implementations
 
+const std::size_t SizeRestriction::SHARED_BUDGET;
+
 SizeRestriction::SizeRestriction(std::size_t maxSize) :
     MAX_SIZE_(maxSize)
 {
@@ -41,11 +83,100 @@ bool SizeRestriction::IsRestricted(const File &file, std::size_t toWrite) const
     return (file.WrittenSize( ) + toWrite > MAX_SIZE_);
 }
 
+bool SizeRestriction::GetLimits(const File &file, Limits &limits) const
+{
+    const std::size_t WRITTEN = static_cast<std::size_t>(file.WrittenSize( ));
+    std::size_t left = WRITTEN < MAX_SIZE_ ? MAX_SIZE_ - WRITTEN : 0;
+    if (file.IsShared( ))
+    {
+        left = std::min(left, SHARED_BUDGET);
+    }
+
+    limits.budget = std::min(limits.budget, left);
+    return true;
+}
+
+// IntervalRestriction class implementations
+
+const unsigned int IntervalRestriction::MINUTES_IN_DAY;
+
+IntervalRestriction::IntervalRestriction(unsigned int minutes) :
+    MINUTES_(std::max(1u, std::min(minutes, MINUTES_IN_DAY)))
+{
+    assert(minutes > 0 && minutes <= MINUTES_IN_DAY);
+}
+
+bool IntervalRestriction::IsRestricted(const File &file, std::size_t) const
+{
+    // Only checked once the deadline has passed or the limits are not known,
+    // so the boundary is not calculated for each line
+    return util::CoarseClock::Now( ) >=
+           NextBoundary(MINUTES_, file.OpenTime( ));
+}
+
+bool IntervalRestriction::GetLimits(const File &file, Limits &limits) const
+{
+    limits.deadline = std::min(limits.deadline,
+                               NextBoundary(MINUTES_, file.OpenTime( )));
+    return true;
+}
+
+// DateCreator class implementations
+
 boost::gregorian::date DateCreator::NewDate( )
 {
     return boost::gregorian::day_clock::local_day( );
 }
 
+bool GetDateLimits(const DateCreator *, const boost::gregorian::date &date,
+                   Limits &limits)
+{
+    using namespace boost::posix_time;
+
+    const ptime UNIVERSAL(second_clock::universal_time( ));
+    const ptime LOCAL(second_clock::local_time( ));
+    if (LOCAL.date( ) != date)
+    {
+        // The date has already changed, it must be checked right away
+        limits.deadline = util::CoarseClock::FromTime(UNIVERSAL);
+        return true;
+    }
+
+    const ptime MIDNIGHT(LOCAL.date( ) + boost::gregorian::days(1));
+    const time_duration LEFT(std::min<time_duration>(MIDNIGHT - LOCAL,
+                                                     MAX_DATE_DEADLINE));
+    limits.deadline = std::min(limits.deadline,
+                               util::CoarseClock::FromTime(UNIVERSAL + LEFT));
+    return true;
+}
+
+// Local implementations
+
+namespace
+{
+
+util::CoarseClock::Ticks NextBoundary(unsigned int interval,
+                                      util::CoarseClock::Ticks after)
+{
+    using namespace boost::posix_time;
+    typedef boost::date_time::c_local_adjustor<ptime> LocalAdjustor;
+
+    const ptime UNIVERSAL(ptime(boost::gregorian::date(1970, 1, 1)) +
+                          milliseconds(after));
+    const ptime LOCAL(LocalAdjustor::utc_to_local(UNIVERSAL));
+
+    const long INTERVAL = static_cast<long>(interval);
+    const long PASSED = LOCAL.time_of_day( ).total_seconds( ) / 60;
+    const long END = PASSED - PASSED % INTERVAL + INTERVAL;
+    const ptime BOUNDARY(LOCAL.date( ), minutes(END));
+    const ptime MIDNIGHT(LOCAL.date( ) + boost::gregorian::days(1));
+
+    return util::CoarseClock::FromTime(UNIVERSAL +
+                                       (std::min(BOUNDARY, MIDNIGHT) - LOCAL));
+}
+
+}
+
 }
 
 }
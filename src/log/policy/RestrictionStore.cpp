@@ -13,6 +13,7 @@
 #include "myrrh/log/policy/RestrictionStore.hpp"
 #include "myrrh/log/policy/Restriction.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 namespace myrrh
@@ -24,33 +25,126 @@ namespace log
 namespace policy
 {
 
+// Local declarations
+
+namespace
+{
+
+bool IsAnyRestricted(const std::vector<RestrictionPtr> &restrictions,
+                     const File &file, std::size_t toWrite);
+
+}
+
 // Class implementations
 
+RestrictionStore::RestrictionStore( ) :
+    armed_(false),
+    budget_(0),
+    deadline_(0)
+{
+}
+
 void RestrictionStore::Add(RestrictionPtr restriction)
 {
     assert(restriction);
     restrictions_.push_back(restriction);
+    Disarm( );
 }
 
 bool RestrictionStore::IsRestricted(const File &file,
                                     std::size_t toWrite) const
 {
-    for (auto i = restrictions_.begin( ); restrictions_.end( ) != i; ++i)
+    return IsAnyRestricted(restrictions_, file, toWrite);
+}
+
+bool RestrictionStore::Charge(const File &file, std::size_t toWrite)
+{
+    if (armed_ && toWrite <= budget_ &&
+        util::CoarseClock::Now( ) < deadline_)
     {
-        if ((*i)->IsRestricted(file, toWrite))
+        if (IsAnyRestricted(unlimited_, file, toWrite))
         {
+            Disarm( );
             return true;
         }
     }
+    else
+    {
+        if (IsRestricted(file, toWrite))
+        {
+            Disarm( );
+            return true;
+        }
 
+        Arm(file);
+    }
+
+    budget_ -= std::min(budget_, toWrite);
     return false;
 }
 
+void RestrictionStore::Disarm( )
+{
+    armed_ = false;
+}
+
+void RestrictionStore::Arm(const File &file)
+{
+    Limits limits;
+    unlimited_.clear( );
+    for (auto i = restrictions_.begin( ); restrictions_.end( ) != i; ++i)
+    {
+        if (!(*i)->GetLimits(file, limits))
+        {
+            unlimited_.push_back(*i);
+        }
+    }
+
+    budget_ = limits.budget;
+    deadline_ = limits.deadline;
+    armed_ = true;
+}
+
+bool RestrictionStore::GetLimits(const File &file, Limits &limits) const
+{
+    bool result = true;
+    for (auto i = restrictions_.begin( ); restrictions_.end( ) != i; ++i)
+    {
+        if (!(*i)->GetLimits(file, limits))
+        {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
 std::size_t RestrictionStore::Count( ) const
 {
     return restrictions_.size( );
 }
 
+// Local implementations
+
+namespace
+{
+
+bool IsAnyRestricted(const std::vector<RestrictionPtr> &restrictions,
+                     const File &file, std::size_t toWrite)
+{
+    for (auto i = restrictions.begin( ); restrictions.end( ) != i; ++i)
+    {
+        if ((*i)->IsRestricted(file, toWrite))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
+
 }
 
 }
@@ -0,0 +1,587 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of class
+ * myrrh::log::policy::Retention.
+ */
+
+#include "myrrh/log/policy/Retention.hpp"
+#include "myrrh/log/policy/Compressor.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathEntity.hpp"
+#include "myrrh/file/ScanFolder.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/filesystem/path.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <ctime>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * A log file known by Retention
+ */
+struct LogFile
+{
+    /// The combined sort keys of the entities of the path
+    Path::Entity::Key key;
+    boost::filesystem::path path;
+    boost::uintmax_t size;
+    std::time_t time;
+};
+
+/**
+ * Orders the files by their keys, the path separates the equal ones
+ */
+bool operator<(const LogFile &left, const LogFile &right);
+
+typedef std::set<LogFile> LogFiles;
+typedef std::vector<boost::filesystem::path> PathStore;
+
+/**
+ * Returns the folder from which the scanning starts
+ */
+boost::filesystem::path StartFolder(const Path &path);
+
+/**
+ * Reads the size and the modification time of the file
+ */
+void ReadStatus(LogFile &file);
+
+}
+
+/**
+ * The opened files are collected by Opened( ) and handled by the background
+ * thread, which owns the known files. The limits are copied for each round,
+ * so that the setters only need to take the lock.
+ */
+class Retention::Implementation
+{
+public:
+
+    explicit Implementation(const Path &path);
+    ~Implementation( );
+
+    void SetMaxCount(std::size_t count);
+    void SetMaxSize(boost::uintmax_t size);
+    void SetMaxAge(const boost::posix_time::time_duration &age);
+    void Opened(const boost::filesystem::path &file);
+    void SetRecycling(bool recycling);
+    bool Recycle(const boost::filesystem::path &file);
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    /// The limits of the files
+    struct Limits
+    {
+        std::size_t count;
+        boost::uintmax_t size;
+        boost::posix_time::time_duration age;
+        bool recycling;
+    };
+
+    /// The loop of the background thread
+    void Run( );
+    /// Adds the opened files, scanning the folders on the first time
+    void Update(const PathStore &opened);
+    /// Finds all the existing files of the path
+    void Scan( );
+    /// Adds or refreshes a known file
+    void Add(const boost::filesystem::path &file);
+    /// Removes the oldest files as long as the limits are exceeded
+    void Enforce(const Limits &limits);
+    /// Tells if the oldest file exceeds the limits
+    bool IsExceeded(const Limits &limits, const LogFile &oldest) const;
+    /// Removes the file and the folders left empty
+    void Remove(const LogFile &file, bool recycling);
+    /// Keeps the file as the spare under a hidden name, unless there
+    /// already is one
+    bool Spare(const boost::filesystem::path &file);
+
+    /// The interval of checking the ages without any opened files
+    static const boost::posix_time::time_duration INTERVAL;
+
+    const Path PATH_;
+    LogFiles files_;
+    boost::uintmax_t totalSize_;
+    boost::filesystem::path current_;
+    bool scanned_;
+
+    Limits limits_;
+    PathStore opened_;
+    /// The file kept for recycling, if any
+    boost::filesystem::path spare_;
+    bool stopping_;
+    boost::mutex mutex_;
+    boost::condition_variable condition_;
+    boost::thread thread_;
+};
+
+// Class implementations
+
+const boost::posix_time::time_duration
+Retention::Implementation::INTERVAL(boost::posix_time::minutes(1));
+
+Retention::Retention(const Path &path) :
+    implementation_(new Implementation(path))
+{
+}
+
+Retention::~Retention( )
+{
+}
+
+void Retention::SetMaxCount(std::size_t count)
+{
+    implementation_->SetMaxCount(count);
+}
+
+void Retention::SetMaxSize(boost::uintmax_t size)
+{
+    implementation_->SetMaxSize(size);
+}
+
+void Retention::SetMaxAge(const boost::posix_time::time_duration &age)
+{
+    implementation_->SetMaxAge(age);
+}
+
+void Retention::Opened(const boost::filesystem::path &file)
+{
+    implementation_->Opened(file);
+}
+
+void Retention::SetRecycling(bool recycling)
+{
+    implementation_->SetRecycling(recycling);
+}
+
+bool Retention::Recycle(const boost::filesystem::path &file)
+{
+    return implementation_->Recycle(file);
+}
+
+Retention::Implementation::Implementation(const Path &path) :
+    PATH_(path),
+    totalSize_(0),
+    scanned_(false),
+    stopping_(false)
+{
+    limits_.count = 0;
+    limits_.size = 0;
+    limits_.recycling = false;
+
+    // Started last, when the members are ready for the thread
+    thread_ = boost::thread(&Implementation::Run, this);
+}
+
+Retention::Implementation::~Implementation( )
+{
+    {
+        Lock lock(mutex_);
+        stopping_ = true;
+    }
+
+    condition_.notify_one( );
+    thread_.join( );
+
+    // Nobody recycles the spare anymore
+    if (!spare_.empty( ))
+    {
+        boost::system::error_code error;
+        boost::filesystem::remove(spare_, error);
+    }
+}
+
+void Retention::Implementation::SetMaxCount(std::size_t count)
+{
+    Lock lock(mutex_);
+    limits_.count = count;
+}
+
+void Retention::Implementation::SetMaxSize(boost::uintmax_t size)
+{
+    Lock lock(mutex_);
+    limits_.size = size;
+}
+
+void Retention::Implementation::
+SetMaxAge(const boost::posix_time::time_duration &age)
+{
+    Lock lock(mutex_);
+    limits_.age = age;
+}
+
+void Retention::Implementation::Opened(const boost::filesystem::path &file)
+{
+    try
+    {
+        Lock lock(mutex_);
+        opened_.push_back(file);
+    }
+    catch (...)
+    {
+        // Not known before the next file is opened
+        return;
+    }
+
+    condition_.notify_one( );
+}
+
+void Retention::Implementation::SetRecycling(bool recycling)
+{
+    Lock lock(mutex_);
+    limits_.recycling = recycling;
+}
+
+bool Retention::Implementation::Recycle(const boost::filesystem::path &file)
+{
+    boost::filesystem::path spare;
+    try
+    {
+        Lock lock(mutex_);
+        spare.swap(spare_);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    if (spare.empty( ))
+    {
+        return false;
+    }
+
+    boost::system::error_code error;
+    boost::filesystem::rename(spare, file, error);
+    return !error;
+}
+
+void Retention::Implementation::Run( )
+{
+    Lock lock(mutex_);
+    while (!stopping_)
+    {
+        if (opened_.empty( ))
+        {
+            condition_.timed_wait(lock, INTERVAL);
+            if (stopping_)
+            {
+                break;
+            }
+        }
+
+        PathStore opened;
+        opened.swap(opened_);
+        const Limits LIMITS(limits_);
+        lock.unlock( );
+
+        try
+        {
+            Update(opened);
+            Enforce(LIMITS);
+        }
+        catch (...)
+        {
+            // Tried again on the next round
+        }
+
+        lock.lock( );
+    }
+}
+
+void Retention::Implementation::Update(const PathStore &opened)
+{
+    if (!scanned_)
+    {
+        if (opened.empty( ))
+        {
+            // The scanning waits for the policy to open its first file
+            return;
+        }
+
+        Scan( );
+        scanned_ = true;
+    }
+
+    // The previous file has been written to after its size was read
+    if (!current_.empty( ))
+    {
+        Add(current_);
+    }
+
+    for (PathStore::const_iterator i = opened.begin( );
+         opened.end( ) != i;
+         ++i)
+    {
+        Add(*i);
+        current_ = *i;
+    }
+}
+
+void Retention::Implementation::Scan( )
+{
+    struct Found
+    {
+        boost::filesystem::path path;
+        Path::Entity::Key key;
+    };
+
+    // The paths start with the parent path as given, so that they equal the
+    // ones reported by the policy
+    Found start;
+    start.path = PATH_.ParentPath( );
+    if (!boost::filesystem::exists(StartFolder(PATH_)))
+    {
+        return;
+    }
+
+    std::vector<Found> level(1, start);
+    for (Path::EntityIterator i(PATH_.BeginEntity( ));
+         PATH_.EndEntity( ) != i && !level.empty( );
+         ++i)
+    {
+        const bool IS_LAST = i + 1 == PATH_.EndEntity( );
+        std::vector<Found> next;
+
+        for (std::vector<Found>::const_iterator j = level.begin( );
+             level.end( ) != j;
+             ++j)
+        {
+            // The keys are collected in the order of the accepted entries
+            std::vector<Path::Entity::Key> keys;
+            const boost::filesystem::path FOLDER(
+                j->path.empty( ) ? StartFolder(PATH_) : j->path);
+            const file::EntryStore ENTRIES(file::ScanFolder(FOLDER,
+                [&](const std::string &name) -> bool
+                {
+                    Path::Entity::Key key;
+                    if (!Compressor::Parse(*i, name, key))
+                    {
+                        return false;
+                    }
+
+                    keys.push_back(key);
+                    return true;
+                }));
+
+            for (std::size_t k = 0; k < ENTRIES.size( ); ++k)
+            {
+                // Only the last entity names files, the others folders
+                if (ENTRIES[k].isDirectory == IS_LAST)
+                {
+                    continue;
+                }
+
+                const boost::filesystem::path PATH(
+                    j->path / ENTRIES[k].path.leaf( ));
+                if (IS_LAST)
+                {
+                    LogFile file;
+                    file.key = j->key + keys[k];
+                    file.path = PATH;
+                    ReadStatus(file);
+                    totalSize_ += file.size;
+                    files_.insert(file);
+                    continue;
+                }
+
+                Found found;
+                found.path = PATH;
+                found.key = j->key + keys[k];
+                next.push_back(found);
+            }
+        }
+
+        level.swap(next);
+    }
+}
+
+void Retention::Implementation::Add(const boost::filesystem::path &file)
+{
+    LogFile added;
+    added.path = file;
+    if (!PATH_.Parse(file, added.key))
+    {
+        return;
+    }
+
+    ReadStatus(added);
+
+    const LogFiles::iterator OLD(files_.find(added));
+    if (files_.end( ) != OLD)
+    {
+        totalSize_ -= OLD->size;
+        files_.erase(OLD);
+    }
+
+    totalSize_ += added.size;
+    files_.insert(added);
+}
+
+void Retention::Implementation::Enforce(const Limits &limits)
+{
+    while (!files_.empty( ))
+    {
+        const LogFiles::iterator OLDEST(files_.begin( ));
+        if (OLDEST->path == current_ || !IsExceeded(limits, *OLDEST))
+        {
+            return;
+        }
+
+        Remove(*OLDEST, limits.recycling);
+        totalSize_ -= OLDEST->size;
+        files_.erase(OLDEST);
+    }
+}
+
+bool Retention::Implementation::IsExceeded(const Limits &limits,
+                                           const LogFile &oldest) const
+{
+    if (limits.count && files_.size( ) > limits.count)
+    {
+        return true;
+    }
+
+    if (limits.size && totalSize_ > limits.size)
+    {
+        return true;
+    }
+
+    using boost::posix_time::seconds;
+    if (limits.age.is_special( ) || limits.age <= seconds(0))
+    {
+        return false;
+    }
+
+    const std::time_t NOW = std::time(0);
+    return oldest.time + limits.age.total_seconds( ) < NOW;
+}
+
+void Retention::Implementation::Remove(const LogFile &file, bool recycling)
+{
+    boost::system::error_code error;
+    if (!recycling || !Spare(file.path))
+    {
+        // The file may have been compressed after it was added
+        boost::filesystem::remove(file.path, error);
+        boost::filesystem::remove(file.path.string( ) + Compressor::SUFFIX,
+                                  error);
+    }
+
+    // The folders of the other entities are removed, once they are empty
+    boost::filesystem::path folder(file.path.branch_path( ));
+    while (!folder.empty( ) && folder != PATH_.ParentPath( ))
+    {
+        if (!boost::filesystem::is_empty(folder, error) || error ||
+            !boost::filesystem::remove(folder, error))
+        {
+            return;
+        }
+
+        folder = folder.branch_path( );
+    }
+}
+
+bool Retention::Implementation::Spare(const boost::filesystem::path &file)
+{
+    // A compressed file cannot be written over
+    boost::system::error_code error;
+    if (!boost::filesystem::is_regular_file(file, error))
+    {
+        return false;
+    }
+
+    Lock lock(mutex_);
+    if (!spare_.empty( ))
+    {
+        return false;
+    }
+
+    // The spare is moved out of the folders of the entities, so that they
+    // can be removed, and given a name that the entities do not match. Thus
+    // it is not taken for a log file, for instance by Appender on restart.
+    const boost::filesystem::path SPARE(
+        PATH_.ParentPath( ) / ("." + file.leaf( ).string( ) + ".spare"));
+    boost::filesystem::rename(file, SPARE, error);
+    if (error)
+    {
+        return false;
+    }
+
+    spare_ = SPARE;
+    return true;
+}
+
+// Local implementations
+
+namespace
+{
+
+bool operator<(const LogFile &left, const LogFile &right)
+{
+    if (left.key != right.key)
+    {
+        return left.key < right.key;
+    }
+
+    return left.path < right.path;
+}
+
+boost::filesystem::path StartFolder(const Path &path)
+{
+    const boost::filesystem::path PARENT_PATH(path.ParentPath( ));
+    if (PARENT_PATH.empty( ))
+    {
+        return ".";
+    }
+
+    return PARENT_PATH;
+}
+
+void ReadStatus(LogFile &file)
+{
+    boost::system::error_code error;
+    file.size = boost::filesystem::file_size(file.path, error);
+    if (error)
+    {
+        file.size = 0;
+    }
+
+    file.time = boost::filesystem::last_write_time(file.path, error);
+    if (error)
+    {
+        file.time = std::time(0);
+    }
+}
+
+}
+
+}
+
+}
+
+}
@@ -0,0 +1,99 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains implementation of class myrrh::log::policy::Router
+ */
+
+#include "myrrh/log/policy/Router.hpp"
+
+#include <cassert>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Class implementations
+
+Router::Router( )
+{
+}
+
+Router::~Router( )
+{
+}
+
+void Router::AddRoute(PolicyPtr destination, VerbosityLevel leastSevere,
+                      VerbosityLevel mostSevere)
+{
+    assert(destination && mostSevere <= leastSevere);
+
+    Route route;
+    route.destination = destination;
+    route.leastSevere = leastSevere;
+    route.mostSevere = mostSevere;
+    routes_.push_back(route);
+}
+
+void Router::DoAddRestriction(RestrictionPtr restriction)
+{
+    for (Routes::const_iterator i = routes_.begin( ); routes_.end( ) != i;
+         ++i)
+    {
+        i->destination->AddRestriction(restriction);
+    }
+}
+
+std::streamsize Router::DoWrite(const std::string &toWrite)
+{
+    std::streamsize result = static_cast<std::streamsize>(toWrite.size( ));
+    for (Routes::const_iterator i = routes_.begin( ); routes_.end( ) != i;
+         ++i)
+    {
+        const std::streamsize WRITTEN = i->destination->Write(toWrite);
+        if (WRITTEN < result)
+        {
+            result = WRITTEN;
+        }
+    }
+
+    return result;
+}
+
+std::streamsize Router::DoWriteWithLevel(const std::string &toWrite,
+                                         VerbosityLevel verbosity)
+{
+    std::streamsize result = static_cast<std::streamsize>(toWrite.size( ));
+    for (Routes::const_iterator i = routes_.begin( ); routes_.end( ) != i;
+         ++i)
+    {
+        if (verbosity < i->mostSevere || verbosity > i->leastSevere)
+        {
+            continue;
+        }
+
+        // The level is passed on, so that the destination can be a Router
+        // or an AsyncPolicy wrapping one
+        const std::streamsize WRITTEN =
+            i->destination->WriteWithLevel(toWrite, verbosity);
+        if (WRITTEN < result)
+        {
+            result = WRITTEN;
+        }
+    }
+
+    return result;
+}
+
+}
+
+}
+
+}
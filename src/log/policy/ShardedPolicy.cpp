@@ -0,0 +1,321 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains implementation of class
+ * myrrh::log::policy::ShardedPolicy
+ */
+
+#include "myrrh/log/policy/ShardedPolicy.hpp"
+
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/tss.hpp"
+#include "boost/weak_ptr.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace myrrh
+{
+
+namespace log
+{
+
+namespace policy
+{
+
+// Local declarations
+
+namespace
+{
+
+/**
+ * One shard, which is only ever used by the thread that created it
+ */
+struct Shard
+{
+    explicit Shard(PolicyPtr newPolicy);
+
+    PolicyPtr policy;
+    /// Reused for prefixing the lines, so that no allocation is needed once
+    /// the longest line has been written
+    std::string line;
+};
+
+typedef boost::shared_ptr<Shard> ShardPtr;
+
+/**
+ * The shards of one ShardedPolicy object by the identifiers of their threads.
+ * The threads share the registry, so that they can release their shards when
+ * they exit.
+ */
+struct Registry
+{
+    typedef std::map<unsigned long long, ShardPtr> ShardStore;
+
+    boost::mutex mutex;
+    ShardStore shards;
+};
+
+typedef boost::shared_ptr<Registry> RegistryPtr;
+typedef boost::weak_ptr<Registry> RegistryWeakPtr;
+
+/**
+ * Remembers the shard the current thread used last, and releases the shards
+ * of the thread once it exits. The owner is identified with an unique number
+ * instead of an address, so that a new ShardedPolicy object cannot be
+ * mistaken for an already destroyed one. The thread is identified the same
+ * way, as a new thread can get the id of an exited one.
+ */
+struct LastUsed
+{
+    LastUsed( );
+    ~LastUsed( );
+
+    /// Remembers the registry, from which the shard of the thread is
+    /// released once the thread exits
+    void Register(const RegistryPtr &registry);
+
+    const unsigned long long THREAD;
+    unsigned long long owner;
+    Shard *shard;
+    std::vector<RegistryWeakPtr> registries;
+};
+
+LastUsed &GetLastUsed( );
+void AppendSequence(std::string &line);
+
+/// The count of digits in the sequence number
+const std::size_t SEQUENCE_DIGITS = ShardedPolicy::PREFIX_SIZE - 1;
+
+/// The sequence numbers are shared by all shards of the process
+std::atomic<unsigned long long> sequence(0);
+
+/// Used to give each ShardedPolicy object an unique identifier
+std::atomic<unsigned long long> owners(0);
+
+/// Used to give each writing thread an unique identifier
+std::atomic<unsigned long long> threads(0);
+
+}
+
+class ShardedPolicy::Shards
+{
+public:
+    explicit Shards(Factory factory);
+    Shard *Current( );
+private:
+    Shard *Find(LastUsed &lastUsed);
+
+    Factory factory_;
+    const unsigned long long ID_;
+    const RegistryPtr REGISTRY_;
+};
+
+// Class implementations
+
+const std::size_t ShardedPolicy::PREFIX_SIZE;
+
+ShardedPolicy::ShardedPolicy(Factory factory) :
+    shards_(new Shards(factory))
+{
+}
+
+ShardedPolicy::~ShardedPolicy( )
+{
+}
+
+void ShardedPolicy::DoAddRestriction(RestrictionPtr)
+{
+    assert(false && "Add restrictions to the shards in the factory function");
+}
+
+std::streamsize ShardedPolicy::DoWrite(const std::string &toWrite)
+{
+    try
+    {
+        Shard *shard = shards_->Current( );
+        if (!shard || !shard->policy)
+        {
+            return -1;
+        }
+
+        shard->line.clear( );
+        AppendSequence(shard->line);
+        shard->line += toWrite;
+
+        const std::streamsize WRITTEN = shard->policy->Write(shard->line);
+        if (WRITTEN < static_cast<std::streamsize>(PREFIX_SIZE))
+        {
+            return WRITTEN < 0 ? WRITTEN : 0;
+        }
+
+        return WRITTEN - static_cast<std::streamsize>(PREFIX_SIZE);
+    }
+    catch (...)
+    {
+        // Either there was no memory or the factory failed. The no-throw
+        // guarantee forbids passing the exception on.
+    }
+
+    return -1;
+}
+
+ShardedPolicy::Shards::Shards(Factory factory) :
+    factory_(factory),
+    ID_(++owners),
+    REGISTRY_(new Registry)
+{
+}
+
+Shard *ShardedPolicy::Shards::Current( )
+{
+    LastUsed &lastUsed = GetLastUsed( );
+    if (lastUsed.owner != ID_)
+    {
+        lastUsed.shard = Find(lastUsed);
+        lastUsed.owner = ID_;
+    }
+
+    return lastUsed.shard;
+}
+
+Shard *ShardedPolicy::Shards::Find(LastUsed &lastUsed)
+{
+    {
+        boost::mutex::scoped_lock lock(REGISTRY_->mutex);
+        Registry::ShardStore::const_iterator match(
+            REGISTRY_->shards.find(lastUsed.THREAD));
+        if (REGISTRY_->shards.end( ) != match)
+        {
+            return match->second.get( );
+        }
+    }
+
+    // The factory is called without locking, so that a slow opening of a
+    // file does not block the other threads.
+    ShardPtr shard(new Shard(factory_( )));
+    lastUsed.Register(REGISTRY_);
+
+    boost::mutex::scoped_lock lock(REGISTRY_->mutex);
+    REGISTRY_->shards[lastUsed.THREAD] = shard;
+
+    return shard.get( );
+}
+
+std::function<std::size_t (const std::string &)> SequenceKey( )
+{
+    return [](const std::string &line) -> std::size_t
+    {
+        if (line.size( ) < ShardedPolicy::PREFIX_SIZE ||
+            line[SEQUENCE_DIGITS] != ' ')
+        {
+            return 0;
+        }
+
+        for (std::size_t i = 0; i < SEQUENCE_DIGITS; ++i)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(line[i])))
+            {
+                return 0;
+            }
+        }
+
+        return SEQUENCE_DIGITS;
+    };
+}
+
+// Local implementations
+
+namespace
+{
+
+Shard::Shard(PolicyPtr newPolicy) :
+    policy(newPolicy)
+{
+}
+
+LastUsed::LastUsed( ) :
+    THREAD(++threads),
+    owner(0),
+    shard(0)
+{
+}
+
+LastUsed::~LastUsed( )
+{
+    for (std::vector<RegistryWeakPtr>::const_iterator i = registries.begin( );
+         registries.end( ) != i; ++i)
+    {
+        const RegistryPtr REGISTRY(i->lock( ));
+        if (!REGISTRY)
+        {
+            // The ShardedPolicy object has already been destroyed
+            continue;
+        }
+
+        // The shard is closed only after unlocking, so that the other
+        // threads are not blocked by the flushing
+        ShardPtr released;
+        boost::mutex::scoped_lock lock(REGISTRY->mutex);
+        Registry::ShardStore::iterator match(REGISTRY->shards.find(THREAD));
+        if (REGISTRY->shards.end( ) != match)
+        {
+            released.swap(match->second);
+            REGISTRY->shards.erase(match);
+        }
+        lock.unlock( );
+    }
+}
+
+void LastUsed::Register(const RegistryPtr &registry)
+{
+    // The registries of destroyed ShardedPolicy objects are forgotten, so
+    // that a long lived thread does not collect them
+    std::vector<RegistryWeakPtr>::iterator last(
+        std::remove_if(registries.begin( ), registries.end( ),
+                       [](const RegistryWeakPtr &r) { return r.expired( ); }));
+    registries.erase(last, registries.end( ));
+    registries.push_back(registry);
+}
+
+LastUsed &GetLastUsed( )
+{
+    // Intentionally never deleted, so that the object stays usable during
+    // the destruction of static objects. The object of each thread is
+    // deleted when the thread exits, which releases the shards of the
+    // thread.
+    static boost::thread_specific_ptr<LastUsed> *lastUsed =
+        new boost::thread_specific_ptr<LastUsed>;
+
+    if (!lastUsed->get( ))
+    {
+        lastUsed->reset(new LastUsed);
+    }
+
+    return *lastUsed->get( );
+}
+
+void AppendSequence(std::string &line)
+{
+    // The numbers are padded with zeroes, so that they can be compared as
+    // strings.
+    char buffer[ShardedPolicy::PREFIX_SIZE + 1];
+    std::sprintf(buffer, "%020llu ", sequence++);
+    line.append(buffer, ShardedPolicy::PREFIX_SIZE);
+}
+
+}
+
+}
+
+}
+
+}
@@ -13,6 +13,9 @@
 #include "myrrh/log/policy/Stream.hpp"
 #include "myrrh/log/policy/Policy.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace myrrh
 {
 
@@ -22,17 +25,102 @@ namespace log
 namespace policy
 {
 
+// Local declarations
+
+namespace
+{
+
+/**
+ * The smallest room reserved for a text. A larger room is used, if the
+ * buffer has one.
+ */
+const std::size_t MIN_ROOM = 256;
+
+}
+
 // Buffer class implementations
 
 Buffer::Buffer(PolicyPtr policy) :
-    policy_(policy)
+    policy_(policy),
+    verbosity_(TRACE),
+    hasVerbosity_(false)
+{
+}
+
+void Buffer::SetVerbosity(VerbosityLevel verbosity)
+{
+    verbosity_ = verbosity;
+    hasVerbosity_ = true;
+}
+
+Buffer::int_type Buffer::overflow(int_type character)
+{
+    if (traits_type::eq_int_type(character, traits_type::eof( )))
+    {
+        return traits_type::not_eof(character);
+    }
+
+    if (!pbase( ) && Reserve(1))
+    {
+        *pptr( ) = traits_type::to_char_type(character);
+        pbump(1);
+        return character;
+    }
+
+    // The room is full
+    Abandon( );
+    return BufferedStream::overflow(character);
+}
+
+std::streamsize Buffer::xsputn(const char *text, std::streamsize length)
+{
+    if (!length)
+    {
+        // Nothing to reserve a room for
+        return 0;
+    }
+
+    const std::size_t LENGTH = static_cast<std::size_t>(length);
+    if ((pbase( ) || Reserve(LENGTH)) &&
+        static_cast<std::size_t>(epptr( ) - pptr( )) >= LENGTH)
+    {
+        std::memcpy(pptr( ), text, LENGTH);
+        pbump(static_cast<int>(length));
+        return length;
+    }
+
+    Abandon( );
+    return BufferedStream::xsputn(text, length);
+}
+
+int Buffer::sync( )
 {
+    if (!pbase( ))
+    {
+        const int RESULT = BufferedStream::sync( );
+        hasVerbosity_ = false;
+        return RESULT;
+    }
+
+    // Only Policy itself offers rooms, and it ignores the level anyway
+    const std::size_t SIZE = static_cast<std::size_t>(pptr( ) - pbase( ));
+    setp(0, 0);
+    hasVerbosity_ = false;
+    // Committing also an empty room releases it
+    if (static_cast<std::streamsize>(SIZE) == policy_->Commit(SIZE))
+    {
+        return 0;
+    }
+
+    return -1;
 }
 
 int Buffer::SyncImpl( )
 {
     const std::string& BUFFER = GetBuffer( );
-    if (BUFFER.size( ) == static_cast<std::size_t>(policy_->Write(BUFFER)))
+    const std::streamsize WRITTEN = hasVerbosity_ ?
+        policy_->WriteWithLevel(BUFFER, verbosity_) : policy_->Write(BUFFER);
+    if (BUFFER.size( ) == static_cast<std::size_t>(WRITTEN))
     {
         return 0;
     }
@@ -40,6 +128,38 @@ int Buffer::SyncImpl( )
     return -1;
 }
 
+bool Buffer::Reserve(std::size_t size)
+{
+    if (!GetBuffer( ).empty( ))
+    {
+        // The text has to stay in order
+        return false;
+    }
+
+    std::size_t available = 0;
+    char *room = policy_->Reserve(std::max(size, MIN_ROOM), available);
+    if (!room)
+    {
+        return false;
+    }
+
+    setp(room, room + available);
+    return true;
+}
+
+void Buffer::Abandon( )
+{
+    if (!pbase( ))
+    {
+        return;
+    }
+
+    BufferedStream::xsputn(pbase( ), pptr( ) - pbase( ));
+    setp(0, 0);
+    // The text was copied, so the room is released without committing it
+    policy_->Commit(0);
+}
+
 // Stream class implementations
 
 Stream::Stream(PolicyPtr policy) :
@@ -49,6 +169,11 @@ Stream::Stream(PolicyPtr policy) :
     rdbuf(&buffer_);
 }
 
+void Stream::SetVerbosity(VerbosityLevel verbosity)
+{
+    buffer_.SetVerbosity(verbosity);
+}
+
 }
 }
 }
@@ -0,0 +1,254 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for AsyncPolicy
+ */
+
+#include "myrrh/log/policy/AsyncPolicy.hpp"
+#include "myrrh/log/policy/Creator.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/bind.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/test/auto_unit_test.hpp"
+#include "boost/thread/condition_variable.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/thread.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace myrrh::log::policy;
+
+// Local helper declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("asyncTestFiles");
+
+PolicyPtr NewFilePolicy( );
+boost::filesystem::path IndexedFile(int index);
+std::string GetFileContent(const boost::filesystem::path &path);
+
+/**
+ * Collects the written texts, but only once it has been opened. Until then
+ * the writing thread waits.
+ */
+class GatePolicy : public Policy
+{
+public:
+
+    GatePolicy( );
+    /// Waits until the writing thread waits for the gate
+    void WaitForWriter( );
+    void Open( );
+    std::vector<std::string> GetTexts( ) const;
+    std::size_t GetRestrictionCount( ) const;
+
+private:
+
+    typedef boost::unique_lock<boost::mutex> Lock;
+
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    bool isOpen_;
+    bool isWaiting_;
+    std::vector<std::string> texts_;
+    std::size_t restrictions_;
+    mutable boost::mutex mutex_;
+    boost::condition_variable opened_;
+    boost::condition_variable waiting_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(FlushWritesQueuedTexts)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    AsyncPolicy policy(NewFilePolicy( ));
+
+    BOOST_CHECK_EQUAL(6, policy.Write("first\n"));
+    BOOST_CHECK_EQUAL(7, policy.Write("second\n"));
+    policy.Flush( );
+
+    BOOST_CHECK_EQUAL("first\nsecond\n", GetFileContent(IndexedFile(1)));
+    BOOST_CHECK_EQUAL(0u, policy.GetFailureCount( ));
+}
+
+BOOST_AUTO_TEST_CASE(DestructorWritesQueuedTexts)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        AsyncPolicy policy(NewFilePolicy( ));
+        for (int i = 0; i < 100; ++i)
+        {
+            BOOST_CHECK_EQUAL(5, policy.Write("text\n"));
+        }
+    }
+
+    BOOST_CHECK_EQUAL(500u, boost::filesystem::file_size(IndexedFile(1)));
+}
+
+BOOST_AUTO_TEST_CASE(RestrictionsAreAddedInOrder)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        AsyncPolicy policy(NewFilePolicy( ));
+        BOOST_CHECK_EQUAL(8, policy.Write("0123456\n"));
+        policy.AddRestriction(RestrictionPtr(new SizeRestriction(10)));
+        BOOST_CHECK_EQUAL(8, policy.Write("abcdefg\n"));
+    }
+
+    BOOST_CHECK_EQUAL("0123456\n", GetFileContent(IndexedFile(1)));
+    BOOST_CHECK_EQUAL("abcdefg\n", GetFileContent(IndexedFile(2)));
+}
+
+BOOST_AUTO_TEST_CASE(FullQueueBlocksWriters)
+{
+    boost::shared_ptr<GatePolicy> gate(new GatePolicy);
+    AsyncPolicy policy(gate, 10);
+
+    // The thread takes the first text and waits for the gate
+    BOOST_CHECK_EQUAL(8, policy.Write("0123456\n"));
+    gate->WaitForWriter( );
+    BOOST_CHECK_EQUAL(8, policy.Write("abcdefg\n"));
+
+    boost::thread writer(boost::bind(&AsyncPolicy::Write,
+                                     &policy, std::string("last\n")));
+    BOOST_CHECK(!writer.timed_join(boost::posix_time::milliseconds(100)));
+
+    gate->Open( );
+    writer.join( );
+    policy.Flush( );
+
+    BOOST_REQUIRE_EQUAL(3u, gate->GetTexts( ).size( ));
+    BOOST_CHECK_EQUAL("last\n", gate->GetTexts( )[2]);
+    BOOST_CHECK_EQUAL(0u, policy.GetDropCount( ));
+}
+
+BOOST_AUTO_TEST_CASE(FullQueueDropsTexts)
+{
+    boost::shared_ptr<GatePolicy> gate(new GatePolicy);
+    AsyncPolicy policy(gate, 10, AsyncPolicy::DROP);
+
+    BOOST_CHECK_EQUAL(8, policy.Write("0123456\n"));
+    gate->WaitForWriter( );
+    BOOST_CHECK_EQUAL(8, policy.Write("abcdefg\n"));
+    BOOST_CHECK_EQUAL(0, policy.Write("dropped\n"));
+    policy.AddRestriction(RestrictionPtr(new SizeRestriction(10)));
+
+    gate->Open( );
+    policy.Flush( );
+
+    BOOST_CHECK_EQUAL(1u, policy.GetDropCount( ));
+    BOOST_REQUIRE_EQUAL(2u, gate->GetTexts( ).size( ));
+    BOOST_CHECK_EQUAL("abcdefg\n", gate->GetTexts( )[1]);
+    BOOST_CHECK_EQUAL(1u, gate->GetRestrictionCount( ));
+}
+
+// Local helper implementations
+
+namespace
+{
+
+PolicyPtr NewFilePolicy( )
+{
+    Path path(FOLDER);
+    path += "log" + Index( ) + ".txt";
+    InitialOpenerPtr opener(new Creator);
+    return PolicyPtr(new Policy(path, opener, opener));
+}
+
+boost::filesystem::path IndexedFile(int index)
+{
+    std::ostringstream name;
+    name << "log" << index << ".txt";
+    return FOLDER / name.str( );
+}
+
+std::string GetFileContent(const boost::filesystem::path &path)
+{
+    std::ifstream file(path.string( ).c_str( ));
+    BOOST_REQUIRE(file.is_open( ));
+
+    std::ostringstream stream;
+    stream << file.rdbuf( );
+    return stream.str( );
+}
+
+GatePolicy::GatePolicy( ) :
+    isOpen_(false),
+    isWaiting_(false),
+    restrictions_(0)
+{
+}
+
+void GatePolicy::WaitForWriter( )
+{
+    Lock lock(mutex_);
+    while (!isWaiting_)
+    {
+        waiting_.wait(lock);
+    }
+}
+
+void GatePolicy::Open( )
+{
+    {
+        Lock lock(mutex_);
+        isOpen_ = true;
+    }
+
+    opened_.notify_all( );
+}
+
+std::vector<std::string> GatePolicy::GetTexts( ) const
+{
+    Lock lock(mutex_);
+    return texts_;
+}
+
+std::size_t GatePolicy::GetRestrictionCount( ) const
+{
+    Lock lock(mutex_);
+    return restrictions_;
+}
+
+void GatePolicy::DoAddRestriction(RestrictionPtr)
+{
+    Lock lock(mutex_);
+    ++restrictions_;
+}
+
+std::streamsize GatePolicy::DoWrite(const std::string &toWrite)
+{
+    Lock lock(mutex_);
+    isWaiting_ = true;
+    waiting_.notify_all( );
+    while (!isOpen_)
+    {
+        opened_.wait(lock);
+    }
+
+    texts_.push_back(toWrite);
+    return static_cast<std::streamsize>(toWrite.size( ));
+}
+
+}
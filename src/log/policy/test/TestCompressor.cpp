@@ -0,0 +1,224 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for Compressor
+ */
+
+#include "myrrh/log/policy/Compressor.hpp"
+#include "myrrh/log/policy/Appender.hpp"
+#include "myrrh/log/policy/Creator.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/log/policy/Policy.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/thread/thread.hpp"
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <fstream>
+#include <sstream>
+
+#include <zlib.h>
+
+using namespace myrrh::log::policy;
+
+// Local declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("compressorTest");
+
+Path IndexedPath( );
+boost::filesystem::path IndexedFile(int index);
+boost::filesystem::path Compressed(const boost::filesystem::path &path);
+void CreateFile(const boost::filesystem::path &path,
+                const std::string &content);
+
+/**
+ * Reads the content of a compressed file
+ */
+std::string Decompress(const boost::filesystem::path &path);
+
+/**
+ * Waits for the background threads to compress the file
+ * @return false, if the file still exists after a while
+ */
+bool WaitForCompression(const boost::filesystem::path &path);
+
+}
+
+BOOST_AUTO_TEST_CASE(CompressReplacesFile)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    const std::string CONTENT(100000, 'x');
+    CreateFile(IndexedFile(1), CONTENT);
+
+    BOOST_CHECK(Compressor::Compress(IndexedFile(1)));
+    BOOST_CHECK(!boost::filesystem::exists(IndexedFile(1)));
+    BOOST_CHECK(boost::filesystem::file_size(Compressed(IndexedFile(1))) <
+                CONTENT.size( ));
+    BOOST_CHECK(CONTENT == Decompress(Compressed(IndexedFile(1))));
+}
+
+BOOST_AUTO_TEST_CASE(CompressingMissingFileFails)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    boost::filesystem::create_directories(FOLDER);
+
+    BOOST_CHECK(!Compressor::Compress(IndexedFile(1)));
+    BOOST_CHECK(!boost::filesystem::exists(Compressed(IndexedFile(1))));
+}
+
+BOOST_AUTO_TEST_CASE(CompressedNamesAreParsed)
+{
+    Path path(IndexedPath( ));
+    const Path::Entity &ENTITY = *(path.EndEntity( ) - 1);
+
+    Path::Entity::Key plain;
+    Path::Entity::Key compressed;
+    BOOST_CHECK(Compressor::Parse(ENTITY, "log12.txt", plain));
+    BOOST_CHECK(Compressor::Parse(ENTITY, "log12.txt.gz", compressed));
+    BOOST_CHECK(plain == compressed);
+    BOOST_CHECK(!Compressor::Parse(ENTITY, "log12.gz", compressed));
+    BOOST_CHECK(Compressor::IsCompressed("log12.txt.gz"));
+    BOOST_CHECK(!Compressor::IsCompressed(".gz"));
+}
+
+BOOST_AUTO_TEST_CASE(DestructorCompressesReportedFiles)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    for (int i = 1; i <= 3; ++i)
+    {
+        CreateFile(IndexedFile(i), "content");
+    }
+
+    {
+        Compressor compressor(2);
+        for (int i = 1; i <= 3; ++i)
+        {
+            compressor.Closed(IndexedFile(i));
+        }
+    }
+
+    for (int i = 1; i <= 3; ++i)
+    {
+        BOOST_CHECK(!boost::filesystem::exists(IndexedFile(i)));
+        BOOST_CHECK_EQUAL("content", Decompress(Compressed(IndexedFile(i))));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PolicyReportsClosedFiles)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    Policy policy(IndexedPath( ), InitialOpenerPtr(new Appender),
+                  OpenerPtr(new Creator));
+    policy.AddRestriction(RestrictionPtr(new SizeRestriction(10)));
+    policy.SetCompressor(CompressorPtr(new Compressor));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        BOOST_CHECK_EQUAL(8, policy.Write("01234567"));
+    }
+
+    BOOST_CHECK(WaitForCompression(IndexedFile(1)));
+    BOOST_CHECK(WaitForCompression(IndexedFile(2)));
+    BOOST_CHECK_EQUAL("01234567", Decompress(Compressed(IndexedFile(2))));
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(3)));
+    BOOST_CHECK(!boost::filesystem::exists(Compressed(IndexedFile(3))));
+}
+
+BOOST_AUTO_TEST_CASE(AppenderSkipsCompressedFile)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    CreateFile(IndexedFile(1), "first");
+    BOOST_REQUIRE(Compressor::Compress(IndexedFile(1)));
+
+    Policy policy(IndexedPath( ), InitialOpenerPtr(new Appender),
+                  OpenerPtr(new Creator));
+    BOOST_CHECK_EQUAL(6, policy.Write("second"));
+
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(2)));
+    BOOST_CHECK_EQUAL("first", Decompress(Compressed(IndexedFile(1))));
+}
+
+// Local implementations
+
+namespace
+{
+
+Path IndexedPath( )
+{
+    Path path(FOLDER);
+    path += "log" + Index( ) + ".txt";
+    return path;
+}
+
+boost::filesystem::path IndexedFile(int index)
+{
+    std::ostringstream name;
+    name << "log" << index << ".txt";
+    return FOLDER / name.str( );
+}
+
+boost::filesystem::path Compressed(const boost::filesystem::path &path)
+{
+    return path.string( ) + Compressor::SUFFIX;
+}
+
+void CreateFile(const boost::filesystem::path &path,
+                const std::string &content)
+{
+    boost::filesystem::create_directories(path.branch_path( ));
+    std::ofstream file(path.string( ).c_str( ));
+    BOOST_REQUIRE(file.is_open( ));
+    file << content;
+}
+
+std::string Decompress(const boost::filesystem::path &path)
+{
+    gzFile file = gzopen(path.string( ).c_str( ), "rb");
+    BOOST_REQUIRE(file);
+
+    std::string result;
+    char buffer[4096];
+    int read = 0;
+    while ((read = gzread(file, buffer, sizeof(buffer))) > 0)
+    {
+        result.append(buffer, static_cast<std::size_t>(read));
+    }
+
+    gzclose(file);
+    return result;
+}
+
+bool WaitForCompression(const boost::filesystem::path &path)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        if (!boost::filesystem::exists(path) &&
+            boost::filesystem::exists(Compressed(path)))
+        {
+            return true;
+        }
+
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    return false;
+}
+
+}
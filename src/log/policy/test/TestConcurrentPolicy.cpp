@@ -0,0 +1,257 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for ConcurrentPolicy
+ */
+
+#include "myrrh/log/policy/ConcurrentPolicy.hpp"
+#include "myrrh/log/policy/Creator.hpp"
+#include "myrrh/log/policy/File.hpp"
+#include "myrrh/log/policy/Opener.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/bind.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/test/auto_unit_test.hpp"
+#include "boost/thread/thread.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <vector>
+
+using namespace myrrh::log::policy;
+
+// Local helper declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("concurrentTestFiles");
+const std::size_t THREADS = 4;
+const std::size_t LINES = 500;
+
+/// The lines are of equal length, so the files can be checked for holes
+const std::size_t LINE_SIZE = 16;
+
+ConcurrentPolicy *NewPolicy(std::size_t maxSize = 0,
+                            InitialOpenerPtr opener = InitialOpenerPtr( ));
+
+void WriteLines(Policy &policy, std::size_t thread);
+void WriteFromThreads(Policy &policy);
+
+/**
+ * Reads all the lines of the files of the policy
+ * @param maxSize The maximum size each file is checked against
+ */
+std::vector<std::string> ReadLines(std::size_t maxSize);
+
+/**
+ * Opens the files as streams instead of raw descriptors
+ */
+class StreamCreator : public InitialOpener
+{
+private:
+    virtual boost::filesystem::path DoOpen(std::filebuf &file, Path &path);
+};
+
+/**
+ * Restricts the size of the files without publishing any limits
+ */
+class UnlimitedSizeRestriction : public Restriction
+{
+public:
+    explicit UnlimitedSizeRestriction(std::size_t maxSize);
+    virtual bool IsRestricted(const File &file, std::size_t toWrite) const;
+private:
+    const std::size_t MAX_SIZE_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(ThreadsWriteWholeLines)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        boost::shared_ptr<ConcurrentPolicy> policy(NewPolicy( ));
+        WriteFromThreads(*policy);
+    }
+
+    const std::vector<std::string> LINES_READ(ReadLines(0));
+    BOOST_CHECK_EQUAL(THREADS * LINES, LINES_READ.size( ));
+
+    const std::set<std::string> UNIQUE(LINES_READ.begin( ),
+                                       LINES_READ.end( ));
+    BOOST_CHECK_EQUAL(LINES_READ.size( ), UNIQUE.size( ));
+}
+
+BOOST_AUTO_TEST_CASE(RotationKeepsLinesWhole)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    const std::size_t MAX_SIZE = 50 * LINE_SIZE + 5;
+    {
+        boost::shared_ptr<ConcurrentPolicy> policy(NewPolicy(MAX_SIZE));
+        WriteFromThreads(*policy);
+    }
+
+    const std::vector<std::string> LINES_READ(ReadLines(MAX_SIZE));
+    BOOST_CHECK_EQUAL(THREADS * LINES, LINES_READ.size( ));
+
+    const std::set<std::string> UNIQUE(LINES_READ.begin( ),
+                                       LINES_READ.end( ));
+    BOOST_CHECK_EQUAL(LINES_READ.size( ), UNIQUE.size( ));
+}
+
+BOOST_AUTO_TEST_CASE(LongTextIsWrittenAlone)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        boost::shared_ptr<ConcurrentPolicy> policy(NewPolicy(10));
+        BOOST_CHECK_EQUAL(20, policy->Write("01234567890123456789"));
+        BOOST_CHECK_EQUAL(5, policy->Write("abcd\n"));
+    }
+
+    BOOST_CHECK_EQUAL(20u, boost::filesystem::file_size(FOLDER / "log1.txt"));
+    BOOST_CHECK_EQUAL(5u, boost::filesystem::file_size(FOLDER / "log2.txt"));
+}
+
+BOOST_AUTO_TEST_CASE(StreamsAreWrittenUnderLock)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    const std::size_t MAX_SIZE = 50 * LINE_SIZE + 5;
+    {
+        boost::shared_ptr<ConcurrentPolicy>
+            policy(NewPolicy(MAX_SIZE, InitialOpenerPtr(new StreamCreator)));
+        WriteFromThreads(*policy);
+    }
+
+    BOOST_CHECK_EQUAL(THREADS * LINES, ReadLines(MAX_SIZE).size( ));
+}
+
+BOOST_AUTO_TEST_CASE(UnlimitedRestrictionIsAddedWhileWriting)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    const std::string LINE(std::string(LINE_SIZE - 1, 'x') + "\n");
+    {
+        boost::shared_ptr<ConcurrentPolicy> policy(NewPolicy( ));
+        BOOST_CHECK_EQUAL(16, policy->Write(LINE));
+        policy->AddRestriction(
+            RestrictionPtr(new UnlimitedSizeRestriction(2 * LINE_SIZE)));
+        for (int i = 0; i < 3; ++i)
+        {
+            BOOST_CHECK_EQUAL(16, policy->Write(LINE));
+        }
+    }
+
+    BOOST_CHECK_EQUAL(16u, boost::filesystem::file_size(FOLDER / "log1.txt"));
+    BOOST_CHECK_EQUAL(32u, boost::filesystem::file_size(FOLDER / "log2.txt"));
+    BOOST_CHECK_EQUAL(16u, boost::filesystem::file_size(FOLDER / "log3.txt"));
+}
+
+// Local helper implementations
+
+namespace
+{
+
+ConcurrentPolicy *NewPolicy(std::size_t maxSize, InitialOpenerPtr opener)
+{
+    Path path(FOLDER);
+    path += "log" + Index( ) + ".txt";
+    if (!opener)
+    {
+        opener.reset(new Creator);
+    }
+
+    ConcurrentPolicy *policy = new ConcurrentPolicy(path, opener, opener);
+    if (maxSize)
+    {
+        policy->AddRestriction(RestrictionPtr(new SizeRestriction(maxSize)));
+    }
+
+    return policy;
+}
+
+void WriteLines(Policy &policy, std::size_t thread)
+{
+    for (std::size_t i = 0; i < LINES; ++i)
+    {
+        char line[LINE_SIZE + 1];
+        std::sprintf(line, "%02u %012u\n", static_cast<unsigned>(thread),
+                     static_cast<unsigned>(i));
+        BOOST_CHECK_EQUAL(static_cast<std::streamsize>(LINE_SIZE),
+                          policy.Write(line));
+    }
+}
+
+void WriteFromThreads(Policy &policy)
+{
+    boost::thread_group threads;
+    for (std::size_t i = 0; i < THREADS; ++i)
+    {
+        threads.create_thread(boost::bind(WriteLines, boost::ref(policy), i));
+    }
+
+    threads.join_all( );
+}
+
+std::vector<std::string> ReadLines(std::size_t maxSize)
+{
+    std::vector<std::string> result;
+    using boost::filesystem::directory_iterator;
+    for (directory_iterator i(FOLDER); directory_iterator( ) != i; ++i)
+    {
+        const boost::uintmax_t SIZE = boost::filesystem::file_size(*i);
+        BOOST_CHECK_EQUAL(0u, SIZE % LINE_SIZE);
+        if (maxSize)
+        {
+            BOOST_CHECK(SIZE <= maxSize);
+        }
+
+        std::ifstream file(i->path( ).string( ).c_str( ));
+        std::string line;
+        while (std::getline(file, line))
+        {
+            BOOST_CHECK_EQUAL(LINE_SIZE - 1, line.size( ));
+            result.push_back(line);
+        }
+    }
+
+    return result;
+}
+
+UnlimitedSizeRestriction::UnlimitedSizeRestriction(std::size_t maxSize) :
+    MAX_SIZE_(maxSize)
+{
+}
+
+bool UnlimitedSizeRestriction::IsRestricted(const File &file,
+                                            std::size_t toWrite) const
+{
+    return static_cast<std::size_t>(file.WrittenSize( )) + toWrite >
+        MAX_SIZE_;
+}
+
+boost::filesystem::path StreamCreator::DoOpen(std::filebuf &file,
+                                              Path &path)
+{
+    const boost::filesystem::path PATH(path.Generate( ));
+    boost::filesystem::create_directories(PATH.branch_path( ));
+    file.open(PATH.string( ).c_str( ), std::ios::out | std::ios::trunc);
+    return PATH;
+}
+
+}
@@ -0,0 +1,162 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for Manifest
+ */
+
+#include "myrrh/log/policy/Manifest.hpp"
+#include "myrrh/log/policy/Appender.hpp"
+#include "myrrh/log/policy/Creator.hpp"
+#include "myrrh/log/policy/File.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <fstream>
+
+using namespace myrrh::log::policy;
+
+// Local declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("manifestTest");
+const boost::filesystem::path MANIFEST(FOLDER / "manifest");
+
+Path GetPath(const std::string &name = "log");
+boost::filesystem::path IndexedFile(int index);
+void CreateFile(const boost::filesystem::path &path);
+
+}
+
+BOOST_AUTO_TEST_CASE(NoManifest)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    Manifest manifest(MANIFEST);
+    boost::filesystem::path latest;
+    BOOST_CHECK(!manifest.Lookup(GetPath( ), latest));
+}
+
+BOOST_AUTO_TEST_CASE(OpenedFileIsRecorded)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    ManifestPtr manifest(new Manifest(MANIFEST));
+    Creator creator;
+    creator.SetManifest(manifest);
+
+    Path path(GetPath( ));
+    creator.Open(path);
+    creator.Open(path);
+
+    boost::filesystem::path latest;
+    BOOST_CHECK(manifest->Lookup(path, latest));
+    BOOST_CHECK(IndexedFile(2) == latest);
+}
+
+BOOST_AUTO_TEST_CASE(ModifiedFolderMakesManifestStale)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    ManifestPtr manifest(new Manifest(MANIFEST));
+    Creator creator;
+    creator.SetManifest(manifest);
+
+    Path path(GetPath( ));
+    creator.Open(path);
+    CreateFile(IndexedFile(5));
+
+    boost::filesystem::path latest;
+    BOOST_CHECK(!manifest->Lookup(path, latest));
+}
+
+BOOST_AUTO_TEST_CASE(DifferentRulesAreNotLookedUp)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    ManifestPtr manifest(new Manifest(MANIFEST));
+    Creator creator;
+    creator.SetManifest(manifest);
+    creator.Open(GetPath( ));
+
+    boost::filesystem::path latest;
+    BOOST_CHECK(!manifest->Lookup(GetPath("other"), latest));
+}
+
+BOOST_AUTO_TEST_CASE(EarlierFileRemovesManifest)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    ManifestPtr manifest(new Manifest(MANIFEST));
+    Creator creator;
+    creator.SetManifest(manifest);
+
+    Path path(GetPath( ));
+    creator.Open(path);
+    creator.Open(path);
+    creator.Open(GetPath( ));
+
+    boost::filesystem::path latest;
+    BOOST_CHECK(!manifest->Lookup(path, latest));
+    BOOST_CHECK(!boost::filesystem::exists(MANIFEST));
+}
+
+BOOST_AUTO_TEST_CASE(AppenderOpensRecordedFile)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    CreateFile(IndexedFile(2));
+
+    ManifestPtr manifest(new Manifest(MANIFEST));
+    Creator creator;
+    creator.SetManifest(manifest);
+    creator.Open(GetPath( ));
+
+    // The scanning would choose the second file
+    Appender appender;
+    appender.SetManifest(manifest);
+    FilePtr file(appender.Open(GetPath( )));
+    BOOST_CHECK(IndexedFile(1) == file->Path( ));
+
+    appender.SetManifest(ManifestPtr( ));
+    file = appender.Open(GetPath( ));
+    BOOST_CHECK(IndexedFile(2) == file->Path( ));
+}
+
+// Local implementations
+
+namespace
+{
+
+Path GetPath(const std::string &name)
+{
+    Path path(FOLDER);
+    path += name + Index( ) + ".txt";
+    return path;
+}
+
+boost::filesystem::path IndexedFile(int index)
+{
+    std::ostringstream name;
+    name << "log" << index << ".txt";
+    return FOLDER / name.str( );
+}
+
+void CreateFile(const boost::filesystem::path &path)
+{
+    boost::filesystem::create_directories(path.branch_path( ));
+    std::ofstream file(path.string( ).c_str( ));
+    BOOST_REQUIRE(file.is_open( ));
+}
+
+}
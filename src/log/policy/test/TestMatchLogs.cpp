@@ -0,0 +1,161 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for MatchLogs
+ */
+
+#include "myrrh/log/policy/MatchLogs.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#define DISABLE_COPY_CONSTRUCTOR_COULD_NOT_BE_GENERATED
+#define DISABLE_ASSIGNMENT_OPERATOR_COULD_NOT_BE_GENERATED
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/filesystem/fstream.hpp"
+#include "boost/filesystem/operations.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+using namespace myrrh::log::policy;
+
+// Local helper declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("matchLogsTestFiles");
+
+void CreateFile(const boost::filesystem::path &path);
+
+boost::filesystem::path CreateFolder( );
+
+class TestCase
+{
+public:
+    TestCase( );
+private:
+    myrrh::file::Eraser eraser_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(FolderDoesNotExist)
+{
+    Path path(FOLDER);
+    path += "worker" + ProcessId(ProcessId::ANY) + ".log";
+    BOOST_CHECK(MatchLogs(path).empty( ));
+}
+
+BOOST_AUTO_TEST_CASE(AllProcessesAreMatched)
+{
+    TestCase testCase;
+    CreateFile(FOLDER / "worker12.log");
+    CreateFile(FOLDER / "worker3.log");
+    CreateFile(FOLDER / "worker.log");
+    CreateFile(FOLDER / "other1.log");
+
+    Path path(FOLDER);
+    path += "worker" + ProcessId(ProcessId::ANY) + ".log";
+
+    myrrh::file::PathStore expected;
+    expected.push_back(FOLDER / "worker12.log");
+    expected.push_back(FOLDER / "worker3.log");
+
+    const myrrh::file::PathStore RESULT(MatchLogs(path));
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin( ), expected.end( ),
+                                  RESULT.begin( ), RESULT.end( ));
+}
+
+BOOST_AUTO_TEST_CASE(CurrentProcessIsMatched)
+{
+    TestCase testCase;
+    ProcessId pid;
+    CreateFile(FOLDER / ("worker" + pid.Generate( ) + ".log"));
+    CreateFile(FOLDER / "worker0.log");
+
+    Path path(FOLDER);
+    path += "worker" + pid + ".log";
+
+    const myrrh::file::PathStore RESULT(MatchLogs(path));
+    BOOST_REQUIRE_EQUAL(1u, RESULT.size( ));
+    BOOST_CHECK(FOLDER / ("worker" + pid.Generate( ) + ".log") == RESULT[0]);
+}
+
+BOOST_AUTO_TEST_CASE(FilesInSeveralFolders)
+{
+    TestCase testCase;
+    boost::filesystem::create_directory(FOLDER / "1");
+    boost::filesystem::create_directory(FOLDER / "2");
+    CreateFile(FOLDER / "1" / "file.log");
+    CreateFile(FOLDER / "2" / "file.log");
+    CreateFile(FOLDER / "3");
+    boost::filesystem::create_directory(FOLDER / "2" / "file.log.d");
+
+    Path path(FOLDER);
+    path += ProcessId(ProcessId::ANY) + "/file.log";
+
+    myrrh::file::PathStore expected;
+    expected.push_back(FOLDER / "1" / "file.log");
+    expected.push_back(FOLDER / "2" / "file.log");
+
+    const myrrh::file::PathStore RESULT(MatchLogs(path));
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin( ), expected.end( ),
+                                  RESULT.begin( ), RESULT.end( ));
+}
+
+BOOST_AUTO_TEST_CASE(FoldersScannedInParallel)
+{
+    TestCase testCase;
+    myrrh::file::PathStore expected;
+    for (int i = 1; i <= 20; ++i)
+    {
+        const std::string FOLDER_NAME(boost::lexical_cast<std::string>(i));
+        boost::filesystem::create_directory(FOLDER / FOLDER_NAME);
+        CreateFile(FOLDER / FOLDER_NAME / "file.log");
+        expected.push_back(FOLDER / FOLDER_NAME / "file.log");
+    }
+
+    std::sort(expected.begin( ), expected.end( ));
+
+    Path path(FOLDER);
+    path += ProcessId(ProcessId::ANY) + "/file.log";
+
+    const myrrh::file::PathStore RESULT(MatchLogs(path, 4));
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin( ), expected.end( ),
+                                  RESULT.begin( ), RESULT.end( ));
+}
+
+// Local helper implementations
+
+namespace
+{
+
+void CreateFile(const boost::filesystem::path &path)
+{
+    boost::filesystem::ofstream file(path);
+    file << "text\n";
+}
+
+boost::filesystem::path CreateFolder( )
+{
+    boost::filesystem::create_directory(FOLDER);
+    return FOLDER;
+}
+
+TestCase::TestCase( ) :
+    eraser_(CreateFolder( ))
+{
+}
+
+}
@@ -9,6 +9,8 @@
 #include "myrrh/log/policy/PathPart.hpp"
 #include "myrrh/log/policy/Path.hpp"
 #include "myrrh/log/policy/File.hpp"
+#include "myrrh/log/policy/Policy.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
 #include "myrrh/file/Eraser.hpp"
 
 #define DISABLE_TYPE_CONVERSION_LOSS_OF_DATA
@@ -20,6 +22,8 @@
 #include "boost/test/auto_unit_test.hpp"
 #include "boost/filesystem/operations.hpp"
 #include "boost/filesystem/convenience.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/thread/thread.hpp"
 
 #ifdef WIN32
 #pragma warning(pop)
@@ -29,6 +33,7 @@
 #pragma warning(disable: 4511)
 #pragma warning(disable: 4512)
 
+#include <algorithm>
 #include <iostream>
 
 using namespace myrrh::log::policy;
@@ -298,6 +303,69 @@ BOOST_AUTO_TEST_CASE(ResizingWhenFileExistsAndMaxExceeded)
                       GetFileContent("tmp.log"));
 }
 
+BOOST_AUTO_TEST_CASE(ResizingLargeFile)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+    std::string original;
+    for (int i = 0; i < 20000; ++i)
+    {
+        original += "Line number " + boost::lexical_cast<std::string>(i) +
+                    "\n";
+    }
+
+    CreateFile("tmp.log", original);
+
+    const std::streamsize SIZE_LEFT = 100000;
+    Resizer opener(SIZE_LEFT);
+    FilePtr file(opener.Open(GetPath("tmp.log")));
+
+    // If the head was dropped in place, less than a block more is kept,
+    // starting with the end of the line cut by the block boundary
+    const std::string KEPT(GetFileContent("tmp.log"));
+    BOOST_CHECK_EQUAL(static_cast<std::streamsize>(KEPT.size( )),
+                      file->WrittenSize( ));
+    BOOST_REQUIRE(KEPT.size( ) < original.size( ));
+    BOOST_CHECK(SIZE_LEFT - 8192 < static_cast<std::streamsize>(KEPT.size( )));
+    BOOST_CHECK(static_cast<std::streamsize>(KEPT.size( )) < SIZE_LEFT + 8192);
+    BOOST_CHECK(original.substr(original.size( ) - KEPT.size( )) == KEPT);
+}
+
+BOOST_AUTO_TEST_CASE(BufferedWritingThroughAppender)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+    CreateFile("tmp.log", ORIGINAL_CONTENT);
+
+    Appender opener;
+    opener.SetBufferSize(32);
+    {
+        FilePtr file(opener.Open(GetPath("tmp.log")));
+        BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+        BOOST_CHECK_EQUAL(StringSize(ORIGINAL_CONTENT + NEW_CONTENT),
+                          file->WrittenSize( ));
+        BOOST_CHECK_EQUAL(ORIGINAL_CONTENT, GetFileContent("tmp.log"));
+    }
+
+    BOOST_CHECK_EQUAL(ORIGINAL_CONTENT + NEW_CONTENT,
+                      GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(BufferWrittenWhenFull)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Creator opener;
+    opener.SetBufferSize(16);
+    FilePtr file(opener.Open(GetPath("tmp.log")));
+
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+    BOOST_CHECK(GetFileContent("tmp.log").empty( ));
+
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+    BOOST_CHECK_EQUAL(NEW_CONTENT + NEW_CONTENT, GetFileContent("tmp.log"));
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT + NEW_CONTENT),
+                      file->WrittenSize( ));
+}
+
 BOOST_AUTO_TEST_CASE(AppendingWhenManyFilesMatchPathRule)
 {
     myrrh::file::Eraser eraser("folder");
@@ -318,6 +386,196 @@ BOOST_AUTO_TEST_CASE(AppendingWhenManyFilesMatchPathRule)
     BOOST_CHECK_EQUAL(expected, file->Path( ));
 }
 
+BOOST_AUTO_TEST_CASE(SharedFilesAreNotBuffered)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Appender opener(Appender::SHARED);
+    opener.SetBufferSize(32);
+    FilePtr file(opener.Open(GetPath("tmp.log")));
+
+    BOOST_CHECK(file->IsShared( ));
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+    BOOST_CHECK_EQUAL(NEW_CONTENT, GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(SharedSizeIncludesOtherWriters)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Appender first(Appender::SHARED);
+    Appender second(Appender::SHARED);
+    FilePtr firstFile(first.Open(GetPath("tmp.log")));
+    FilePtr secondFile(second.Open(GetPath("tmp.log")));
+
+    firstFile->Write(ORIGINAL_CONTENT);
+    secondFile->Write(NEW_CONTENT);
+    BOOST_CHECK_EQUAL(StringSize(ORIGINAL_CONTENT + NEW_CONTENT),
+                      firstFile->WrittenSize( ));
+    BOOST_CHECK_EQUAL(ORIGINAL_CONTENT + NEW_CONTENT,
+                      GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(PreallocatedFileKeepsWrittenSize)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Creator opener;
+    opener.SetPreallocation(1024 * 1024);
+    {
+        FilePtr file(opener.Open(GetPath("tmp.log")));
+        BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+        BOOST_CHECK_EQUAL(NEW_CONTENT, GetFileContent("tmp.log"));
+    }
+
+    BOOST_CHECK_EQUAL(NEW_CONTENT, GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(MappedFileIsTruncatedToWrittenSize)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Creator opener;
+    opener.SetMapping(4096);
+    const std::string LINE(std::string(99, 'x') + '\n');
+    std::string written;
+    {
+        FilePtr file(opener.Open(GetPath("tmp.log")));
+        for (int i = 0; i < 100; ++i)
+        {
+            BOOST_CHECK_EQUAL(StringSize(LINE), file->Write(LINE));
+            written += LINE;
+        }
+
+        BOOST_CHECK_EQUAL(StringSize(written), file->WrittenSize( ));
+        BOOST_CHECK(StringSize(written) <=
+                    static_cast<std::streamsize>(
+                        boost::filesystem::file_size("tmp.log")));
+    }
+
+    BOOST_CHECK(written == GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(MappedFileIsAppended)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+    CreateFile("tmp.log", ORIGINAL_CONTENT);
+
+    Appender opener;
+    opener.SetMapping(4096);
+    {
+        FilePtr file(opener.Open(GetPath("tmp.log")));
+        BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+    }
+
+    BOOST_CHECK_EQUAL(ORIGINAL_CONTENT + NEW_CONTENT,
+                      GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(BufferedDurabilityCollectsLines)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Creator opener;
+    opener.SetDurability(Opener::BUFFERED);
+    {
+        FilePtr file(opener.Open(GetPath("tmp.log")));
+        BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+        BOOST_CHECK(GetFileContent("tmp.log").empty( ));
+    }
+
+    BOOST_CHECK_EQUAL(NEW_CONTENT, GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(BufferedDurabilityWritesAfterInterval)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Creator opener;
+    opener.SetDurability(Opener::BUFFERED, 0, 100);
+    FilePtr file(opener.Open(GetPath("tmp.log")));
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+    BOOST_CHECK(GetFileContent("tmp.log").empty( ));
+
+    // No more lines are written, the buffer is written by the interval alone
+    boost::this_thread::sleep(boost::posix_time::milliseconds(300));
+    BOOST_CHECK_EQUAL(NEW_CONTENT, GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(BufferedDurabilityWaitsForCommit)
+{
+    myrrh::file::Eraser eraser("tmp.log");
+
+    Creator opener;
+    opener.SetDurability(Opener::BUFFERED, 0, 50);
+    FilePtr file(opener.Open(GetPath("tmp.log")));
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT), file->Write(NEW_CONTENT));
+
+    // The room is being formatted, so the buffer is not written under it
+    std::size_t available = 0;
+    char *room = file->Reserve(NEW_CONTENT.size( ), available);
+    BOOST_REQUIRE(room && available >= NEW_CONTENT.size( ));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    BOOST_CHECK(GetFileContent("tmp.log").empty( ));
+
+    std::copy(NEW_CONTENT.begin( ), NEW_CONTENT.end( ), room);
+    BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT),
+                      file->Commit(NEW_CONTENT.size( )));
+    BOOST_CHECK_EQUAL(NEW_CONTENT + NEW_CONTENT, GetFileContent("tmp.log"));
+}
+
+BOOST_AUTO_TEST_CASE(SynchronizedDurabilitiesWriteEachLine)
+{
+    const Opener::Durability DURABILITIES[] =
+        { Opener::SYNCED, Opener::WRITEBACK, Opener::DSYNC };
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        myrrh::file::Eraser eraser("tmp.log");
+        CreateFile("tmp.log", ORIGINAL_CONTENT);
+
+        Appender opener;
+        opener.SetDurability(DURABILITIES[i], 16);
+        FilePtr file(opener.Open(GetPath("tmp.log")));
+        for (int j = 0; j < 3; ++j)
+        {
+            BOOST_CHECK_EQUAL(StringSize(NEW_CONTENT),
+                              file->Write(NEW_CONTENT));
+        }
+
+        BOOST_CHECK_EQUAL(ORIGINAL_CONTENT + NEW_CONTENT + NEW_CONTENT +
+                          NEW_CONTENT, GetFileContent("tmp.log"));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SharedFilesAreRotatedOnce)
+{
+    myrrh::file::Eraser eraser("folder");
+    Path path("folder");
+    path += "myrrh" + Index( ) + ".log";
+
+    // The policies stand for two processes writing the same files
+    InitialOpenerPtr firstOpener(new Appender(Appender::SHARED));
+    InitialOpenerPtr secondOpener(new Appender(Appender::SHARED));
+    Policy first(path, firstOpener, firstOpener);
+    Policy second(path, secondOpener, secondOpener);
+    first.AddRestriction(RestrictionPtr(new SizeRestriction(100)));
+    second.AddRestriction(RestrictionPtr(new SizeRestriction(100)));
+
+    const std::string LINE(std::string(59, 'x') + '\n');
+    BOOST_CHECK_EQUAL(StringSize(LINE), first.Write(LINE));
+
+    // The line of the first one is counted, so the second one starts the
+    // next file. The first one joins it, but has to start the third file.
+    BOOST_CHECK_EQUAL(StringSize(LINE), second.Write(LINE));
+    BOOST_CHECK_EQUAL(StringSize(LINE), first.Write(LINE));
+
+    BOOST_CHECK_EQUAL(LINE, GetFileContent("folder/myrrh1.log"));
+    BOOST_CHECK_EQUAL(LINE, GetFileContent("folder/myrrh2.log"));
+    BOOST_CHECK_EQUAL(LINE, GetFileContent("folder/myrrh3.log"));
+    BOOST_CHECK(!boost::filesystem::exists("folder/myrrh4.log"));
+}
+
 // Local declarations
 namespace
 {
@@ -483,6 +483,30 @@ BOOST_AUTO_TEST_CASE(UseComparerForSorting)
     BOOST_CHECK(expected == toSort);
 }
 
+BOOST_AUTO_TEST_CASE(ParsingGivesComparableKeys)
+{
+    Path path;
+    path += Text("log") + Date( ) + Text("-") + Index( ) + Text(".txt");
+    const Path::Entity &ENTITY(*path.BeginEntity( ));
+
+    Path::Entity::Key key9;
+    Path::Entity::Key key10;
+    Path::Entity::Key key010;
+    Path::Entity::Key later;
+    BOOST_CHECK(ENTITY.Parse("log20060112-9.txt", key9));
+    BOOST_CHECK(ENTITY.Parse("folder/log20060112-10.txt", key10));
+    BOOST_CHECK(ENTITY.Parse("log20060112-010.txt", key010));
+    BOOST_CHECK(ENTITY.Parse("log20060113-1.txt", later));
+    BOOST_CHECK(key9 < key10);
+    BOOST_CHECK(key10 == key010);
+    BOOST_CHECK(key10 < later);
+
+    Path::Entity::Key unchanged(key9);
+    BOOST_CHECK(!ENTITY.Parse("log20060112-.txt", unchanged));
+    BOOST_CHECK(!ENTITY.Parse("log20060112-9.txt.old", unchanged));
+    BOOST_CHECK(key9 == unchanged);
+}
+
 // Divide smaller
 BOOST_AUTO_TEST_CASE(AddingRestriction)
 {
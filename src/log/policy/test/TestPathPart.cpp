@@ -24,6 +24,7 @@
 #include "boost/test/unit_test.hpp"
 #include "boost/filesystem/path.hpp"
 #include "boost/regex.hpp"
+#include "boost/thread/thread.hpp"
 
 #ifdef WIN32
 
@@ -42,6 +43,7 @@ namespace
 {
 
 std::string DateString( );
+std::string LocalTimeString(const char *format);
 std::string GetProcessId( );
 std::string GenerateFromSum(const PartSum &sum);
 boost::regex ExpressionFromSum(const PartSum &sum);
@@ -67,8 +69,11 @@ void TestFolderPathPart( );
 void TestDatePathPart( );
 void TestTimePathPart( );
 void TestTimeGenerationIsAlwaysUnique( );
+void TestHourPathPart( );
+void TestMinutesPathPart( );
 void TestIndexPathPart( );
 void TestPidPathPart( );
+void TestTidPathPart( );
 void TestAddingPartsTogether( );
 void TestDotInText( );
 
@@ -88,8 +93,11 @@ TestSuite *init_unit_test_suite(int, char *[])
     test->add(BOOST_TEST_CASE(TestDatePathPart));
     test->add(BOOST_TEST_CASE(TestTimePathPart));
     test->add(BOOST_TEST_CASE(TestTimeGenerationIsAlwaysUnique));
+    test->add(BOOST_TEST_CASE(TestHourPathPart));
+    test->add(BOOST_TEST_CASE(TestMinutesPathPart));
     test->add(BOOST_TEST_CASE(TestIndexPathPart));
     test->add(BOOST_TEST_CASE(TestPidPathPart));
+    test->add(BOOST_TEST_CASE(TestTidPathPart));
     test->add(BOOST_TEST_CASE(TestAddingPartsTogether));
     test->add(BOOST_TEST_CASE(TestDotInText));
     test->add(BOOST_TEST_CASE(TestFolderStringToPartSum));
@@ -335,6 +343,51 @@ void TestTimeGenerationIsAlwaysUnique( )
     }
 }
 
+void TestHourPathPart( )
+{
+    const std::string EXPRESSION("([01]\\d|2[0-3])");
+    Hour hour;
+    BOOST_CHECK_EQUAL(LocalTimeString("%H"), hour.Generate( ));
+    BOOST_CHECK_EQUAL(EXPRESSION, hour.GetExpression( ).str( ));
+    BOOST_CHECK(boost::regex_match(hour.Generate( ), hour.GetExpression( )));
+    BOOST_CHECK(!boost::regex_match("24", hour.GetExpression( )));
+
+    Hour hour2(hour);
+    RestrictionStore store;
+    hour.AppendRestrictions(store);
+    hour2.AppendRestrictions(store);
+    BOOST_CHECK_EQUAL(2u, store.Count( ));
+
+    IsFirstLater(hour, "10", "09");
+    IsFirstLater(hour, "23", "00");
+
+    BOOST_CHECK(!hour.IsFirstEarlier("12", "12"));
+}
+
+void TestMinutesPathPart( )
+{
+    const std::string EXPRESSION("([01]\\d|2[0-3])([0-5]\\d)");
+    Minutes minutes(15);
+    const std::string GENERATED(minutes.Generate( ));
+    BOOST_CHECK_EQUAL(EXPRESSION, minutes.GetExpression( ).str( ));
+    BOOST_CHECK(boost::regex_match(GENERATED, minutes.GetExpression( )));
+    BOOST_CHECK_EQUAL(LocalTimeString("%H"), GENERATED.substr(0, 2));
+    BOOST_CHECK_EQUAL(0, boost::lexical_cast<int>(GENERATED.substr(2)) % 15);
+
+    BOOST_CHECK_EQUAL(LocalTimeString("%H%M"), Minutes(1).Generate( ));
+
+    Minutes minutes2(minutes);
+    RestrictionStore store;
+    minutes.AppendRestrictions(store);
+    minutes2.AppendRestrictions(store);
+    BOOST_CHECK_EQUAL(2u, store.Count( ));
+
+    IsFirstLater(minutes, "1015", "1000");
+    IsFirstLater(minutes, "1000", "0945");
+
+    BOOST_CHECK(!minutes.IsFirstEarlier("1200", "1200"));
+}
+
 // Divide smaller
 void TestIndexPathPart( )
 {
@@ -378,6 +431,27 @@ void TestPidPathPart( )
     BOOST_CHECK(!pid.IsFirstEarlier(PID, PID));
 }
 
+void TestTidPathPart( )
+{
+    ThreadId tid;
+    const std::string TID(tid.Generate( ));
+    BOOST_CHECK(!TID.empty( ));
+    BOOST_CHECK_EQUAL(TID, tid.GetExpression( ).str( ));
+    BOOST_CHECK(boost::regex_match(TID, tid.GetExpression( )));
+
+    std::string otherTid;
+    boost::thread other([&otherTid]( ) { otherTid = ThreadId( ).Generate( ); });
+    other.join( );
+    BOOST_CHECK(TID != otherTid);
+    BOOST_CHECK(!boost::regex_match(otherTid, tid.GetExpression( )));
+
+    RestrictionStore store;
+    tid.AppendRestrictions(store);
+    BOOST_CHECK(!store.Count( ));
+
+    BOOST_CHECK(!tid.IsFirstEarlier(TID, TID));
+}
+
 void TestAddingPartsTogether( )
 {
     const std::string TEXT1("Text1");
@@ -418,6 +492,14 @@ std::string DateString( )
     return stream.str( );
 }
 
+std::string LocalTimeString(const char *format)
+{
+    std::time_t now = std::time(0);
+    char result[16];
+    std::strftime(result, sizeof(result), format, std::localtime(&now));
+    return result;
+}
+
 std::string GetProcessId( )
 {
 #ifdef WIN32
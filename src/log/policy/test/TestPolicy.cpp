@@ -22,12 +22,14 @@
 #include "boost/test/unit_test.hpp"
 #include "boost/lexical_cast.hpp"
 #include "boost/filesystem/operations.hpp"
+#include "boost/thread/thread.hpp"
 
 #ifdef WIN32
 #pragma warning(pop)
 #include <windows.h>
 #endif
 
+#include <fstream>
 #include <vector>
 
 #undef TEXT
@@ -48,12 +50,19 @@ void PathIsRestricted( );
 void TryingToOpenProtectedFile( );
 void TryingToOpenReadOnlyFile( );
 void FileBecomesReadOnly( );
+void OpenAheadPreparesNextFile( );
+void OpenAheadKeepsUnchangedPath( );
+void OpenAheadSkipsNoIndex( );
+void OpenAheadGivesPathToOpener( );
 
 // Helper function declarations
 std::string GetFileContent(const boost::filesystem::path &path);
 std::streamsize StringSize(const std::string &toMeasure);
 boost::filesystem::path IntegerToPath(const boost::filesystem::path &path,
                                       int integer);
+bool WaitForFile(const boost::filesystem::path &path);
+std::size_t CountTemporaryFiles(const boost::filesystem::path &folder);
+bool WaitForTemporaryFile(const boost::filesystem::path &folder);
 
 // Constants
 const std::string TEST_FILE_DIRECTORY("testFiles/");
@@ -160,6 +169,23 @@ public:
     operator PartSum( ) const;
 };
 
+/**
+ * Counts the files that it opens with rules other than the indexed ones of
+ * TEST_FILE_BASE. The temporary files are not counted.
+ */
+class IndexCheckingOpener : public InitialOpener
+{
+public:
+
+    IndexCheckingOpener( );
+
+    int mismatches;
+
+private:
+
+    virtual boost::filesystem::path DoOpen(std::filebuf &file, Path &path);
+};
+
 // Use automatic test initialization
 TestSuite *init_unit_test_suite(int, char *[])
 {
@@ -178,6 +204,10 @@ TestSuite *init_unit_test_suite(int, char *[])
 #endif
     test->add(BOOST_TEST_CASE(TryingToOpenReadOnlyFile));
     test->add(BOOST_TEST_CASE(FileBecomesReadOnly));
+    test->add(BOOST_TEST_CASE(OpenAheadPreparesNextFile));
+    test->add(BOOST_TEST_CASE(OpenAheadKeepsUnchangedPath));
+    test->add(BOOST_TEST_CASE(OpenAheadSkipsNoIndex));
+    test->add(BOOST_TEST_CASE(OpenAheadGivesPathToOpener));
     return test;
 }
 
@@ -327,6 +357,27 @@ RestrictedPart::operator PartSum( ) const
     return sum;
 }
 
+IndexCheckingOpener::IndexCheckingOpener( ) :
+    mismatches(0)
+{
+}
+
+boost::filesystem::path IndexCheckingOpener::DoOpen(std::filebuf &file,
+                                                    Path &path)
+{
+    const boost::filesystem::path PATH(path.Generate( ));
+    std::string key;
+    if ('.' != PATH.filename( ).string( )[0] &&
+        !path.Parse(IntegerToPath(TEST_FILE_BASE, 9), key))
+    {
+        ++mismatches;
+    }
+
+    boost::filesystem::create_directories(PATH.parent_path( ));
+    file.open(PATH.string( ).c_str( ), std::ios::out | std::ios::trunc);
+    return PATH;
+}
+
 void WriteSize( )
 {
     class Case : public TestCase
@@ -616,6 +667,113 @@ void FileBecomesReadOnly( )
     BOOST_CHECK(policy.Write("Hubbadeijaa") > 0);
 }
 
+void OpenAheadPreparesNextFile( )
+{
+    myrrh::file::Eraser eraser(TEST_FILE_DIRECTORY);
+
+    Path path;
+    path += TEST_FILE_BASE + Index( );
+
+    {
+        InitialOpenerPtr opener(new Creator( ));
+        Policy policy(path, opener, opener);
+        policy.AddRestriction(RestrictionPtr(new Restricted));
+        policy.OpenAhead( );
+
+        // The file is prepared under a temporary name, which is replaced
+        // with the next path once the file is taken into use
+        BOOST_CHECK(WaitForTemporaryFile(TEST_FILE_DIRECTORY));
+        BOOST_CHECK_EQUAL(5, policy.Write("First"));
+        BOOST_CHECK_EQUAL("First",
+                          GetFileContent(IntegerToPath(TEST_FILE_BASE, 2)));
+
+        BOOST_CHECK(WaitForTemporaryFile(TEST_FILE_DIRECTORY));
+        BOOST_CHECK_EQUAL(6, policy.Write("Second"));
+        BOOST_CHECK_EQUAL("Second",
+                          GetFileContent(IntegerToPath(TEST_FILE_BASE, 3)));
+        BOOST_CHECK(WaitForTemporaryFile(TEST_FILE_DIRECTORY));
+        BOOST_CHECK(!boost::filesystem::exists(
+                        IntegerToPath(TEST_FILE_BASE, 4)));
+    }
+
+    // The unused file is removed
+    BOOST_CHECK(GetFileContent(IntegerToPath(TEST_FILE_BASE, 1)).empty( ));
+    BOOST_CHECK_EQUAL(0u, CountTemporaryFiles(TEST_FILE_DIRECTORY));
+}
+
+void OpenAheadKeepsUnchangedPath( )
+{
+    myrrh::file::Eraser eraser(TEST_FILE_DIRECTORY);
+
+    Path path;
+    path += TEST_FILE_BASE;
+
+    InitialOpenerPtr opener(new Creator( ));
+    Policy policy(path, opener, opener);
+    BOOST_CHECK_EQUAL(9, policy.Write("Something"));
+    policy.OpenAhead( );
+
+    // The same path must not be opened again, as Creator would truncate it
+    boost::this_thread::sleep(boost::posix_time::milliseconds(300));
+    BOOST_CHECK_EQUAL(5, policy.Write(" else"));
+    BOOST_CHECK_EQUAL("Something else", GetFileContent(TEST_FILE_BASE));
+}
+
+void OpenAheadSkipsNoIndex( )
+{
+    myrrh::file::Eraser eraser(TEST_FILE_DIRECTORY);
+
+    // The restriction of the part makes each prepared file outdated, so the
+    // prepared files are replaced over and over
+    Path path;
+    path += TEST_FILE_BASE + RestrictedPart( );
+
+    {
+        InitialOpenerPtr opener(new Creator( ));
+        Policy policy(path, opener, opener);
+        policy.OpenAhead( );
+        boost::this_thread::sleep(boost::posix_time::milliseconds(350));
+
+        BOOST_CHECK_EQUAL(5, policy.Write("First"));
+    }
+
+    BOOST_CHECK_EQUAL("First",
+                      GetFileContent(IntegerToPath(TEST_FILE_BASE, 2)));
+    BOOST_CHECK(!boost::filesystem::exists(IntegerToPath(TEST_FILE_BASE, 3)));
+    BOOST_CHECK_EQUAL(0u, CountTemporaryFiles(TEST_FILE_DIRECTORY));
+}
+
+void OpenAheadGivesPathToOpener( )
+{
+    myrrh::file::Eraser eraser(TEST_FILE_DIRECTORY);
+    boost::filesystem::create_directories(TEST_FILE_DIRECTORY);
+    {
+        std::ofstream old(IntegerToPath(TEST_FILE_BASE, 2).string( ).c_str( ));
+        old << "Old";
+    }
+
+    Path path;
+    path += TEST_FILE_BASE + Index( );
+
+    boost::shared_ptr<IndexCheckingOpener> opener(new IndexCheckingOpener);
+    {
+        Policy policy(path, opener, opener);
+        policy.AddRestriction(RestrictionPtr(new Restricted));
+        policy.OpenAhead( );
+
+        // The generated name exists, so the next file is opened with the
+        // rules of the path instead of the prepared file
+        BOOST_CHECK(WaitForTemporaryFile(TEST_FILE_DIRECTORY));
+        BOOST_CHECK_EQUAL(5, policy.Write("First"));
+    }
+
+    BOOST_CHECK_EQUAL(0, opener->mismatches);
+    BOOST_CHECK_EQUAL("Old", GetFileContent(IntegerToPath(TEST_FILE_BASE, 2)));
+    BOOST_CHECK_EQUAL("First",
+                      GetFileContent(IntegerToPath(TEST_FILE_BASE, 3)));
+    BOOST_CHECK_EQUAL(0u, CountTemporaryFiles(TEST_FILE_DIRECTORY));
+}
+
 std::string GetFileContent(const boost::filesystem::path &path)
 {
     std::ifstream file(path.string( ).c_str( ));
@@ -641,3 +799,49 @@ boost::filesystem::path IntegerToPath(const boost::filesystem::path &path,
     return boost::filesystem::path(path.string( ) +
                                    boost::lexical_cast<std::string>(integer));
 }
+
+bool WaitForFile(const boost::filesystem::path &path)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (boost::filesystem::exists(path))
+        {
+            return true;
+        }
+
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    return false;
+}
+
+std::size_t CountTemporaryFiles(const boost::filesystem::path &folder)
+{
+    std::size_t result = 0;
+    boost::system::error_code error;
+    for (boost::filesystem::directory_iterator i(folder, error);
+         boost::filesystem::directory_iterator( ) != i; ++i)
+    {
+        if ('.' == i->path( ).filename( ).string( )[0])
+        {
+            ++result;
+        }
+    }
+
+    return result;
+}
+
+bool WaitForTemporaryFile(const boost::filesystem::path &folder)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (CountTemporaryFiles(folder))
+        {
+            return true;
+        }
+
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    return false;
+}
@@ -22,6 +22,9 @@
  * In addition the following test sare made for DateRestriction:
  * -The date has changed since last writing.
  *
+ * For IntervalRestriction it is tested that the deadline is aligned to the
+ * local wall clock.
+ *
  * $Id: TestRestriction.cpp 356 2007-09-18 19:55:21Z byon $
  */
 
@@ -40,6 +43,8 @@
 #include "boost/algorithm/string/erase.hpp"
 #include "boost/algorithm/string/replace.hpp"
 #include "boost/filesystem/operations.hpp"
+#include "boost/date_time/c_local_time_adjustor.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
 
 #ifdef WIN32
 #pragma warning(pop)
@@ -61,6 +66,8 @@ template <typename Types, typename FileInitializer, typename Line,
          typename Case>
 void AddCase(TestSuite *test);
 
+void TestIntervalRestriction( );
+
 int isNewDate = 0;
 class DateCreatorForTests
 {
@@ -268,9 +275,38 @@ TestSuite *init_unit_test_suite(int, char *[])
     AddCase<DateRestrictionTypes, EmptyFile, FixedSizeLine<10>,
             ChangeDateCase>(test);
 
+    test->add(BOOST_TEST_CASE(TestIntervalRestriction));
+
     return test;
 }
 
+void TestIntervalRestriction( )
+{
+    using namespace boost::posix_time;
+    typedef boost::date_time::c_local_adjustor<ptime> LocalAdjustor;
+
+    const ptime EPOCH(boost::gregorian::date(1970, 1, 1));
+    const ptime NOW(microsec_clock::universal_time( ));
+
+    TestSetup setup;
+    Path path(FILE_NAME);
+    FilePtr file(Creator( ).Open(path));
+
+    IntervalRestriction restriction(15);
+    Limits limits;
+    BOOST_CHECK(restriction.GetLimits(*file, limits));
+    BOOST_CHECK(!restriction.IsRestricted(*file, 0));
+
+    const ptime DEADLINE(EPOCH + milliseconds(limits.deadline));
+    BOOST_CHECK(DEADLINE > NOW);
+    BOOST_CHECK(DEADLINE <= NOW + minutes(15));
+
+    const time_duration LOCAL(
+        LocalAdjustor::utc_to_local(DEADLINE).time_of_day( ));
+    BOOST_CHECK_EQUAL(0, LOCAL.minutes( ) % 15);
+    BOOST_CHECK_EQUAL(0, LOCAL.seconds( ));
+}
+
 // Helper function implementations
 
 template <typename Types, typename Case>
@@ -11,6 +11,7 @@
 
 #include "myrrh/log/policy/RestrictionStore.hpp"
 #include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/log/policy/File.hpp"
 #include "myrrh/log/policy/Opener.hpp"
 #include "myrrh/log/policy/Path.hpp"
 
@@ -55,6 +56,21 @@ private:
     mutable unsigned callTimes_;
 };
 
+/**
+ * Publishes the given limits and counts the checks
+ */
+class LimitedRestriction : public OwnRestriction
+{
+public:
+    LimitedRestriction(std::size_t budget,
+                       myrrh::util::CoarseClock::Ticks deadline);
+private:
+    virtual bool GetLimits(const File &, Limits &limits) const;
+
+    const std::size_t BUDGET_;
+    const myrrh::util::CoarseClock::Ticks DEADLINE_;
+};
+
 }
 
 // Test implementations
@@ -121,6 +137,91 @@ BOOST_AUTO_TEST_CASE(RestrictionGetsCalled)
     BOOST_CHECK_EQUAL(1, restriction->CallTimes( ));
 }
 
+BOOST_AUTO_TEST_CASE(ChargingChecksWhenBudgetCrossed)
+{
+    RestrictionStore store;
+
+    boost::shared_ptr<OwnRestriction> restriction(
+        new LimitedRestriction(10, myrrh::util::CoarseClock::NEVER));
+    store.Add(restriction);
+
+    Path path;
+    FilePtr file(DummyOpener( ).Open(path));
+    BOOST_CHECK(!store.Charge(*file, 5));
+    BOOST_CHECK(!store.Charge(*file, 5));
+    BOOST_CHECK_EQUAL(1, restriction->CallTimes( ));
+
+    BOOST_CHECK(!store.Charge(*file, 1));
+    BOOST_CHECK_EQUAL(2, restriction->CallTimes( ));
+}
+
+BOOST_AUTO_TEST_CASE(ChargingChecksWhenDeadlinePassed)
+{
+    RestrictionStore store;
+
+    boost::shared_ptr<OwnRestriction> restriction(
+        new LimitedRestriction(100, myrrh::util::CoarseClock::Now( ) - 1));
+    store.Add(restriction);
+
+    Path path;
+    FilePtr file(DummyOpener( ).Open(path));
+    BOOST_CHECK(!store.Charge(*file, 1));
+    BOOST_CHECK(!store.Charge(*file, 1));
+    BOOST_CHECK_EQUAL(2, restriction->CallTimes( ));
+}
+
+BOOST_AUTO_TEST_CASE(ChargingChecksRestrictionWithoutLimits)
+{
+    RestrictionStore store;
+
+    boost::shared_ptr<OwnRestriction> restriction(new OwnRestriction);
+    store.Add(restriction);
+    store.Add(RestrictionPtr(new SizeRestriction(100)));
+
+    Path path;
+    FilePtr file(DummyOpener( ).Open(path));
+    BOOST_CHECK(!store.Charge(*file, 1));
+    BOOST_CHECK(!store.Charge(*file, 1));
+    BOOST_CHECK(!store.Charge(*file, 1));
+    BOOST_CHECK_EQUAL(3, restriction->CallTimes( ));
+}
+
+BOOST_AUTO_TEST_CASE(ChargingAfterRestricted)
+{
+    RestrictionStore store;
+    store.Add(RestrictionPtr(new SizeRestriction(10)));
+
+    Path path;
+    FilePtr file(DummyOpener( ).Open(path));
+    BOOST_CHECK(store.Charge(*file, 11));
+    BOOST_CHECK(!store.Charge(*file, 10));
+    BOOST_CHECK(store.Charge(*file, 11));
+}
+
+BOOST_AUTO_TEST_CASE(IntervalIsCheckedAgainstOpenTime)
+{
+    using myrrh::util::CoarseClock;
+
+    IntervalRestriction restriction(1);
+
+    Path path;
+    FilePtr file(DummyOpener( ).Open(path));
+    Limits first;
+    BOOST_CHECK(restriction.GetLimits(*file, first));
+    BOOST_CHECK(first.deadline > file->OpenTime( ));
+    BOOST_CHECK(first.deadline <= file->OpenTime( ) + 60 * 1000);
+
+    // Checking does not move the boundary, so the answer is the same for as
+    // long as the same file is checked
+    const bool RESTRICTED = CoarseClock::Now( ) >= first.deadline;
+    BOOST_CHECK_EQUAL(RESTRICTED, restriction.IsRestricted(*file, 0));
+    BOOST_CHECK_EQUAL(RESTRICTED, restriction.IsRestricted(*file, 0));
+
+    Limits second;
+    BOOST_CHECK(restriction.GetLimits(*file, second));
+    BOOST_CHECK_EQUAL(first.deadline, second.deadline);
+}
+
 // Local implementations
 
 namespace
@@ -154,4 +255,18 @@ bool OwnRestriction::IsRestricted(const File &, std::size_t) const
     return false;
 }
 
+LimitedRestriction::LimitedRestriction(
+    std::size_t budget, myrrh::util::CoarseClock::Ticks deadline) :
+    BUDGET_(budget),
+    DEADLINE_(deadline)
+{
+}
+
+bool LimitedRestriction::GetLimits(const File &, Limits &limits) const
+{
+    limits.budget = BUDGET_;
+    limits.deadline = DEADLINE_;
+    return true;
+}
+
 }
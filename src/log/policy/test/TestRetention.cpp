@@ -0,0 +1,335 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for Retention
+ */
+
+#include "myrrh/log/policy/Retention.hpp"
+#include "myrrh/log/policy/Appender.hpp"
+#include "myrrh/log/policy/Creator.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/log/policy/Policy.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/thread/thread.hpp"
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <ctime>
+#include <fstream>
+#include <iterator>
+
+using namespace myrrh::log::policy;
+
+// Local declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("retentionTest");
+
+Path IndexedPath( );
+boost::filesystem::path IndexedFile(int index);
+void CreateFile(const boost::filesystem::path &path, std::size_t size = 0);
+std::size_t CountFiles( );
+std::string ReadFile(const boost::filesystem::path &path);
+
+/**
+ * Counts the files that the rules of IndexedPath match
+ */
+std::size_t CountLogFiles( );
+
+/**
+ * Waits for the background thread to remove the file
+ * @return false, if the file still exists after a while
+ */
+bool WaitForRemoval(const boost::filesystem::path &path);
+
+/**
+ * Waits for the background thread to keep a spare file and renames it
+ * @return false, if there is no spare file after a while
+ */
+bool WaitForRecycling(Retention &retention,
+                      const boost::filesystem::path &path);
+
+}
+
+BOOST_AUTO_TEST_CASE(MaxCountRemovesOldest)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    for (int i = 1; i <= 5; ++i)
+    {
+        CreateFile(IndexedFile(i));
+    }
+
+    Retention retention(IndexedPath( ));
+    retention.SetMaxCount(3);
+    retention.Opened(IndexedFile(5));
+
+    BOOST_CHECK(WaitForRemoval(IndexedFile(2)));
+    BOOST_CHECK(!boost::filesystem::exists(IndexedFile(1)));
+    BOOST_CHECK_EQUAL(3u, CountFiles( ));
+}
+
+BOOST_AUTO_TEST_CASE(MaxSizeRemovesOldest)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    for (int i = 1; i <= 4; ++i)
+    {
+        CreateFile(IndexedFile(i), 100);
+    }
+
+    // Index 10 is later than 4, although the name sorts before it
+    CreateFile(IndexedFile(10), 100);
+
+    Retention retention(IndexedPath( ));
+    retention.SetMaxSize(350);
+    retention.Opened(IndexedFile(10));
+
+    BOOST_CHECK(WaitForRemoval(IndexedFile(2)));
+    BOOST_CHECK(!boost::filesystem::exists(IndexedFile(1)));
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(3)));
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(10)));
+}
+
+BOOST_AUTO_TEST_CASE(MaxAgeRemovesOldest)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    CreateFile(IndexedFile(1));
+    CreateFile(IndexedFile(2));
+    boost::filesystem::last_write_time(IndexedFile(1), std::time(0) - 7200);
+
+    Retention retention(IndexedPath( ));
+    retention.SetMaxAge(boost::posix_time::hours(1));
+    retention.Opened(IndexedFile(2));
+
+    BOOST_CHECK(WaitForRemoval(IndexedFile(1)));
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(2)));
+}
+
+BOOST_AUTO_TEST_CASE(CurrentFileIsKept)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    CreateFile(IndexedFile(1), 100);
+
+    Retention retention(IndexedPath( ));
+    retention.SetMaxSize(10);
+    retention.Opened(IndexedFile(1));
+
+    BOOST_CHECK(!WaitForRemoval(IndexedFile(1)));
+}
+
+BOOST_AUTO_TEST_CASE(EmptyFoldersAreRemoved)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    CreateFile(FOLDER / "20060101" / "log1.txt");
+    CreateFile(FOLDER / "20060102" / "log1.txt");
+    CreateFile(FOLDER / "20060102" / "log2.txt");
+
+    Path path(FOLDER);
+    path += Date( ) + "/log" + Index( ) + ".txt";
+    Retention retention(path);
+    retention.SetMaxCount(2);
+    retention.Opened(FOLDER / "20060102" / "log2.txt");
+
+    BOOST_CHECK(WaitForRemoval(FOLDER / "20060101"));
+    BOOST_CHECK(boost::filesystem::exists(FOLDER / "20060102" / "log1.txt"));
+}
+
+BOOST_AUTO_TEST_CASE(PolicyReportsOpenedFiles)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    Path path(IndexedPath( ));
+    Policy policy(path, InitialOpenerPtr(new Appender),
+                  OpenerPtr(new Creator));
+    policy.AddRestriction(RestrictionPtr(new SizeRestriction(10)));
+
+    RetentionPtr retention(new Retention(path));
+    retention->SetMaxCount(2);
+    policy.SetRetention(retention);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        BOOST_CHECK_EQUAL(8, policy.Write("01234567"));
+    }
+
+    BOOST_CHECK(WaitForRemoval(IndexedFile(3)));
+    BOOST_CHECK_EQUAL(2u, CountFiles( ));
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(5)));
+}
+
+BOOST_AUTO_TEST_CASE(RecyclingKeepsOldestFile)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    for (int i = 1; i <= 3; ++i)
+    {
+        CreateFile(IndexedFile(i), 100);
+    }
+
+    {
+        Retention retention(IndexedPath( ));
+        retention.SetMaxCount(2);
+        retention.SetRecycling(true);
+        retention.Opened(IndexedFile(3));
+
+        // The spare is kept under a name that is not taken for a log file
+        BOOST_REQUIRE(WaitForRemoval(IndexedFile(1)));
+        BOOST_CHECK_EQUAL(3u, CountFiles( ));
+        BOOST_CHECK_EQUAL(2u, CountLogFiles( ));
+
+        BOOST_REQUIRE(WaitForRecycling(retention, IndexedFile(4)));
+        BOOST_CHECK_EQUAL(100u, boost::filesystem::file_size(IndexedFile(4)));
+        BOOST_CHECK_EQUAL(3u, CountFiles( ));
+        BOOST_CHECK(!retention.Recycle(IndexedFile(5)));
+    }
+
+    BOOST_CHECK(boost::filesystem::exists(IndexedFile(2)));
+}
+
+BOOST_AUTO_TEST_CASE(CreatorWritesOverRecycledFile)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    Path path(IndexedPath( ));
+    RetentionPtr retention(new Retention(path));
+    retention->SetMaxCount(2);
+    boost::shared_ptr<Creator> creator(new Creator);
+    creator->SetRecycling(retention);
+
+    int last = 1;
+    {
+        Policy policy(path, creator, creator);
+        policy.AddRestriction(RestrictionPtr(new SizeRestriction(10)));
+        policy.SetRetention(retention);
+        BOOST_CHECK_EQUAL(10, policy.Write("012345678\n"));
+
+        // Each write starts a new file, until the first one is recycled
+        while (CountFiles( ) <= 2 && last < 100)
+        {
+            BOOST_CHECK_EQUAL(8, policy.Write("abcdefg\n"));
+            ++last;
+            boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+        }
+
+        // The next file is the recycled one. It keeps its blocks until it
+        // is closed, but its old content is zeroed.
+        BOOST_CHECK_EQUAL(8, policy.Write("hijklmn\n"));
+        ++last;
+        BOOST_CHECK_EQUAL(10u,
+                          boost::filesystem::file_size(IndexedFile(last)));
+        BOOST_CHECK_EQUAL(std::string("hijklmn\n\0\0", 10),
+                          ReadFile(IndexedFile(last)));
+    }
+
+    BOOST_REQUIRE(!boost::filesystem::exists(IndexedFile(1)));
+    BOOST_CHECK_EQUAL(8u, boost::filesystem::file_size(IndexedFile(last)));
+}
+
+// Local implementations
+
+namespace
+{
+
+Path IndexedPath( )
+{
+    Path path(FOLDER);
+    path += "log" + Index( ) + ".txt";
+    return path;
+}
+
+boost::filesystem::path IndexedFile(int index)
+{
+    std::ostringstream name;
+    name << "log" << index << ".txt";
+    return FOLDER / name.str( );
+}
+
+void CreateFile(const boost::filesystem::path &path, std::size_t size)
+{
+    boost::filesystem::create_directories(path.branch_path( ));
+    std::ofstream file(path.string( ).c_str( ));
+    BOOST_REQUIRE(file.is_open( ));
+    file << std::string(size, 'x');
+}
+
+std::size_t CountFiles( )
+{
+    std::size_t result = 0;
+    using boost::filesystem::directory_iterator;
+    for (directory_iterator i(FOLDER); directory_iterator( ) != i; ++i)
+    {
+        ++result;
+    }
+
+    return result;
+}
+
+std::string ReadFile(const boost::filesystem::path &path)
+{
+    std::ifstream file(path.string( ).c_str( ), std::ios::binary);
+    BOOST_REQUIRE(file.is_open( ));
+    return std::string(std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>( ));
+}
+
+std::size_t CountLogFiles( )
+{
+    const Path PATH(IndexedPath( ));
+    std::size_t result = 0;
+    using boost::filesystem::directory_iterator;
+    for (directory_iterator i(FOLDER); directory_iterator( ) != i; ++i)
+    {
+        std::string key;
+        if (PATH.Parse(i->path( ), key))
+        {
+            ++result;
+        }
+    }
+
+    return result;
+}
+
+bool WaitForRecycling(Retention &retention,
+                      const boost::filesystem::path &path)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        if (retention.Recycle(path))
+        {
+            return true;
+        }
+
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    return false;
+}
+
+bool WaitForRemoval(const boost::filesystem::path &path)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        if (!boost::filesystem::exists(path))
+        {
+            return true;
+        }
+
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,235 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for Router
+ */
+
+#include "myrrh/log/policy/Router.hpp"
+#include "myrrh/log/policy/AsyncPolicy.hpp"
+#include "myrrh/log/policy/Creator.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
+#include "myrrh/log/policy/Stream.hpp"
+#include "myrrh/file/Eraser.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/filesystem/operations.hpp"
+#include "boost/test/auto_unit_test.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace myrrh::log;
+using namespace myrrh::log::policy;
+
+// Local helper declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("routerTestFiles");
+
+PolicyPtr NewFilePolicy(const std::string &name);
+std::string GetFileContent(const std::string &name);
+
+/**
+ * Collects the written texts and the addresses they were passed in
+ */
+class CollectingPolicy : public Policy
+{
+public:
+
+    explicit CollectingPolicy(std::streamsize result = 0);
+
+    std::vector<std::string> texts;
+    std::vector<const std::string *> addresses;
+    std::vector<RestrictionPtr> restrictions;
+
+private:
+
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    /// The result of writing, or 0 for the size of the text
+    const std::streamsize RESULT_;
+};
+
+typedef boost::shared_ptr<CollectingPolicy> CollectingPolicyPtr;
+
+}
+
+BOOST_AUTO_TEST_CASE(TextsAreWrittenToRoutesOfTheirLevel)
+{
+    CollectingPolicyPtr errors(new CollectingPolicy);
+    CollectingPolicyPtr all(new CollectingPolicy);
+    CollectingPolicyPtr traces(new CollectingPolicy);
+    Router router;
+    router.AddRoute(errors, ERROR);
+    router.AddRoute(all);
+    router.AddRoute(traces, TRACE, TRACE);
+
+    BOOST_CHECK_EQUAL(2, router.WriteWithLevel("c\n", CRIT));
+    BOOST_CHECK_EQUAL(2, router.WriteWithLevel("w\n", WARN));
+    BOOST_CHECK_EQUAL(2, router.WriteWithLevel("t\n", TRACE));
+
+    BOOST_REQUIRE_EQUAL(1u, errors->texts.size( ));
+    BOOST_CHECK_EQUAL("c\n", errors->texts[0]);
+    BOOST_CHECK_EQUAL(3u, all->texts.size( ));
+    BOOST_REQUIRE_EQUAL(1u, traces->texts.size( ));
+    BOOST_CHECK_EQUAL("t\n", traces->texts[0]);
+}
+
+BOOST_AUTO_TEST_CASE(SameTextIsPassedToEachDestination)
+{
+    CollectingPolicyPtr first(new CollectingPolicy);
+    CollectingPolicyPtr second(new CollectingPolicy);
+    Router router;
+    router.AddRoute(first);
+    router.AddRoute(second);
+
+    const std::string TEXT("text\n");
+    BOOST_CHECK_EQUAL(5, router.WriteWithLevel(TEXT, INFO));
+
+    BOOST_REQUIRE_EQUAL(1u, first->addresses.size( ));
+    BOOST_REQUIRE_EQUAL(1u, second->addresses.size( ));
+    BOOST_CHECK(&TEXT == first->addresses[0]);
+    BOOST_CHECK(&TEXT == second->addresses[0]);
+}
+
+BOOST_AUTO_TEST_CASE(TextsWithoutLevelAreWrittenToAllRoutes)
+{
+    CollectingPolicyPtr errors(new CollectingPolicy);
+    CollectingPolicyPtr traces(new CollectingPolicy);
+    Router router;
+    router.AddRoute(errors, ERROR);
+    router.AddRoute(traces, TRACE, TRACE);
+
+    BOOST_CHECK_EQUAL(5, router.Write("text\n"));
+
+    BOOST_CHECK_EQUAL(1u, errors->texts.size( ));
+    BOOST_CHECK_EQUAL(1u, traces->texts.size( ));
+}
+
+BOOST_AUTO_TEST_CASE(FailingDestinationIsReported)
+{
+    CollectingPolicyPtr failing(new CollectingPolicy(-1));
+    CollectingPolicyPtr working(new CollectingPolicy);
+    Router router;
+    router.AddRoute(failing, ERROR);
+    router.AddRoute(working);
+
+    BOOST_CHECK_EQUAL(-1, router.WriteWithLevel("text\n", ERROR));
+    BOOST_CHECK_EQUAL(1u, working->texts.size( ));
+    BOOST_CHECK_EQUAL(5, router.WriteWithLevel("text\n", INFO));
+}
+
+BOOST_AUTO_TEST_CASE(RestrictionIsAddedToEachDestination)
+{
+    CollectingPolicyPtr errors(new CollectingPolicy);
+    CollectingPolicyPtr all(new CollectingPolicy);
+    Router router;
+    router.AddRoute(errors, ERROR);
+    router.AddRoute(all);
+
+    const RestrictionPtr RESTRICTION(new SizeRestriction(10));
+    router.AddRestriction(RESTRICTION);
+
+    BOOST_REQUIRE_EQUAL(1u, errors->restrictions.size( ));
+    BOOST_CHECK(RESTRICTION == errors->restrictions[0]);
+    BOOST_REQUIRE_EQUAL(1u, all->restrictions.size( ));
+    BOOST_CHECK(RESTRICTION == all->restrictions[0]);
+}
+
+BOOST_AUTO_TEST_CASE(StreamPassesLevelToRouter)
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        boost::shared_ptr<Router> router(new Router);
+        router->AddRoute(NewFilePolicy("errors.log"), ERROR);
+        router->AddRoute(NewFilePolicy("all.log"));
+        Stream stream(router);
+
+        stream.SetVerbosity(ERROR);
+        stream << "error " << 1 << std::endl;
+        stream.SetVerbosity(INFO);
+        stream << "info " << 2 << std::endl;
+        stream << "no level" << std::endl;
+    }
+
+    BOOST_CHECK_EQUAL("error 1\nno level\n", GetFileContent("errors.log"));
+    BOOST_CHECK_EQUAL("error 1\ninfo 2\nno level\n",
+                      GetFileContent("all.log"));
+}
+
+BOOST_AUTO_TEST_CASE(AsyncPolicyKeepsLevels)
+{
+    CollectingPolicyPtr errors(new CollectingPolicy);
+    CollectingPolicyPtr all(new CollectingPolicy);
+    boost::shared_ptr<Router> router(new Router);
+    router->AddRoute(errors, ERROR);
+    router->AddRoute(all);
+    {
+        AsyncPolicy policy(router);
+        BOOST_CHECK_EQUAL(2, policy.WriteWithLevel("e\n", ERROR));
+        BOOST_CHECK_EQUAL(2, policy.WriteWithLevel("i\n", INFO));
+        BOOST_CHECK_EQUAL(2, policy.Write("n\n"));
+    }
+
+    BOOST_REQUIRE_EQUAL(2u, errors->texts.size( ));
+    BOOST_CHECK_EQUAL("e\n", errors->texts[0]);
+    BOOST_CHECK_EQUAL("n\n", errors->texts[1]);
+    BOOST_CHECK_EQUAL(3u, all->texts.size( ));
+}
+
+// Local helper implementations
+
+namespace
+{
+
+PolicyPtr NewFilePolicy(const std::string &name)
+{
+    Path path(FOLDER);
+    path += name;
+    InitialOpenerPtr opener(new Creator);
+    return PolicyPtr(new Policy(path, opener, opener));
+}
+
+std::string GetFileContent(const std::string &name)
+{
+    std::ifstream file((FOLDER / name).string( ).c_str( ));
+    BOOST_REQUIRE(file.is_open( ));
+
+    std::ostringstream stream;
+    stream << file.rdbuf( );
+    return stream.str( );
+}
+
+CollectingPolicy::CollectingPolicy(std::streamsize result) :
+    RESULT_(result)
+{
+}
+
+void CollectingPolicy::DoAddRestriction(RestrictionPtr restriction)
+{
+    restrictions.push_back(restriction);
+}
+
+std::streamsize CollectingPolicy::DoWrite(const std::string &toWrite)
+{
+    texts.push_back(toWrite);
+    addresses.push_back(&toWrite);
+    return RESULT_ ? RESULT_ : static_cast<std::streamsize>(toWrite.size( ));
+}
+
+}
@@ -0,0 +1,272 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for ShardedPolicy
+ */
+
+#include "myrrh/log/policy/ShardedPolicy.hpp"
+#include "myrrh/log/policy/Appender.hpp"
+#include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/file/Eraser.hpp"
+#include "myrrh/file/Merge.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#define DISABLE_COPY_CONSTRUCTOR_COULD_NOT_BE_GENERATED
+#define DISABLE_ASSIGNMENT_OPERATOR_COULD_NOT_BE_GENERATED
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/filesystem/operations.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/test/auto_unit_test.hpp"
+#include "boost/thread/thread.hpp"
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <vector>
+
+using namespace myrrh::log::policy;
+
+// Local helper declarations
+
+namespace
+{
+
+const boost::filesystem::path FOLDER("shardTestFiles");
+const std::size_t THREADS = 4;
+const std::size_t LINES = 200;
+
+PolicyPtr NewShard( );
+
+void WriteLines(Policy &policy, std::size_t thread);
+
+myrrh::file::PathStore ShardFiles( );
+
+/// Returns the line count of the given text
+std::size_t CountLines(const std::string &text);
+
+boost::filesystem::path CreateFolder( );
+
+/**
+ * Counts the shards that have not been destroyed
+ */
+class CountedShard : public Policy
+{
+public:
+    explicit CountedShard(std::atomic<int> &live);
+    virtual ~CountedShard( );
+private:
+    virtual void DoAddRestriction(RestrictionPtr restriction);
+    virtual std::streamsize DoWrite(const std::string &toWrite);
+
+    std::atomic<int> &live_;
+};
+
+class TestCase
+{
+public:
+    TestCase( );
+private:
+    myrrh::file::Eraser eraser_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(SingleThreadUsesOneShard)
+{
+    TestCase testCase;
+    ShardedPolicy policy(NewShard);
+    const std::string TEXT("text\n");
+    BOOST_CHECK_EQUAL(static_cast<std::streamsize>(TEXT.size( )),
+                      policy.Write(TEXT));
+    BOOST_CHECK_EQUAL(static_cast<std::streamsize>(TEXT.size( )),
+                      policy.Write(TEXT));
+    BOOST_CHECK_EQUAL(1u, ShardFiles( ).size( ));
+}
+
+BOOST_AUTO_TEST_CASE(FailingShardIsReported)
+{
+    ShardedPolicy policy([]( ) { return PolicyPtr( ); });
+    BOOST_CHECK_EQUAL(-1, policy.Write("text\n"));
+}
+
+BOOST_AUTO_TEST_CASE(ThreadsAreMergedInOrder)
+{
+    TestCase testCase;
+    {
+        ShardedPolicy policy(NewShard);
+        std::vector<boost::shared_ptr<boost::thread> > threads;
+        for (std::size_t i = 0; i < THREADS; ++i)
+        {
+            threads.push_back(boost::shared_ptr<boost::thread>(
+                new boost::thread(WriteLines, boost::ref(policy), i)));
+        }
+
+        for (std::size_t i = 0; i < THREADS; ++i)
+        {
+            threads[i]->join( );
+        }
+    }
+
+    const myrrh::file::PathStore FILES(ShardFiles( ));
+    BOOST_CHECK_EQUAL(THREADS, FILES.size( ));
+
+    std::ostringstream output;
+    myrrh::file::Merge merge(FILES, SequenceKey( ));
+    merge(output);
+
+    const std::string RESULT(output.str( ));
+    BOOST_CHECK_EQUAL(THREADS * LINES * 2, CountLines(RESULT));
+
+    std::istringstream stream(RESULT);
+    std::string line;
+    std::string previous;
+    std::size_t records = 0;
+    while (std::getline(stream, line))
+    {
+        const std::size_t KEY = SequenceKey( )(line);
+        if (!KEY)
+        {
+            BOOST_CHECK_EQUAL("continues", line);
+            continue;
+        }
+
+        BOOST_CHECK(previous < line.substr(0, KEY));
+        previous = line.substr(0, KEY);
+        ++records;
+    }
+
+    BOOST_CHECK_EQUAL(THREADS * LINES, records);
+}
+
+BOOST_AUTO_TEST_CASE(ShardIsReleasedWhenThreadExits)
+{
+    std::atomic<int> created(0);
+    std::atomic<int> live(0);
+    ShardedPolicy policy([&]( )
+    {
+        ++created;
+        return PolicyPtr(new CountedShard(live));
+    });
+
+    // The threads may get the same id, but not the same shard
+    for (int i = 0; i < 3; ++i)
+    {
+        boost::thread writer([&]( ) { policy.Write("text\n"); });
+        writer.join( );
+        BOOST_CHECK_EQUAL(0, live);
+    }
+
+    BOOST_CHECK_EQUAL(3, created);
+}
+
+BOOST_AUTO_TEST_CASE(ReusedThreadIdKeepsEarlierLines)
+{
+    TestCase testCase;
+
+    // The shards of the same thread id get the same file, as if the id was
+    // given to a new thread
+    {
+        ShardedPolicy first(NewShard);
+        first.Write("first\n");
+    }
+
+    {
+        ShardedPolicy second(NewShard);
+        second.Write("second\n");
+    }
+
+    const myrrh::file::PathStore FILES(ShardFiles( ));
+    BOOST_REQUIRE_EQUAL(1u, FILES.size( ));
+
+    std::ostringstream output;
+    myrrh::file::Merge merge(FILES, SequenceKey( ));
+    merge(output);
+    BOOST_CHECK_EQUAL(2u, CountLines(output.str( )));
+}
+
+BOOST_AUTO_TEST_CASE(SequenceKeyRecognizesPrefix)
+{
+    const std::string PREFIX("00000000000000000042 ");
+    BOOST_CHECK_EQUAL(ShardedPolicy::PREFIX_SIZE, PREFIX.size( ));
+    BOOST_CHECK_EQUAL(ShardedPolicy::PREFIX_SIZE - 1,
+                      SequenceKey( )(PREFIX + "text"));
+    BOOST_CHECK_EQUAL(0u, SequenceKey( )("text"));
+    BOOST_CHECK_EQUAL(0u, SequenceKey( )("0000000000000000004x text"));
+}
+
+// Local helper implementations
+
+namespace
+{
+
+PolicyPtr NewShard( )
+{
+    Path path;
+    path += FOLDER.string( ) + "/shard" + ThreadId( ) + ".log";
+    InitialOpenerPtr opener(new Appender);
+    return PolicyPtr(new Policy(path, opener, opener));
+}
+
+void WriteLines(Policy &policy, std::size_t thread)
+{
+    const std::string TEXT(boost::lexical_cast<std::string>(thread));
+    for (std::size_t i = 0; i < LINES; ++i)
+    {
+        policy.Write(TEXT + "\ncontinues\n");
+    }
+}
+
+myrrh::file::PathStore ShardFiles( )
+{
+    return myrrh::file::MatchFiles(FOLDER,
+        myrrh::file::ExpressionMatcher(boost::regex("shard.*\\.log")));
+}
+
+std::size_t CountLines(const std::string &text)
+{
+    return static_cast<std::size_t>(std::count(text.begin( ), text.end( ),
+                                               '\n'));
+}
+
+CountedShard::CountedShard(std::atomic<int> &live) :
+    live_(live)
+{
+    ++live_;
+}
+
+CountedShard::~CountedShard( )
+{
+    --live_;
+}
+
+void CountedShard::DoAddRestriction(RestrictionPtr)
+{
+}
+
+std::streamsize CountedShard::DoWrite(const std::string &toWrite)
+{
+    return static_cast<std::streamsize>(toWrite.size( ));
+}
+
+TestCase::TestCase( ) :
+    eraser_(CreateFolder( ))
+{
+}
+
+boost::filesystem::path CreateFolder( )
+{
+    boost::filesystem::create_directory(FOLDER);
+    return FOLDER;
+}
+
+}
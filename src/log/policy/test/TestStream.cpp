@@ -13,6 +13,8 @@
 #include "myrrh/log/policy/Policy.hpp"
 #include "myrrh/log/policy/Creator.hpp"
 #include "myrrh/log/policy/Path.hpp"
+#include "myrrh/log/policy/PathPart.hpp"
+#include "myrrh/log/policy/Restriction.hpp"
 
 #include "myrrh/file/Eraser.hpp"
 
@@ -21,26 +23,47 @@
 
 #include "boost/test/unit_test.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/thread/thread.hpp"
 
 #ifdef WIN32
 #pragma warning(pop)
 #endif
 
+#include <cstring>
+
 typedef boost::unit_test::test_suite TestSuite;
 
 using namespace myrrh::log::policy;
 
 // Test case function declarations
 void TestStream( );
+void TestReservingRoom( );
+void TestWritingIntoFileBuffer( );
+void TestRotationWithFileBuffer( );
+void TestTextLongerThanFileBuffer( );
+void TestEmptyTextReleasesRoom( );
 
 // Helper function declarations
 std::string GetFileContent(const std::string &path);
 
+/**
+ * Returns a policy for files log<index>.txt in the folder, written through
+ * a buffer of the given size
+ */
+PolicyPtr BufferedPolicy(const std::string &folder, std::size_t bufferSize);
+
+const std::string FOLDER("streamTestFiles");
+
 // Use automatic test initialization
 TestSuite *init_unit_test_suite(int, char *[])
 {
     TestSuite* test = BOOST_TEST_SUITE("Test suite for Stream");
     test->add(BOOST_TEST_CASE(TestStream));
+    test->add(BOOST_TEST_CASE(TestReservingRoom));
+    test->add(BOOST_TEST_CASE(TestWritingIntoFileBuffer));
+    test->add(BOOST_TEST_CASE(TestRotationWithFileBuffer));
+    test->add(BOOST_TEST_CASE(TestTextLongerThanFileBuffer));
+    test->add(BOOST_TEST_CASE(TestEmptyTextReleasesRoom));
     return test;
 }
 
@@ -69,6 +92,108 @@ void TestStream( )
     */
 }
 
+void TestReservingRoom( )
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        PolicyPtr unbuffered(BufferedPolicy(FOLDER, 0));
+        std::size_t available = 1;
+        BOOST_CHECK(!unbuffered->Reserve(10, available));
+        BOOST_CHECK_EQUAL(0u, available);
+    }
+
+    {
+        PolicyPtr policy(BufferedPolicy(FOLDER, 64));
+        std::size_t available = 0;
+        char *room = policy->Reserve(10, available);
+        BOOST_REQUIRE(room);
+        BOOST_CHECK_EQUAL(64u, available);
+
+        std::memcpy(room, "abc\n", 4);
+        BOOST_CHECK_EQUAL(4, policy->Commit(4));
+        BOOST_CHECK_EQUAL(5, policy->Write("defg\n"));
+    }
+
+    BOOST_CHECK_EQUAL("abc\ndefg\n", GetFileContent(FOLDER + "/log1.txt"));
+}
+
+void TestWritingIntoFileBuffer( )
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        PolicyPtr policy(BufferedPolicy(FOLDER, 1024));
+        Stream stream(policy);
+
+        stream << "line " << 1 << std::endl;
+        stream << 'x' << "line " << 2 << std::endl;
+        BOOST_CHECK(stream.good( ));
+    }
+
+    BOOST_CHECK_EQUAL("line 1\nxline 2\n",
+                      GetFileContent(FOLDER + "/log1.txt"));
+}
+
+void TestRotationWithFileBuffer( )
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    {
+        PolicyPtr policy(BufferedPolicy(FOLDER, 1024));
+        policy->AddRestriction(RestrictionPtr(new SizeRestriction(10)));
+        Stream stream(policy);
+
+        for (int i = 1; i <= 3; ++i)
+        {
+            stream << "line " << i << std::endl;
+        }
+
+        BOOST_CHECK(stream.good( ));
+    }
+
+    BOOST_CHECK_EQUAL("line 1\n", GetFileContent(FOLDER + "/log1.txt"));
+    BOOST_CHECK_EQUAL("line 2\n", GetFileContent(FOLDER + "/log2.txt"));
+    BOOST_CHECK_EQUAL("line 3\n", GetFileContent(FOLDER + "/log3.txt"));
+}
+
+void TestTextLongerThanFileBuffer( )
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    const std::string LONG(100, 'x');
+    {
+        PolicyPtr policy(BufferedPolicy(FOLDER, 16));
+        Stream stream(policy);
+
+        stream << "short" << std::endl;
+        stream << "start " << LONG << ' ' << 5 << std::endl;
+        stream << "short again" << std::endl;
+        BOOST_CHECK(stream.good( ));
+    }
+
+    BOOST_CHECK_EQUAL("short\nstart " + LONG + " 5\nshort again\n",
+                      GetFileContent(FOLDER + "/log1.txt"));
+}
+
+void TestEmptyTextReleasesRoom( )
+{
+    myrrh::file::Eraser eraser(FOLDER);
+    Path path((boost::filesystem::path(FOLDER)));
+    path += "log" + Index( ) + ".txt";
+
+    boost::shared_ptr<Creator> opener(new Creator);
+    opener->SetBufferSize(1024);
+    opener->SetDurability(Opener::BUFFERED, 0, 50);
+    PolicyPtr policy(new Policy(path, opener, opener));
+    Stream stream(policy);
+
+    stream << "line" << std::endl;
+    stream.write("", 0);
+    stream << "" << std::flush;
+    BOOST_CHECK(stream.good( ));
+
+    // The timer writes the buffer only after the room has been released
+    boost::this_thread::sleep(boost::posix_time::milliseconds(300));
+    BOOST_CHECK_EQUAL("line\n", GetFileContent(FOLDER + "/log1.txt"));
+}
+
 std::string GetFileContent(const std::string &path)
 {
     std::ifstream file(path.c_str( ));
@@ -79,3 +204,13 @@ std::string GetFileContent(const std::string &path)
 
     return stream.str( );
 }
+
+PolicyPtr BufferedPolicy(const std::string &folder, std::size_t bufferSize)
+{
+    Path path((boost::filesystem::path(folder)));
+    path += "log" + Index( ) + ".txt";
+
+    boost::shared_ptr<Creator> opener(new Creator);
+    opener->SetBufferSize(bufferSize);
+    return PolicyPtr(new Policy(path, opener, opener));
+}
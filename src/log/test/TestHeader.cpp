@@ -12,6 +12,7 @@
  * -Given verbosity id gets written to output
  * -A valid timestamp gets written to output
  * -Same header object can write to different streams
+ * -TimestampKey recognizes the written timestamps
  *
  * The following tests are not made, because the functionality is already
  * tested elsewhere:
@@ -41,6 +42,7 @@ using namespace myrrh::util;
 void WriteOneLine( );
 void WriteSeveralLines( );
 void UseSameHeaderForDifferentStreams( );
+void TimestampKeyFindsTimestamp( );
 
 class TestCase
 {
@@ -67,6 +69,7 @@ TestSuite *init_unit_test_suite(int, char *[])
     test->add(BOOST_TEST_CASE(WriteOneLine));
     test->add(BOOST_TEST_CASE(WriteSeveralLines));
     test->add(BOOST_TEST_CASE(UseSameHeaderForDifferentStreams));
+    test->add(BOOST_TEST_CASE(TimestampKeyFindsTimestamp));
 
     return test;
 }
@@ -167,3 +170,18 @@ void UseSameHeaderForDifferentStreams( )
     BOOST_CHECK_EQUAL(FIRST_SIZE, EXPECTED_SIZE);
     BOOST_CHECK_EQUAL(SECOND_SIZE, EXPECTED_SIZE);
 }
+
+void TimestampKeyFindsTimestamp( )
+{
+    TimestampHeader header;
+    std::ostringstream stream;
+    header.Write(stream, '-');
+    const std::string HEADER(stream.str( ));
+
+    const std::string TIMESTAMP("1234.12.12 12:12:12.123456");
+    BOOST_CHECK_EQUAL(TIMESTAMP.size( ), TimestampKey( )(HEADER + "text"));
+    BOOST_CHECK_EQUAL(TIMESTAMP.size( ), TimestampKey( )(TIMESTAMP));
+    BOOST_CHECK_EQUAL(0u, TimestampKey( )("text"));
+    BOOST_CHECK_EQUAL(0u, TimestampKey( )(TIMESTAMP.substr(1)));
+    BOOST_CHECK_EQUAL(0u, TimestampKey( )("1234.12.12 12:12:12:123456"));
+}
@@ -33,6 +33,15 @@
  * -Writing from several threads at the same time.
  * -Writing fails
  * -Use of floating point number presentation manipulators
+ * -Backtrace lines are written only once an error occurs
+ * -Backtrace lines are written only to targets that did not receive them
+ * -Backtrace is no longer used once its guard is released
+ * -Repeated lines are collapsed into a summary
+ * -Repeated lines are written again once the repeat window has passed
+ * -The pending summary is written when the output guard is released
+ * -Lines with equal hashes but different payloads are not repeats
+ * -The verbosity level is told to the targets that implement VerbosityAware
+ * -Repeat summaries are written with the level of the latest repeat
  *
  * The following situations are not tested:
  * -Setting verbosity level to illegal value (compiler should take care of this
@@ -42,6 +51,8 @@
  */
 
 #include "myrrh/log/Log.hpp"
+#include "myrrh/log/RepeatFilter.hpp"
+#include "myrrh/log/VerbosityAware.hpp"
 #include "myrrh/util/BufferedStream.hpp"
 #include "myrrh/file/Temporary.hpp"
 #include "myrrh/data/test/Files.hpp"
@@ -99,6 +110,15 @@ void WritingFails( );
 void UseManipulators( );
 void WritingFromContendingThreads( );
 void SimultaneousWriting( );
+void BacktraceWrittenOnError( );
+void BacktraceWrittenToMissingTargets( );
+void BacktraceGuardRelease( );
+void RepeatsCollapsed( );
+void RepeatWindowPassed( );
+void RepeatSummaryOnRelease( );
+void RepeatsComparedByContent( );
+void VerbosityToldToTargets( );
+void RepeatSummaryHasLevel( );
 
 // Declarations of helper functions
 Guards SetOutputStreams(const Ostreams &streams);
@@ -109,6 +129,7 @@ void StreamContainsOnlyOneLine(std::ostringstream &stream,
                                const std::string &expected);
 template <typename T>
 void WriteThreadTestLine(int currentCount, char id);
+void UseIdHeader( );
 
 class TestCase
 {
@@ -282,6 +303,15 @@ TestSuite *init_unit_test_suite(int, char *[])
     test->add(BOOST_TEST_CASE(UseManipulators));
     test->add(BOOST_TEST_CASE(WritingFromContendingThreads));
     test->add(BOOST_TEST_CASE(SimultaneousWriting));
+    test->add(BOOST_TEST_CASE(BacktraceWrittenOnError));
+    test->add(BOOST_TEST_CASE(BacktraceWrittenToMissingTargets));
+    test->add(BOOST_TEST_CASE(BacktraceGuardRelease));
+    test->add(BOOST_TEST_CASE(RepeatsCollapsed));
+    test->add(BOOST_TEST_CASE(RepeatWindowPassed));
+    test->add(BOOST_TEST_CASE(RepeatSummaryOnRelease));
+    test->add(BOOST_TEST_CASE(RepeatsComparedByContent));
+    test->add(BOOST_TEST_CASE(VerbosityToldToTargets));
+    test->add(BOOST_TEST_CASE(RepeatSummaryHasLevel));
 
     return test;
 }
@@ -971,6 +1001,196 @@ void SimultaneousWriting( )
                       " C Before Returned string After");
 }
 
+void BacktraceWrittenOnError( )
+{
+    TestCase testCase;
+    UseIdHeader( );
+    std::ostringstream stream;
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+    Log::OutputGuard backtrace(Log::Instance( ).AddBacktrace(3, DEBUG));
+
+    Debug( ) << "1";
+    Debug( ) << "2";
+    Info( ) << "3";
+    Debug( ) << "4";
+    Warn( ) << "5";
+
+    BOOST_CHECK_EQUAL("I3\nW5\n", stream.str( ));
+
+    Error( ) << "6";
+    BOOST_CHECK_EQUAL("I3\nW5\nD4\nE6\n", stream.str( ));
+
+    // The backtrace was emptied, so the lines are not written again
+    Error( ) << "7";
+    BOOST_CHECK_EQUAL("I3\nW5\nD4\nE6\nE7\n", stream.str( ));
+}
+
+void BacktraceWrittenToMissingTargets( )
+{
+    TestCase testCase;
+    UseIdHeader( );
+    std::ostringstream stream;
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+    std::ostringstream stream2;
+    Log::OutputGuard guard2(Log::Instance( ).AddOutputTarget(stream2, WARN));
+    Log::OutputGuard backtrace(Log::Instance( ).AddBacktrace(10, DEBUG,
+                                                             CRIT));
+
+    BOOST_CHECK(!Log::Instance( ).IsWritable(DEBUG));
+
+    Debug( ) << "1";
+    Info( ) << "2";
+    Error( ) << "3";
+    Critical( ) << "4";
+
+    BOOST_CHECK_EQUAL("I2\nE3\nD1\nC4\n", stream.str( ));
+    BOOST_CHECK_EQUAL("E3\nD1\nI2\nC4\n", stream2.str( ));
+}
+
+void BacktraceGuardRelease( )
+{
+    TestCase testCase;
+    UseIdHeader( );
+    std::ostringstream stream;
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+    Log::OutputGuard backtrace(Log::Instance( ).AddBacktrace(3, DEBUG));
+
+    Debug( ) << "1";
+    backtrace.reset( );
+    Debug( ) << "2";
+    Error( ) << "3";
+
+    BOOST_CHECK_EQUAL("E3\n", stream.str( ));
+}
+
+void RepeatsCollapsed( )
+{
+    TestCase testCase;
+    UseIdHeader( );
+    std::ostringstream stream;
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(
+        stream, TRACE, boost::posix_time::hours(1)));
+    std::ostringstream stream2;
+    Log::OutputGuard guard2(Log::Instance( ).AddOutputTarget(stream2));
+
+    Info( ) << "a";
+    Info( ) << "a";
+    Warn( ) << "a";
+    Info( ) << "b";
+    Info( ) << "a";
+
+    BOOST_CHECK_EQUAL("Ia\nWlast message repeated 2 times\nIb\nIa\n",
+                      stream.str( ));
+    BOOST_CHECK_EQUAL("Ia\nIa\nWa\nIb\nIa\n", stream2.str( ));
+}
+
+void RepeatWindowPassed( )
+{
+    TestCase testCase;
+    UseIdHeader( );
+    std::ostringstream stream;
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(
+        stream, TRACE, boost::posix_time::time_duration( )));
+
+    Info( ) << "a";
+    Info( ) << "a";
+
+    BOOST_CHECK_EQUAL("Ia\nIa\n", stream.str( ));
+}
+
+void RepeatSummaryOnRelease( )
+{
+    TestCase testCase;
+    UseIdHeader( );
+    std::ostringstream stream;
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(
+        stream, TRACE, boost::posix_time::hours(1)));
+
+    Info( ) << "a";
+    Info( ) << "a";
+    guard.reset( );
+    Info( ) << "a";
+
+    BOOST_CHECK_EQUAL("Ia\nIlast message repeated 1 times\n", stream.str( ));
+}
+
+void RepeatsComparedByContent( )
+{
+    RepeatFilter filter(boost::posix_time::hours(1));
+    const RepeatFilter::Time NOW(
+        boost::posix_time::microsec_clock::universal_time( ));
+    RepeatFilter::Summary summary;
+
+    // The same hash is given for different payloads, as if they collided
+    BOOST_CHECK(!filter.IsRepeat("Ia", 1, 42, INFO, NOW, summary));
+    BOOST_CHECK(!filter.IsRepeat("Ib", 1, 42, INFO, NOW, summary));
+    BOOST_CHECK(filter.IsRepeat("Wb", 1, 42, WARN, NOW, summary));
+    BOOST_CHECK(!filter.IsRepeat("Ic", 1, 42, INFO, NOW, summary));
+    BOOST_CHECK_EQUAL("Wlast message repeated 1 times", summary.line);
+    BOOST_CHECK_EQUAL(WARN, summary.verbosity);
+}
+
+void VerbosityToldToTargets( )
+{
+    struct LevelBuffer : public std::stringbuf, public VerbosityAware
+    {
+        virtual void SetVerbosity(VerbosityLevel verbosity)
+        {
+            levels.push_back(verbosity);
+        }
+
+        std::vector<VerbosityLevel> levels;
+    };
+
+    TestCase testCase;
+    UseIdHeader( );
+    LevelBuffer buffer;
+    std::ostream stream(&buffer);
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+
+    Error( ) << "a";
+    Info( ) << "b";
+
+    BOOST_CHECK_EQUAL("Ea\nIb\n", buffer.str( ));
+    BOOST_REQUIRE_EQUAL(2u, buffer.levels.size( ));
+    BOOST_CHECK_EQUAL(ERROR, buffer.levels[0]);
+    BOOST_CHECK_EQUAL(INFO, buffer.levels[1]);
+}
+
+void RepeatSummaryHasLevel( )
+{
+    struct LevelBuffer : public std::stringbuf, public VerbosityAware
+    {
+        virtual void SetVerbosity(VerbosityLevel verbosity)
+        {
+            levels.push_back(verbosity);
+        }
+
+        std::vector<VerbosityLevel> levels;
+    };
+
+    TestCase testCase;
+    UseIdHeader( );
+    LevelBuffer buffer;
+    std::ostream stream(&buffer);
+    Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(
+        stream, TRACE, boost::posix_time::hours(1)));
+
+    Info( ) << "a";
+    Warn( ) << "a";
+    Info( ) << "b";
+    Error( ) << "b";
+    guard.reset( );
+
+    BOOST_CHECK_EQUAL("Ia\nWlast message repeated 1 times\nIb\n"
+                      "Elast message repeated 1 times\n", buffer.str( ));
+    BOOST_REQUIRE_EQUAL(4u, buffer.levels.size( ));
+    BOOST_CHECK_EQUAL(INFO, buffer.levels[0]);
+    BOOST_CHECK_EQUAL(WARN, buffer.levels[1]);
+    BOOST_CHECK_EQUAL(INFO, buffer.levels[2]);
+    BOOST_CHECK_EQUAL(ERROR, buffer.levels[3]);
+}
+
 Guards SetOutputStreams(const Ostreams &streams)
 {
     return std::for_each(streams.begin( ), streams.end( ),
@@ -982,6 +1202,19 @@ int CurrentVerbosityToInt( )
     return static_cast<int>(Log::Instance( ).GetVerbosity( ));
 }
 
+void UseIdHeader( )
+{
+    struct IdHeader : public Header
+    {
+        virtual void Write(std::ostream &stream, char id)
+        {
+            stream << id;
+        }
+    };
+
+    Log::Instance( ).SetHeader(HeaderPtr(new IdHeader));
+}
+
 std::string RemoveTimestampHeader(const std::string &line)
 {
     std::string result(RemoveTimestamp(line));
@@ -0,0 +1,366 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for myrrh::log::SocketStream. A local
+ * socketpair or a socket bound into the running directory is used as the
+ * collector.
+ */
+
+#include "myrrh/log/SocketStream.hpp"
+#include "myrrh/log/Log.hpp"
+
+#define DISABLE_CONDITIONAL_EXPRESSION_IS_CONSTANT
+#include "myrrh/util/Preprocessor.hpp"
+
+#define BOOST_AUTO_TEST_MAIN
+#include "boost/filesystem/operations.hpp"
+#include "boost/lexical_cast.hpp"
+#include "boost/test/auto_unit_test.hpp"
+#include "boost/thread/thread.hpp"
+
+#include <cstring>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace myrrh::log;
+
+// Local helper declarations
+
+namespace
+{
+
+/// Longer than any of the waits in the tests should take
+const int TIMEOUT_MILLISECONDS = 5000;
+
+/**
+ * Owns both ends of a socketpair. The first one is given to SocketStream.
+ */
+class Pair
+{
+public:
+    explicit Pair(int type);
+    ~Pair( );
+    int Release( );
+    /// Receives what is available, or an empty string after a timeout
+    std::string Receive( );
+    void CloseCollector( );
+private:
+    int descriptors_[2];
+};
+
+/// Receives from the descriptor until the expected size has been reached
+std::string ReceiveAll(int descriptor, std::size_t size);
+
+/// Creates a datagram socket bound to the given path
+int BindCollector(const std::string &path);
+
+/// Creates a listening stream socket bound to the given path
+int ListenCollector(const std::string &path);
+
+/// Accepts a connection, or returns -1 after a timeout
+int AcceptCollector(int listener);
+
+bool WaitForDrops(const SocketStream &stream);
+
+}
+
+BOOST_AUTO_TEST_CASE(DatagramBatchedBySize)
+{
+    Pair pair(SOCK_DGRAM);
+    SocketStream stream(pair.Release( ), SocketBuffer::DATAGRAM, 6, 60000);
+
+    stream << "aa" << std::flush;
+    stream << "bb\n" << std::flush;
+    stream << "cc\n" << std::flush;
+
+    BOOST_CHECK_EQUAL("aa\nbb\n", pair.Receive( ));
+}
+
+BOOST_AUTO_TEST_CASE(DatagramSentAfterInterval)
+{
+    Pair pair(SOCK_DGRAM);
+    SocketStream stream(pair.Release( ), SocketBuffer::DATAGRAM, 4096, 10);
+
+    stream << "line" << std::endl;
+
+    BOOST_CHECK_EQUAL("line\n", pair.Receive( ));
+}
+
+BOOST_AUTO_TEST_CASE(StreamUsedAsLogTarget)
+{
+    struct NoHeader : public Header
+    {
+        virtual void Write(std::ostream &, char)
+        {
+        }
+    };
+
+    Pair pair(SOCK_STREAM);
+    std::string expected;
+    {
+        SocketStream stream(pair.Release( ), SocketBuffer::STREAM, 64, 10);
+        Log::Instance( ).SetHeader(HeaderPtr(new NoHeader));
+        Log::OutputGuard guard(Log::Instance( ).AddOutputTarget(stream));
+
+        for (int i = 0; i < 100; ++i)
+        {
+            Error( ) << "line " << i;
+            expected += "line " + boost::lexical_cast<std::string>(i) + "\n";
+        }
+
+        Log::Instance( ).SetHeader( );
+    }
+
+    BOOST_CHECK_EQUAL(expected, pair.Receive( ));
+}
+
+BOOST_AUTO_TEST_CASE(LinesDroppedWithoutCollector)
+{
+    Pair pair(SOCK_DGRAM);
+    SocketStream stream(pair.Release( ), SocketBuffer::DATAGRAM, 4096, 10);
+    pair.CloseCollector( );
+
+    stream << "line" << std::endl;
+
+    BOOST_CHECK(WaitForDrops(stream));
+}
+
+BOOST_AUTO_TEST_CASE(QueueLimitDropsLines)
+{
+    Pair pair(SOCK_DGRAM);
+    SocketStream stream(pair.Release( ), SocketBuffer::DATAGRAM, 4, 10);
+
+    // Nothing is received, so the datagrams fill the socket buffer and then
+    // either the queue or the waiting for the collector runs out
+    const std::size_t LINES = 100000;
+    for (std::size_t i = 0; i < LINES; ++i)
+    {
+        stream << "abc" << std::flush;
+    }
+
+    BOOST_CHECK(stream.Dropped( ) > 0);
+}
+
+BOOST_AUTO_TEST_CASE(ReconnectsToCollector)
+{
+    const std::string PATH("collector.sock");
+    boost::filesystem::remove(PATH);
+
+    SocketStream stream(PATH, SocketBuffer::DATAGRAM, 4096, 10);
+    stream << "early" << std::endl;
+
+    // Give the stream a chance to fail at least once
+    boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+
+    const int COLLECTOR = BindCollector(PATH);
+    BOOST_REQUIRE(COLLECTOR >= 0);
+
+    BOOST_CHECK_EQUAL("early\n", ReceiveAll(COLLECTOR, 6));
+    BOOST_CHECK_EQUAL(0u, stream.Dropped( ));
+
+    close(COLLECTOR);
+    boost::filesystem::remove(PATH);
+}
+
+BOOST_AUTO_TEST_CASE(StalledStreamResumesFromLineBoundary)
+{
+    const std::string PATH("stream.sock");
+    boost::filesystem::remove(PATH);
+    const int LISTENER = ListenCollector(PATH);
+    BOOST_REQUIRE(LISTENER >= 0);
+
+    // Much more than fits into the socket buffers, so the sending stalls
+    const std::size_t LINES = 20000;
+    std::string expected;
+    SocketStream stream(PATH, SocketBuffer::STREAM, 1024 * 1024, 50);
+    for (std::size_t i = 0; i < LINES; ++i)
+    {
+        std::string line(boost::lexical_cast<std::string>(i));
+        line.resize(99, '.');
+        stream << line << std::endl;
+        expected += line + '\n';
+    }
+
+    // Nothing is read for a while, so the stream gives up connections
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+
+    // Each connection continues from a line boundary after the previous one.
+    // The torn line at the end of a connection is dropped.
+    std::size_t position = 0;
+    std::size_t torn = 0;
+    while (position < expected.size( ))
+    {
+        const int CONNECTION = AcceptCollector(LISTENER);
+        BOOST_REQUIRE(CONNECTION >= 0);
+        const std::string RECEIVED(
+            ReceiveAll(CONNECTION, expected.size( ) - position));
+        close(CONNECTION);
+
+        BOOST_REQUIRE(expected.compare(position, RECEIVED.size( ),
+                                       RECEIVED) == 0);
+        position += RECEIVED.size( );
+        if (!RECEIVED.empty( ) && '\n' != RECEIVED[RECEIVED.size( ) - 1])
+        {
+            position = expected.find('\n', position) + 1;
+            ++torn;
+        }
+    }
+
+    BOOST_CHECK(torn > 0);
+    BOOST_CHECK_EQUAL(torn, stream.Dropped( ));
+
+    close(LISTENER);
+    boost::filesystem::remove(PATH);
+}
+
+// Local helper implementations
+
+namespace
+{
+
+Pair::Pair(int type)
+{
+    BOOST_REQUIRE(!socketpair(AF_UNIX, type, 0, descriptors_));
+}
+
+Pair::~Pair( )
+{
+    CloseCollector( );
+    if (descriptors_[0] >= 0)
+    {
+        close(descriptors_[0]);
+    }
+}
+
+int Pair::Release( )
+{
+    const int RESULT = descriptors_[0];
+    descriptors_[0] = -1;
+    return RESULT;
+}
+
+std::string Pair::Receive( )
+{
+    std::string result;
+    char buffer[4096];
+    pollfd readable = { descriptors_[1], POLLIN, 0 };
+    while (poll(&readable, 1,
+                result.empty( ) ? TIMEOUT_MILLISECONDS : 100) > 0)
+    {
+        const ssize_t SIZE = recv(descriptors_[1], buffer, sizeof(buffer), 0);
+        if (SIZE <= 0)
+        {
+            break;
+        }
+
+        result.append(buffer, static_cast<std::size_t>(SIZE));
+
+        // One datagram at a time
+        int type = 0;
+        socklen_t length = sizeof(type);
+        getsockopt(descriptors_[1], SOL_SOCKET, SO_TYPE, &type, &length);
+        if (SOCK_DGRAM == type)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+void Pair::CloseCollector( )
+{
+    if (descriptors_[1] >= 0)
+    {
+        close(descriptors_[1]);
+        descriptors_[1] = -1;
+    }
+}
+
+std::string ReceiveAll(int descriptor, std::size_t size)
+{
+    std::string result;
+    char buffer[4096];
+    pollfd readable = { descriptor, POLLIN, 0 };
+    while (result.size( ) < size &&
+           poll(&readable, 1, TIMEOUT_MILLISECONDS) > 0)
+    {
+        const ssize_t SIZE = recv(descriptor, buffer, sizeof(buffer), 0);
+        if (SIZE <= 0)
+        {
+            break;
+        }
+
+        result.append(buffer, static_cast<std::size_t>(SIZE));
+    }
+
+    return result;
+}
+
+int BindCollector(const std::string &path)
+{
+    const int DESCRIPTOR = socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str( ));
+    if (bind(DESCRIPTOR, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)))
+    {
+        close(DESCRIPTOR);
+        return -1;
+    }
+
+    return DESCRIPTOR;
+}
+
+int ListenCollector(const std::string &path)
+{
+    const int DESCRIPTOR = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path.c_str( ));
+    if (bind(DESCRIPTOR, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) || listen(DESCRIPTOR, 4))
+    {
+        close(DESCRIPTOR);
+        return -1;
+    }
+
+    return DESCRIPTOR;
+}
+
+int AcceptCollector(int listener)
+{
+    pollfd readable = { listener, POLLIN, 0 };
+    if (poll(&readable, 1, TIMEOUT_MILLISECONDS) <= 0)
+    {
+        return -1;
+    }
+
+    return accept(listener, 0, 0);
+}
+
+bool WaitForDrops(const SocketStream &stream)
+{
+    for (int i = 0; i < TIMEOUT_MILLISECONDS / 10; ++i)
+    {
+        if (stream.Dropped( ))
+        {
+            return true;
+        }
+
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,64 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the implementation of class myrrh::util::CoarseClock.
+ */
+
+#include "myrrh/util/CoarseClock.hpp"
+
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+#include "boost/integer_traits.hpp"
+
+#ifndef WIN32
+#include <time.h>
+#endif
+
+namespace myrrh
+{
+
+namespace util
+{
+
+// Local declarations
+
+namespace
+{
+
+const boost::posix_time::ptime EPOCH(boost::gregorian::date(1970, 1, 1));
+
+}
+
+// Class implementations
+
+const CoarseClock::Ticks CoarseClock::NEVER =
+    boost::integer_traits<CoarseClock::Ticks>::const_max;
+
+CoarseClock::Ticks CoarseClock::Now( )
+{
+#ifdef CLOCK_REALTIME_COARSE
+    timespec now;
+    if (!clock_gettime(CLOCK_REALTIME_COARSE, &now))
+    {
+        return static_cast<Ticks>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+    }
+#endif
+
+    return FromTime(boost::posix_time::microsec_clock::universal_time( ));
+}
+
+CoarseClock::Ticks CoarseClock::FromTime(const boost::posix_time::ptime &time)
+{
+    if (time.is_special( ))
+    {
+        return NEVER;
+    }
+
+    return (time - EPOCH).total_milliseconds( );
+}
+
+}
+
+}
@@ -0,0 +1,35 @@
+// Copyright 2007 Marko Raatikainen.
+// Distributed under the Boost Software License, Version 1.0. (See
+// accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+/**
+ * This file contains the unit test(s) for CoarseClock
+ */
+
+#include "myrrh/util/CoarseClock.hpp"
+
+#define BOOST_TEST_MODULE TestCoarseClock
+#include "boost/test/unit_test.hpp"
+#include "boost/date_time/posix_time/posix_time_types.hpp"
+
+using namespace myrrh::util;
+
+BOOST_AUTO_TEST_CASE(NowIsCloseToUniversalTime)
+{
+    const CoarseClock::Ticks PRECISE = CoarseClock::FromTime(
+        boost::posix_time::microsec_clock::universal_time( ));
+    const CoarseClock::Ticks COARSE = CoarseClock::Now( );
+
+    // The coarse clock may lag behind by a tick
+    BOOST_CHECK(COARSE > PRECISE - 100);
+    BOOST_CHECK(COARSE < PRECISE + 100);
+}
+
+BOOST_AUTO_TEST_CASE(ConvertingTime)
+{
+    using namespace boost::posix_time;
+    const ptime TIME(boost::gregorian::date(1970, 1, 2), seconds(1));
+    BOOST_CHECK_EQUAL(86401000, CoarseClock::FromTime(TIME));
+    BOOST_CHECK_EQUAL(CoarseClock::NEVER, CoarseClock::FromTime(ptime( )));
+}